@@ -42,6 +42,9 @@ Body::Body(moordyn::Log* log)
   : io::IO(log)
   , U(vec::Zero())
   , Ud(vec::Zero())
+  , rhs_memo(false)
+  , rhs_done(false)
+  , rhs_count(0)
 {
 #ifdef USE_VTK
 	defaultVTK();
@@ -383,8 +386,8 @@ Body::setState(vec6 pos, vec6 vel)
 	setDependentStates();
 }
 
-std::pair<vec6, vec6>
-Body::getStateDeriv()
+void
+Body::getStateDeriv(DBodyStateDt& drdt)
 {
 	if (type != FREE) {
 		LOGERR << "The body is not a free one" << endl;
@@ -397,22 +400,26 @@ Body::getStateDeriv()
 	doRHS();
 
 	// solve for accelerations in [M]{a}={f}
-	// For small systems, which are anyway larger than 4x4, we can use the
-	// ColPivHouseholderQR algorithm, which is working with every single
-	// matrix, retaining a very good accuracy, and becoming yet faster
-	// See:
-	// https://eigen.tuxfamily.org/dox/group__TutorialLinearAlgebra.html
-	Eigen::ColPivHouseholderQR<mat6> solver(M);
-	const vec6 acc = solver.solve(F6net);
+	// The mass matrix is symmetric positive definite, so a LDLT
+	// factorization is used, which is reused while the matrix does not
+	// change, see MassSolver
+	drdt.acc = M_solver.solve(M, F6net, env->MassTol);
 
 	// NOTE; is the above still valid even though it includes rotational DOFs?
-	return std::make_pair(v6, acc);
+	drdt.vel = v6;
 };
 
 //  this is the big function that calculates the forces on the body
 void
 Body::doRHS()
 {
+	// The forces and masses might be already computed on this time
+	// derivatives evaluation, see beginRHS()
+	if (rhs_memo && rhs_done)
+		return;
+	rhs_done = true;
+	rhs_count++;
+
 	// TODO: somewhere should check for extreme orientation changes, i.e.
 	// "winding" close to 2pi, and maybe prevent it if it risks compromising
 	// angle assumptions <<<<<<
@@ -36,6 +36,7 @@
 
 #include "Misc.hpp"
 #include "IO.hpp"
+#include "State.hpp"
 #include <vector>
 #include <utility>
 
@@ -127,6 +128,8 @@ class Body : public io::IO
 	/// starting mass and added mass matrix (6x6) of body without any rod
 	/// elements in inertital orientation
 	mat6 M0;
+	/// solver of the mass matrix, reusing the factorization
+	MassSolver<6> M_solver;
 
 	/// orientation matrix of body (rotation matrix that gets it to its current
 	/// orientation)
@@ -140,6 +143,13 @@ class Body : public io::IO
 	/// Pointer to moordyn::MoorDyn::outfileMain
 	ofstream* outfile;
 
+	/// Whether doRHS() is memoized, see beginRHS()
+	bool rhs_memo;
+	/// Whether doRHS() has been already evaluated since beginRHS()
+	bool rhs_done;
+	/// Number of doRHS() evaluations, for debugging purposes
+	unsigned long rhs_count;
+
 	/** @brief Types of bodies
 	 */
 	typedef enum
@@ -348,12 +358,12 @@ class Body : public io::IO
 	/** @brief calculate the forces and state derivatives of the body
 	 *
 	 * This function is only meant for free bodies
-	 * @param return The states derivatives, i.e. the velocity (first) and the
-	 * acceleration (second)
+	 * @param drdt The output states derivatives, i.e. the velocity and the
+	 * acceleration
 	 * @throw moordyn::invalid_value_error If the body is of type
 	 * moordyn::Body::FREE
 	 */
-	std::pair<vec6, vec6> getStateDeriv();
+	void getStateDeriv(DBodyStateDt& drdt);
 
 	/** @brief calculates the forces on the body
 	 * @throw moordyn::invalid_value_error If the body is of type
@@ -361,6 +371,26 @@ class Body : public io::IO
 	 */
 	void doRHS();
 
+	/** @brief Start a time derivatives evaluation
+	 *
+	 * The forces and masses are computed the first time doRHS() is called,
+	 * and then reused by the rest of consumers, until endRHS() is called
+	 */
+	inline void beginRHS()
+	{
+		rhs_memo = true;
+		rhs_done = false;
+	}
+
+	/** @brief Finish the time derivatives evaluation started with beginRHS()
+	 */
+	inline void endRHS() { rhs_memo = false; }
+
+	/** @brief Get the number of doRHS() evaluations so far
+	 * @return The number of evaluations
+	 */
+	inline unsigned long getRHSCount() const { return rhs_count; }
+
 	void Output(real time);
 
 	/** @brief Produce the packed data to be saved
@@ -47,6 +47,9 @@ namespace moordyn {
 
 Connection::Connection(moordyn::Log* log)
   : io::IO(log)
+  , rhs_memo(false)
+  , rhs_done(false)
+  , rhs_count(0)
   , WaterKin(0)
 {
 }
@@ -154,9 +157,10 @@ Connection::initialize()
 		// set water kinematics flag based on global wave and current settings
 		// (for now)
 		if ((env->WaveKin == 2) || (env->WaveKin == 3) || (env->WaveKin == 6) ||
-		    (env->Current == 1) || (env->Current == 2))
+		    (env->WaveKin == 7) || (env->Current == 1) || (env->Current == 2))
 			WaterKin = 2; // water kinematics to be considered through
-			              // precalculated global grid stored in Waves object
+			              // precalculated global grid or spectral components
+			              // stored in Waves object
 		else if ((env->WaveKin == 4) || (env->WaveKin == 5) ||
 		         (env->Current == 3) || (env->Current == 4))
 			WaterKin = 1; // water kinematics to be considered through
@@ -292,8 +296,8 @@ Connection::setState(vec pos, vec vel)
 		a.line->setEndKinematics(r, rd, a.end_point);
 }
 
-std::pair<vec, vec>
-Connection::getStateDeriv()
+void
+Connection::getStateDeriv(DConnStateDt& drdt)
 {
 	// the RHS is only relevant (there are only states to worry about) if it is
 	// a Connect type of Connection
@@ -308,10 +312,8 @@ Connection::getStateDeriv()
 	doRHS();
 
 	// solve for accelerations in [M]{a}={f}
-	const vec acc = M.inverse() * Fnet;
-
-	// update states
-	return std::make_pair(rd, acc);
+	drdt.vel = rd;
+	drdt.acc = M.inverse() * Fnet;
 };
 
 void
@@ -334,6 +336,13 @@ Connection::getNetForceAndMass(vec6& Fnet_out, mat6& M_out, vec rBody)
 moordyn::error_id
 Connection::doRHS()
 {
+	// The forces and masses might be already computed on this time
+	// derivatives evaluation, see beginRHS()
+	if (rhs_memo && rhs_done)
+		return MOORDYN_SUCCESS;
+	rhs_done = true;
+	rhs_count++;
+
 	// start with the Connection's own forces including buoyancy and weight, and
 	// its own mass
 	Fnet = conF + vec(0.0, 0.0, env->g * (conV * env->rho_w - conM));
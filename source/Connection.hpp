@@ -36,6 +36,7 @@
 
 #include "Misc.hpp"
 #include "IO.hpp"
+#include "State.hpp"
 #include <utility>
 
 #ifdef USE_VTK
@@ -151,6 +152,13 @@ class Connection : public io::IO
 	/// wave accelerations
 	vec Ud;
 
+	/// Whether doRHS() is memoized, see beginRHS()
+	bool rhs_memo;
+	/// Whether doRHS() has been already evaluated since beginRHS()
+	bool rhs_done;
+	/// Number of doRHS() evaluations, for debugging purposes
+	unsigned long rhs_count;
+
 	/**
 	 * @}
 	 */
@@ -338,11 +346,11 @@ class Connection : public io::IO
 	void setState(vec pos, vec vel);
 
 	/** @brief Calculate the forces and state derivatives of the connection
-	 * @param return The states derivatives, i.e. the velocity (first) and the
-	 * acceleration (second)
+	 * @param drdt The output states derivatives, i.e. the velocity and the
+	 * acceleration
 	 * @throws moordyn::invalid_value_error If it is not a FREE connection
 	 */
-	std::pair<vec, vec> getStateDeriv();
+	void getStateDeriv(DConnStateDt& drdt);
 
 	/** @brief Calculate the force and mass contributions of the connect on the
 	 * parent body
@@ -361,6 +369,26 @@ class Connection : public io::IO
 	 */
 	moordyn::error_id doRHS();
 
+	/** @brief Start a time derivatives evaluation
+	 *
+	 * The forces and masses are computed the first time doRHS() is called,
+	 * and then reused by the rest of consumers, until endRHS() is called
+	 */
+	inline void beginRHS()
+	{
+		rhs_memo = true;
+		rhs_done = false;
+	}
+
+	/** @brief Finish the time derivatives evaluation started with beginRHS()
+	 */
+	inline void endRHS() { rhs_memo = false; }
+
+	/** @brief Get the number of doRHS() evaluations so far
+	 * @return The number of evaluations
+	 */
+	inline unsigned long getRHSCount() const { return rhs_count; }
+
 	/** @brief Produce the packed data to be saved
 	 *
 	 * The produced data can be used afterwards to restore the saved information
@@ -431,6 +431,31 @@ IO::Serialize(const std::vector<mat6>& l)
 	return data;
 }
 
+std::vector<uint64_t>
+IO::Serialize(const vecN& l)
+{
+	std::vector<uint64_t> data;
+	const uint64_t n = l.size();
+	data.reserve(1 + l.size());
+	data.push_back(Serialize(n));
+	for (unsigned int i = 0; i < n; i++)
+		data.push_back(Serialize(l[i]));
+	return data;
+}
+
+std::vector<uint64_t>
+IO::Serialize(const vec3N& l)
+{
+	std::vector<uint64_t> data;
+	const uint64_t n = l.cols();
+	data.reserve(1 + 3 * n);
+	data.push_back(Serialize(n));
+	for (unsigned int i = 0; i < n; i++)
+		for (unsigned int j = 0; j < 3; j++)
+			data.push_back(Serialize(l(j, i)));
+	return data;
+}
+
 uint64_t*
 IO::Deserialize(const uint64_t* in, uint64_t& out)
 {
@@ -572,6 +597,29 @@ IO::Deserialize(const uint64_t* in, std::vector<mat6>& out)
 	return remaining;
 }
 
+uint64_t*
+IO::Deserialize(const uint64_t* in, vecN& out)
+{
+	uint64_t n;
+	uint64_t* remaining = Deserialize(in, n);
+	out.resize(n);
+	for (unsigned int i = 0; i < n; i++)
+		remaining = Deserialize(remaining, out[i]);
+	return remaining;
+}
+
+uint64_t*
+IO::Deserialize(const uint64_t* in, vec3N& out)
+{
+	uint64_t n;
+	uint64_t* remaining = Deserialize(in, n);
+	out.resize(3, n);
+	for (unsigned int i = 0; i < n; i++)
+		for (unsigned int j = 0; j < 3; j++)
+			remaining = Deserialize(remaining, out(j, i));
+	return remaining;
+}
+
 #ifdef USE_VTK
 vtkSmartPointer<vtkFloatArray>
 vtk_farray(const char* name, unsigned int dim, unsigned int len)
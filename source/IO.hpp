@@ -180,6 +180,25 @@ class IO : public LogUser
 	 */
 	std::vector<uint64_t> Serialize(const std::vector<mat6>& l);
 
+	/** @brief Pack a dense array of floating point numbers to make it
+	 * writtable
+	 *
+	 * The packed data is compatible with the one produced for a list of
+	 * floating point numbers
+	 * @param l The array
+	 * @return The packed array
+	 */
+	std::vector<uint64_t> Serialize(const vecN& l);
+
+	/** @brief Pack a dense array of 3D vectors to make it writtable
+	 *
+	 * The packed data is compatible with the one produced for a list of 3D
+	 * vectors
+	 * @param l The array
+	 * @return The packed array
+	 */
+	std::vector<uint64_t> Serialize(const vec3N& l);
+
 	/** @brief Pack a list of lists to make it writtable
 	 * This function might act recursively
 	 * @param l The list
@@ -282,6 +301,20 @@ class IO : public LogUser
 	 */
 	uint64_t* Deserialize(const uint64_t* in, std::vector<mat6>& out);
 
+	/** @brief Unpack a loaded dense array of floating point numbers
+	 * @param in The pointer to the next unread value
+	 * @param out The unpacked value
+	 * @return The new pointer to the remaining data to be read
+	 */
+	uint64_t* Deserialize(const uint64_t* in, vecN& out);
+
+	/** @brief Unpack a loaded dense array of 3D vectors
+	 * @param in The pointer to the next unread value
+	 * @param out The unpacked value
+	 * @return The new pointer to the remaining data to be read
+	 */
+	uint64_t* Deserialize(const uint64_t* in, vec3N& out);
+
 	/** @brief Unpack a loaded list of lists
 	 *
 	 * This function might works recursively
@@ -33,6 +33,7 @@
 #include "Waves.hpp"
 #include "QSlines.hpp"
 #include <tuple>
+#include <limits>
 
 #ifdef USE_VTK
 #include <vtkCellArray.h>
@@ -49,6 +50,14 @@ namespace moordyn {
 
 Line::Line(moordyn::Log* log)
   : io::IO(log)
+  , env(NULL)
+  , waves(NULL)
+  , fict_m(0.0)
+  , quasi_static(false)
+  , qs_HF(0.0)
+  , qs_VF(0.0)
+  , qs_fails(0)
+  , kernel(&Line::stateDerivKernel<LINE_GENERIC>)
 {
 }
 
@@ -66,7 +75,8 @@ Line::getNonlinearE(real l_stretched, real l_unstretched)
 		return 0.0;
 	}
 
-	real Yi = interp(stiffXs, stiffYs, Xi);
+	real Yi = stiff_curve.empty() ? interp(stiffXs, stiffYs, Xi)
+	                              : stiff_curve(Xi);
 
 	// calculate equivalent elasticity (since that's what MoorDyn works with)
 	return Yi / Xi;
@@ -79,7 +89,8 @@ Line::getNonlinearEI(real curv)
 		return EI;
 
 	real Xi = curv;
-	real Yi = interp(bstiffXs, bstiffYs, Xi);
+	real Yi = bstiff_curve.empty() ? interp(bstiffXs, bstiffYs, Xi)
+	                               : bstiff_curve(Xi);
 
 	// calculate equivalent bending stiffness (since that's what MoorDyn works
 	// with)
@@ -98,7 +109,7 @@ Line::getNonlinearC(real ld_stretched, real l_unstretched)
 	// find stress based on strain rate
 	if (dampXs[0] < 0) {
 		// first check if lookup table includes compressing
-		Yi = interp(dampXs, dampYs, Xi);
+		Yi = damp_curve.empty() ? interp(dampXs, dampYs, Xi) : damp_curve(Xi);
 	} else {
 		// if no compressing data given, we'll flip-mirror so stretching and
 		// compressing are same
@@ -107,7 +118,7 @@ Line::getNonlinearC(real ld_stretched, real l_unstretched)
 			Xsign = -1.0;
 			Xi = -Xi;
 		}
-		Yi = interp(dampXs, dampYs, Xi);
+		Yi = damp_curve.empty() ? interp(dampXs, dampYs, Xi) : damp_curve(Xi);
 		Yi *= Xsign;
 	}
 
@@ -116,13 +127,45 @@ Line::getNonlinearC(real ld_stretched, real l_unstretched)
 	return Yi / Xi;
 }
 
+void
+Line::resampleCurve(UniformCurve& curve,
+                    const std::vector<real>& x,
+                    const std::vector<real>& y,
+                    const char* name)
+{
+	if (env->CurvePoints <= 1)
+		return;
+
+	real err;
+	try {
+		err = curve.resample(x, y, env->CurvePoints);
+	} catch (moordyn::invalid_value_error& e) {
+		LOGERR << "Invalid " << name << " curve on Line " << number << ": "
+		       << e.what() << endl;
+		throw;
+	}
+	real ymax = 0.0;
+	for (auto v : y)
+		ymax = std::max(ymax, std::abs(v));
+	const real rel = ymax > 0.0 ? err / ymax : 0.0;
+	LOGMSG << "Line " << number << " " << name << " curve resampled on "
+	       << env->CurvePoints << " points, max. error = " << err << " ("
+	       << 100.0 * rel << "%)" << endl;
+	if (rel > 0.01) {
+		LOGWRN << "The " << name << " curve of Line " << number
+		       << " is poorly resampled, consider increasing CurvePoints"
+		       << endl;
+	}
+}
+
 void
 Line::setup(int number_in,
             LineProps* props,
             real UnstrLen_in,
             unsigned int NumSegs,
             shared_ptr<ofstream> outfile_pointer,
-            string channels_in)
+            string channels_in,
+            bool quasi_static_in)
 {
 	number = number_in;
 	// Note, this is a temporary value that will be processed depending on sign
@@ -173,37 +216,42 @@ Line::setup(int number_in,
 
 	// ------------------------- size vectors -------------------------
 
-	r.assign(N + 1, vec(0., 0., 0.));  // node positions [i][x/y/z]
-	rd.assign(N + 1, vec(0., 0., 0.)); // node positions [i][x/y/z]
-	q.assign(N + 1, vec(0., 0., 0.));  // unit tangent vectors for each node
-	qs.assign(N, vec(0., 0., 0.));     // unit tangent vectors for each segment
-	l.assign(N, 0.0);                  // line unstretched segment lengths
-	lstr.assign(N, 0.0);               // stretched lengths
-	ldstr.assign(N, 0.0);              // rate of stretch
-	Kurv.assign(N + 1, 0.0);           // curvatures at node points (1/m)
+	r.setZero(3, N + 1);  // node positions [x/y/z][i]
+	rd.setZero(3, N + 1); // node velocities [x/y/z][i]
+	q.setZero(3, N + 1);  // unit tangent vectors for each node
+	qs.setZero(3, N);     // unit tangent vectors for each segment
+	l.setZero(N);         // line unstretched segment lengths
+	lstr.setZero(N);      // stretched lengths
+	ldstr.setZero(N);     // rate of stretch
+	Kurv.setZero(N + 1);  // curvatures at node points (1/m)
 
 	M.assign(N + 1, mat()); // mass matrices (3x3) for each node
-	V.assign(N, 0.0);       // segment volume?
+	V.setZero(N);           // segment volume?
 
 	// forces
-	T.assign(N, vec(0., 0., 0.));        // segment tensions
-	Td.assign(N, vec(0., 0., 0.));       // segment damping forces
-	Bs.assign(N + 1, vec(0., 0., 0.));   // bending stiffness forces
-	W.assign(N + 1, vec(0., 0., 0.));    // node weights
-	Dp.assign(N + 1, vec(0., 0., 0.));   // node drag (transverse)
-	Dq.assign(N + 1, vec(0., 0., 0.));   // node drag (axial)
-	Ap.assign(N + 1, vec(0., 0., 0.));   // node added mass forcing (transverse)
-	Aq.assign(N + 1, vec(0., 0., 0.));   // node added mass forcing (axial)
-	B.assign(N + 1, vec(0., 0., 0.));    // node bottom contact force
-	Fnet.assign(N + 1, vec(0., 0., 0.)); // total force on node
+	T.setZero(3, N);        // segment tensions
+	Td.setZero(3, N);       // segment damping forces
+	Bs.setZero(3, N + 1);   // bending stiffness forces
+	W.setZero(3, N + 1);    // node weights
+	Dp.setZero(3, N + 1);   // node drag (transverse)
+	Dq.setZero(3, N + 1);   // node drag (axial)
+	Ap.setZero(3, N + 1);   // node added mass forcing (transverse)
+	Aq.setZero(3, N + 1);   // node added mass forcing (axial)
+	B.setZero(3, N + 1);    // node bottom contact force
+	Fnet.setZero(3, N + 1); // total force on node
 
 	// wave things
-	F.assign(N + 1, 0.0); // VOF scaler for each NODE (mean of two half adjacent
-	                      // segments) (1 = fully submerged, 0 = out of water)
-	zeta.assign(N + 1, 0.0);           // wave elevation above each node
-	PDyn.assign(N + 1, 0.0);           // dynamic pressure
-	U.assign(N + 1, vec(0., 0., 0.));  // wave velocities
-	Ud.assign(N + 1, vec(0., 0., 0.)); // wave accelerations
+	F.setZero(N + 1); // VOF scaler for each NODE (mean of two half adjacent
+	                  // segments) (1 = fully submerged, 0 = out of water)
+	zeta.setZero(N + 1);  // wave elevation above each node
+	PDyn.setZero(N + 1);  // dynamic pressure
+	U.setZero(3, N + 1);  // wave velocities
+	Ud.setZero(3, N + 1); // wave accelerations
+
+	// work arrays
+	seg_w.setZero(N);
+	node_w1.setZero(N + 1);
+	node_w2.setZero(N + 1);
 
 	// ensure end moments start at zero
 	endMomentA = vec(0., 0., 0.);
@@ -217,6 +265,8 @@ Line::setup(int number_in,
 	outfile = outfile_pointer.get(); // make outfile point to the right place
 	channels = channels_in;          // copy string of output channels to object
 
+	quasi_static = quasi_static_in;
+
 	LOGDBG << "   Set up Line " << number << ". " << endl;
 };
 
@@ -227,7 +277,7 @@ Line::setEnv(EnvCond* env_in, moordyn::Waves* waves_in)
 	waves = waves_in;
 }
 
-std::pair<std::vector<vec>, std::vector<vec>>
+std::pair<vec3N, vec3N>
 Line::initialize()
 {
 	LOGMSG << "  - Line" << number << ":" << endl
@@ -396,7 +446,7 @@ Line::initialize()
 	// so now we can proceed with figuring out the positions of the nodes along
 	// the line.
 
-	if (-env->WtrDpth > r[0][2]) {
+	if (-env->WtrDpth > r(2, 0)) {
 		LOGERR << "Water depth is shallower than Line " << number << " anchor"
 		       << endl;
 		throw moordyn::invalid_value_error("Invalid water depth");
@@ -405,10 +455,11 @@ Line::initialize()
 	// set water kinematics flag based on global wave and current settings
 	// (for now)
 	if ((env->WaveKin == WAVES_FFT_GRID) || (env->WaveKin == WAVES_GRID) ||
-	    (env->WaveKin == WAVES_KIN) || (env->Current == CURRENTS_STEADY_GRID) ||
+	    (env->WaveKin == WAVES_KIN) || (env->WaveKin == WAVES_SPECTRAL) ||
+	    (env->Current == CURRENTS_STEADY_GRID) ||
 	    (env->Current == CURRENTS_DYNAMIC_GRID)) {
 		// water kinematics to be considered through precalculated global grid
-		// stored in Waves object
+		// or spectral components stored in Waves object
 		WaterKin = WAVES_GRID;
 	} else if ((env->WaveKin == WAVES_FFT_NODE) ||
 	           (env->WaveKin == WAVES_NODE) ||
@@ -421,13 +472,13 @@ Line::initialize()
 		// no water kinematics to be considered (or to be set externally on each
 		// node)
 		WaterKin = WAVES_NONE;
-		U.assign(N + 1, vec(0.0, 0.0, 0.0));
-		Ud.assign(N + 1, vec(0.0, 0.0, 0.0));
-		F.assign(N + 1, 1.0);
+		U.setZero();
+		Ud.setZero();
+		F.setOnes();
 	}
 
 	// process unstretched line length input
-	vec dir = r[N] - r[0];
+	vec dir = r.col(N) - r.col(0);
 	if (UnstrLen < 0) {
 		// Interpret as scaler relative to distance between initial line end
 		// points (which have now been set by the relevant Connection objects)
@@ -451,6 +502,14 @@ Line::initialize()
 		E = stiffYs.back() / stiffXs.back();
 	}
 
+	// resample the nonlinear curves, so they are looked up in constant time
+	if (nEApoints > 0)
+		resampleCurve(stiff_curve, stiffXs, stiffYs, "EA");
+	if (nEIpoints > 0)
+		resampleCurve(bstiff_curve, bstiffXs, bstiffYs, "EI");
+	if (nCpoints > 0)
+		resampleCurve(damp_curve, dampXs, dampYs, "damping");
+
 	// process internal damping input
 	if (BAin < 0) {
 		// automatic internal damping option (if negative BA provided (stored as
@@ -468,12 +527,12 @@ Line::initialize()
 	// initialize line node positions as distributed linearly between the
 	// endpoints
 	for (unsigned int i = 1; i < N; i++) {
-		r[i] = r[0] + dir * (i / (real)N);
+		r.col(i) = r.col(0) + dir * (i / (real)N);
 	}
 
 	// if conditions are ideal, try to calculate initial line profile using
 	// catenary routine (from FAST v.7)
-	if (-r[0][2] == env->WtrDpth) {
+	if (-r(2, 0) == env->WtrDpth) {
 		real XF = dir(Eigen::seqN(0, 2)).norm(); // horizontal spread
 		real ZF = dir[2];
 		real LW = ((rho - env->rho_w) * A) * env->g;
@@ -496,8 +555,8 @@ Line::initialize()
 			vector<real> Zl(N + 1, 0.0);
 			vector<real> Te(N + 1, 0.0);
 
-			COSPhi = (r[N][0] - r[0][0]) / XF;
-			SINPhi = (r[N][1] - r[0][1]) / XF;
+			COSPhi = (r(0, N) - r(0, 0)) / XF;
+			SINPhi = (r(1, N) - r(1, 0)) / XF;
 
 			int success = Catenary(XF,
 			                       ZF,
@@ -522,7 +581,7 @@ Line::initialize()
 				       << number << endl;
 				for (unsigned int i = 1; i < N; i++) {
 					vec l(Xl[i] * COSPhi, Xl[i] * SINPhi, Zl[i]);
-					r[i] = r[0] + l;
+					r.col(i) = r.col(0) + l;
 				}
 			} else {
 				LOGWRN << "Catenary initial profile failed for Line " << number
@@ -531,37 +590,45 @@ Line::initialize()
 		}
 	}
 
+	// bind the derivatives kernel specialized for this line
+	kernel = getKernel(getFeatures());
+	if (quasi_static)
+		initializeQuasiStatic();
+
 	LOGMSG << "Initialized Line " << number << endl;
 
 	// also assign the resulting internal node positions to the integrator
-	// initial state vector! (velocities leave at 0)
-	std::vector<vec> vel(N - 1, vec::Zero());
-	return std::make_pair(vector_slice(r, 1, N - 1), vel);
+	// initial state vector! (velocities leave at 0). The quasi-static lines
+	// have no states
+	const unsigned int n = quasi_static ? 0 : N - 1;
+	const vec3N pos = r.middleCols(1, n);
+	const vec3N vel = vec3N::Zero(3, n);
+	return std::make_pair(pos, vel);
 };
 
 real
 Line::GetLineOutput(OutChanProps outChan)
 {
 	if (outChan.QType == PosX)
-		return r[outChan.NodeID][0];
+		return r(0, outChan.NodeID);
 	else if (outChan.QType == PosY)
-		return r[outChan.NodeID][1];
+		return r(1, outChan.NodeID);
 	else if (outChan.QType == PosZ)
-		return r[outChan.NodeID][2];
+		return r(2, outChan.NodeID);
 	else if (outChan.QType == VelX)
-		return rd[outChan.NodeID][0];
+		return rd(0, outChan.NodeID);
 	else if (outChan.QType == VelY)
-		return rd[outChan.NodeID][1];
+		return rd(1, outChan.NodeID);
 	else if (outChan.QType == VelZ)
-		return rd[outChan.NodeID][2];
+		return rd(2, outChan.NodeID);
 	else if (outChan.QType == Ten)
 		return getNodeTen(outChan.NodeID).norm();
 	else if (outChan.QType == FX)
-		return Fnet[outChan.NodeID][0];
+		return Fnet(0, outChan.NodeID);
 	else if (outChan.QType == FY)
-		return Fnet[outChan.NodeID][1];
+		return Fnet(1, outChan.NodeID);
 	else if (outChan.QType == FZ)
-		return Fnet[outChan.NodeID][2];
+		return Fnet(2, outChan.NodeID);
 	LOGWRN << "Unrecognized output channel " << outChan.QType << endl;
 	return 0.0;
 }
@@ -607,33 +674,184 @@ Line::storeWaterKin(real dt,
 };
 
 void
-Line::setState(std::vector<vec> pos, std::vector<vec> vel)
+Line::setState(const Eigen::Ref<const vec3N>& pos,
+               const Eigen::Ref<const vec3N>& vel)
 {
-	if ((pos.size() != N - 1) || (vel.size() != N - 1)) {
+	// the quasi-static lines have no states
+	const unsigned int n = quasi_static ? 0 : N - 1;
+	if ((pos.cols() != n) || (vel.cols() != n)) {
 		LOGERR << "Invalid input size" << endl;
 		throw moordyn::invalid_value_error("Invalid input size");
 	}
 
 	// set interior node positions and velocities based on state vector
-	for (unsigned int i = 1; i < N; i++) {
-		r[i] = pos[i - 1];
-		rd[i] = vel[i - 1];
+	r.middleCols(1, n) = pos;
+	rd.middleCols(1, n) = vel;
+}
+
+real
+Line::getSegmentStiffness() const
+{
+	if (UnstrLen <= 0.0)
+		return 0.0;
+	const real EA = nEApoints ? stiffYs.back() / stiffXs.back() : E * A;
+	return EA * N / UnstrLen;
+}
+
+real
+Line::getCriticalTimeStep(bool axial) const
+{
+	if (quasi_static || (UnstrLen <= 0.0))
+		return std::numeric_limits<real>::infinity();
+	const real len = UnstrLen / N;
+	const real rho_w = env ? env->rho_w : 0.0;
+	const real kb = env ? env->kb : 0.0;
+	// Mass of the internal nodes along the line and normal to it
+	real m_t = (rho + rho_w * Cat) * A * len;
+	real m_n = (rho + rho_w * Can) * A * len;
+	if (fict_m > 0.0)
+		m_t = m_n = fict_m;
+	// Squared highest natural frequencies of the discretized line, i.e.
+	// every node moving in opposition to its neighbours
+	const real w2_axial = axial ? 4.0 * getSegmentStiffness() / m_t : 0.0;
+	const real bEI = nEIpoints ? bstiffYs.back() / bstiffXs.back() : EI;
+	const real w2_bend = 16.0 * bEI / (m_n * len * len * len);
+	const real w2_seabed = kb * d * len / m_n;
+	return 2.0 / sqrt(std::max(w2_axial, w2_bend + w2_seabed));
+}
+
+void
+Line::setFictitiousMass(real dt)
+{
+	fict_m = 0.0;
+	if ((dt <= 0.0) || (UnstrLen <= 0.0))
+		return;
+	const real len = UnstrLen / N;
+	const real kb = env ? env->kb : 0.0;
+	// The stiffness of the highest natural frequency, see
+	// getCriticalTimeStep()
+	const real k_axial = 4.0 * getSegmentStiffness();
+	const real bEI = nEIpoints ? bstiffYs.back() / bstiffXs.back() : EI;
+	const real k_bend = 16.0 * bEI / (len * len * len) + kb * d * len;
+	// The internal and seabed damping are also reducing the critical time
+	// step, which on a damped oscillator is 2 / w (sqrt(1 + z^2) - z), being
+	// z the damping ratio
+	const real cb = env ? env->cb : 0.0;
+	const real c_node = 4.0 * c * A / len + cb * d * len;
+	fict_m = 0.25 * dt * dt * std::max(k_axial, k_bend) + 0.5 * dt * c_node;
+}
+
+void
+Line::getAxialJacobian(std::vector<mat>& K, std::vector<mat>& C)
+{
+	K.resize(N);
+	C.resize(N);
+	for (unsigned int i = 0; i < N; i++) {
+		const vec dr = r.col(i + 1) - r.col(i);
+		const real L = dr.norm();
+		const vec qi = dr / L;
+		const mat Q = qi * qi.transpose();
+		if (L > l[i]) {
+			// Material plus geometric stiffness
+			const real EA = getNonlinearE(L, l[i]) * A;
+			K[i] = EA / l[i] * Q +
+			       EA * (1.0 / l[i] - 1.0 / L) * (mat::Identity() - Q);
+		} else
+			K[i].setZero();
+		// The nonlinear damping coefficient is not defined at null strain
+		// rates
+		const real ld = qi.dot(rd.col(i + 1) - rd.col(i));
+		const real ci = (nCpoints && (ld == 0.0)) ? c : getNonlinearC(ld, l[i]);
+		C[i] = ci * A / l[i] * Q;
 	}
 }
 
+real
+Line::solveStatics(real tol, unsigned int max_iters)
+{
+	if (quasi_static)
+		return 0.0;
+	rd.middleCols(1, N - 1).setZero();
+	if (N < 2)
+		return 0.0;
+
+	// The state derivative is just used to get the net forces and the
+	// accelerations of the nodes
+	vec3N vel(3, N - 1), acc(3, N - 1);
+	DLineStateDt drdt(Eigen::Map<vec3N>(vel.data(), 3, N - 1),
+	                  Eigen::Map<vec3N>(acc.data(), 3, N - 1));
+	getStateDeriv(drdt);
+	real fnorm = Fnet.middleCols(1, N - 1).norm();
+	real err = acc.colwise().norm().maxCoeff();
+
+	// Pseudo transient continuation is applied, i.e. the nodes are softly
+	// attached to their current positions, with a stiffness proportional to
+	// their masses. That way the solver can progress while the Jacobian is
+	// singular, e.g. with slack segments or nodes lying on the seabed. The
+	// attachment is relaxed as the residual decreases, recovering the
+	// quadratic convergence of the Newton method
+	const real mu0 = env->g * N / UnstrLen;
+	real mu = mu0;
+
+	std::vector<mat> K, C, D, U;
+	vec3N r0(3, N - 1), dr(3, N - 1);
+	const real kb = 0.5 * d * env->kb;
+	for (unsigned int iter = 0; (iter < max_iters) && (err > tol); iter++) {
+		// Solve the linearized system, (K + mu M) dr = Fnet
+		getAxialJacobian(K, C);
+		D.resize(N - 1);
+		U.resize(N - 1);
+		for (unsigned int i = 1; i < N; i++) {
+			D[i - 1] = K[i - 1] + K[i] + mu * M[i];
+			if (r(2, i) < -env->WtrDpth)
+				D[i - 1](2, 2) += kb * (l[i - 1] + l[i]);
+			U[i - 1] = -K[i];
+		}
+		dr = Fnet.middleCols(1, N - 1);
+		solve_block_tridiagonal(D, U, dr);
+
+		r0 = r.middleCols(1, N - 1);
+		r.middleCols(1, N - 1) += dr;
+		getStateDeriv(drdt);
+		const real fnorm_new = Fnet.middleCols(1, N - 1).norm();
+		if (!(fnorm_new < 10.0 * fnorm)) {
+			// Too large step, go back and take a more conservative one
+			r.middleCols(1, N - 1) = r0;
+			getStateDeriv(drdt);
+			mu *= 10.0;
+			continue;
+		}
+		// Switched evolution relaxation of the pseudo time step, which is
+		// anyway enlarged to speed up the slack nodes falling
+		mu = std::max(0.5 * mu * fnorm_new / fnorm, 1.0e-6 * mu0);
+		fnorm = fnorm_new;
+		err = acc.colwise().norm().maxCoeff();
+	}
+
+	return err;
+}
+
 void
 Line::setEndKinematics(vec pos, vec vel, EndPoints end_point)
+{
+	moveEndPoint(pos, vel, end_point);
+	if (end_point == ENDPOINT_TOP)
+		endTypeB = PINNED; // indicate pinned
+	else
+		endTypeA = PINNED; // indicate pinned
+}
+
+void
+Line::moveEndPoint(const vec& pos, const vec& vel, EndPoints end_point)
 {
 	switch (end_point) {
 		case ENDPOINT_TOP:
-			endTypeB = PINNED; // indicate pinned
-			r[N] = pos;
-			rd[N] = vel;
+			r.col(N) = pos;
+			rd.col(N) = vel;
 			break;
 		case ENDPOINT_BOTTOM:
-			endTypeA = PINNED; // indicate pinned
-			r[0] = pos;
-			rd[0] = vel;
+			r.col(0) = pos;
+			rd.col(0) = vel;
 			break;
 		default:
 			LOGERR << "Invalid end point qualifier: " << end_point << endl;
@@ -651,15 +869,15 @@ Line::setEndOrientation(vec qin, EndPoints end_point, EndPoints rod_end_point)
 	switch (end_point) {
 		case ENDPOINT_TOP:
 			endTypeB = CANTILEVERED; // indicate pinned
-			q[N] = qin;              // -----line----->[A==ROD==>B]
+			q.col(N) = qin;          // -----line----->[A==ROD==>B]
 			if (rod_end_point == ENDPOINT_B)
-				q[N] *= -1.0; // -----line----->[B<==ROD==A]
+				q.col(N) *= -1.0; // -----line----->[B<==ROD==A]
 			break;
 		case ENDPOINT_BOTTOM:
 			endTypeA = CANTILEVERED; // indicate pinned
-			q[0] = qin;              // [A==ROD==>B]-----line----->
+			q.col(0) = qin;          // [A==ROD==>B]-----line----->
 			if (rod_end_point == ENDPOINT_A)
-				q[0] *= -1.0; // [B<==ROD==A]-----line----->
+				q.col(0) *= -1.0; // [B<==ROD==A]-----line----->
 			break;
 		default:
 			LOGERR << "Invalid end point qualifier: " << end_point << endl;
@@ -680,7 +898,7 @@ Line::getEndSegmentMoment(EndPoints end_point, EndPoints rod_end_point) const
 	switch (end_point) {
 		case ENDPOINT_TOP:
 			// unit vector of last line segment
-			dlEnd = unitvector(qEnd, r[N - 1], r[N]);
+			dlEnd = unitvector(qEnd, r.col(N - 1), r.col(N));
 			if (rod_end_point == ENDPOINT_A) {
 				// -----line----->[A==ROD==>B]
 				EIEnd = EI;
@@ -691,7 +909,7 @@ Line::getEndSegmentMoment(EndPoints end_point, EndPoints rod_end_point) const
 			break;
 		case ENDPOINT_BOTTOM:
 			// unit vector of last line segment
-			dlEnd = unitvector(qEnd, r[N - 1], r[N]);
+			dlEnd = unitvector(qEnd, r.col(N - 1), r.col(N));
 			if (rod_end_point == ENDPOINT_A) {
 				// <----line-----[A==ROD==>B]
 				EIEnd = -EI;
@@ -708,68 +926,135 @@ Line::getEndSegmentMoment(EndPoints end_point, EndPoints rod_end_point) const
 	return qEnd * EIEnd / dlEnd;
 }
 
-std::pair<std::vector<vec>, std::vector<vec>>
-Line::getStateDeriv()
+unsigned int
+Line::getFeatures() const
+{
+	unsigned int features = 0;
+	if (nEApoints > 0)
+		features |= LINE_NONLINEAR_EA;
+	if (nCpoints > 0)
+		features |= LINE_NONLINEAR_C;
+	if (EI > 0)
+		features |= LINE_BENDING;
+	if (WaterKin == WAVES_EXTERNAL)
+		features |= LINE_WAVES_EXTERNAL;
+	else if (WaterKin == WAVES_GRID)
+		features |= LINE_WAVES_GRID;
+	return features;
+}
+
+/// Number of specialized getStateDeriv() kernels
+#define LINE_N_KERNELS 24
+
+/** @brief Get the features of a specialized getStateDeriv() kernel
+ *
+ * The first 3 bits are the nonlinear stiffness, nonlinear damping and
+ * bending features, while the rest of the index is the water kinematics
+ * mode, which cannot be combined
+ * @param i The kernel index
+ * @return The features
+ */
+constexpr unsigned int
+kernel_features(unsigned int i)
+{
+	const unsigned int water = i >> 3;
+	return (i & 7) | (water == 1 ? LINE_WAVES_EXTERNAL : 0) |
+	       (water == 2 ? LINE_WAVES_GRID : 0);
+}
+
+/** @brief Get the index of the specialized getStateDeriv() kernel
+ * @param features The features
+ * @return The kernel index
+ */
+constexpr unsigned int
+kernel_index(unsigned int features)
+{
+	return (features & 7) + ((features & LINE_WAVES_EXTERNAL) ? 8 : 0) +
+	       ((features & LINE_WAVES_GRID) ? 16 : 0);
+}
+
+template<std::size_t... I>
+constexpr std::array<Line::deriv_kernel, sizeof...(I)>
+Line::makeKernels(std::index_sequence<I...>)
+{
+	return { &Line::stateDerivKernel<kernel_features(I)>... };
+}
+
+Line::deriv_kernel
+Line::getKernel(unsigned int features)
+{
+	static constexpr auto kernels =
+	    makeKernels(std::make_index_sequence<LINE_N_KERNELS>{});
+	if (features & LINE_GENERIC)
+		return &Line::stateDerivKernel<LINE_GENERIC>;
+	return kernels[kernel_index(features)];
+}
+
+template<unsigned int FEATS>
+void
+Line::stateDerivKernel(DLineStateDt& drdt)
 {
 	// NOTE:
 	// Jose Luis Cercos-Pita: This is by far the most consuming function of the
 	// whole library, just because it is called every single time substep and
 	// it shall makecomputations in every single line node. Thus it is worthy
 	// to invest effort on keeping it optimized.
+	// That is why the computations are carried out as whole-line kernels on
+	// the 3xN arrays, which Eigen can vectorize, instead of looping on nodes
 
 	// attempting error handling <<<<<<<<
-	for (unsigned int i = 0; i <= N; i++) {
-		if (isnan(r[i].sum())) {
-			stringstream s;
-			LOGERR << "NaN detected" << endl << "Line " << number << endl;
-			LOGMSG << "node positions:" << endl;
-			for (unsigned int j = 0; j <= N; j++)
-				LOGMSG << j << " : [" << r[j].transpose() << "]" << endl;
-			throw moordyn::nan_error("NaN in node positions");
-		}
+	if (r.hasNaN()) {
+		LOGERR << "NaN detected" << endl << "Line " << number << endl;
+		LOGMSG << "node positions:" << endl;
+		for (unsigned int j = 0; j <= N; j++)
+			LOGMSG << j << " : [" << r.col(j).transpose() << "]" << endl;
+		throw moordyn::nan_error("NaN in node positions");
 	}
 
 	// dt is possibly used for stability tricks...
 
 	// -------------------- calculate various kinematic quantities
 	// ---------------------------
-	for (unsigned int i = 0; i < N; i++) {
-		// calculate current (Stretched) segment lengths and unit tangent
-		// vectors (qs) for each segment (this is used for bending calculations)
-		lstr[i] = unitvector(qs[i], r[i], r[i + 1]);
-
-		// this is the denominator of how the stretch rate equation was
-		// formulated
-		const double ldstr_top = (r[i + 1] - r[i]).dot(rd[i + 1] - rd[i]);
-		ldstr[i] = ldstr_top / lstr[i]; // strain rate of segment
 
-		V[i] = A * l[i]; // volume attributed to segment
-	}
+	// calculate current (Stretched) segment lengths and unit tangent vectors
+	// (qs) for each segment (this is used for bending calculations). The
+	// segment vectors are kept on T, to be used later in the tension and
+	// damping computations
+	T = r.rightCols(N) - r.leftCols(N);
+	colnorms(T, lstr);
+	qs = T.array().rowwise() / lstr.transpose().array();
+
+	// this is the numerator of how the stretch rate equation was formulated
+	coldots(T, rd.rightCols(N) - rd.leftCols(N), ldstr);
+	// strain rate of segment
+	ldstr = ldstr.cwiseQuotient(lstr);
+	// volume attributed to segment
+	V = A * l;
 
 	// calculate unit tangent vectors (q) for each internal node. note: I've
 	// reversed these from pointing toward 0 rather than N. Check sign of wave
 	// loads. <<<<
-	for (unsigned int i = 1; i < N; i++)
-		unitvector(
-		    q[i],
-		    r[i - 1],
-		    r[i + 1]); // compute unit vector q ... using adjacent two nodes!
+	// compute unit vector q ... using adjacent two nodes!
+	q.middleCols(1, N - 1) = r.rightCols(N - 1) - r.leftCols(N - 1);
+	colnorms(q, node_w1);
+	q.middleCols(1, N - 1).array().rowwise() /=
+	    node_w1.segment(1, N - 1).transpose().array();
 
 	// calculate unit tangent vectors for either end node if the line has no
 	// bending stiffness of if either end is pinned (otherwise it's already been
 	// set via setEndStateFromRod)
 	if ((endTypeA == PINNED) || (EI == 0))
-		unitvector(q[0], r[0], r[1]);
+		q.col(0) = qs.col(0);
 	if ((endTypeB == PINNED) || (EI == 0))
-		unitvector(q[N], r[N - 1], r[N]);
+		q.col(N) = qs.col(N - 1);
 
 	//============================================================================================
 	// --------------------------------- apply wave kinematics
 	// -----------------------------
 
-	if (WaterKin == WAVES_EXTERNAL) // wave kinematics time series set
-	                                // internally for each node
-	{
+	if (has<FEATS>(LINE_WAVES_EXTERNAL)) {
+		// wave kinematics time series set internally for each node
+
 		// =========== obtain (precalculated) wave kinematics at current time
 		// instant ============ get precalculated wave kinematics at
 		// previously-defined node positions for time instant t
@@ -784,24 +1069,19 @@ Line::getStateDeriv()
 			    zetaTS[i][it] + frac * (zetaTS[i][it + 1] - zetaTS[i][it]);
 			F[i] = 1.0; // FTS[i][it] + frac*(FTS[i][it+1] - FTS[i][it]);
 
-			U[i] = UTS[i][it] + frac * (UTS[i][it + 1] - UTS[i][it]);
-			Ud[i] = UdTS[i][it] + frac * (UdTS[i][it + 1] - UdTS[i][it]);
+			U.col(i) = UTS[i][it] + frac * (UTS[i][it + 1] - UTS[i][it]);
+			Ud.col(i) = UdTS[i][it] + frac * (UdTS[i][it + 1] - UdTS[i][it]);
 		}
-	} else if (WaterKin == WAVES_GRID) {
-		// wave kinematics interpolated from global grid in Waves object
-		for (unsigned int i = 0; i <= N; i++) {
-			// call generic function to get water velocities
-			waves->getWaveKin(
-			    r[i][0], r[i][1], r[i][2], U[i], Ud[i], zeta[i], PDyn[i]);
-
-			F[i] = 1.0; // set VOF value to one for now (everything submerged -
-			            // eventually this should be element-based!!!) <<<<
-		}
-	} else if (WaterKin !=
-	           WAVES_NONE) // Hopefully WaterKin is set to zero, meaning no
-	                       // waves or set externally, otherwise it's an error
-		cout << "ERROR: We got a problem with WaterKin not being 0,1,2."
-		     << endl;
+	} else if (has<FEATS>(LINE_WAVES_GRID)) {
+		// wave kinematics interpolated from global grid in Waves object, at
+		// the line time, which might be within the outer time step if the
+		// line is subcycled
+		waves->getWaveKin(r, U, Ud, zeta, PDyn, wave_cells, t);
+		// set VOF value to one for now (everything submerged - eventually
+		// this should be element-based!!!) <<<<
+		F.setOnes();
+	}
+	// Otherwise there are no waves, or they are set externally
 
 	//============================================================================================
 
@@ -814,7 +1094,7 @@ Line::getStateDeriv()
 			m_i = pi / 8. * d * d * l[0] * rho;
 			v_i = 1. / 2. * F[i] * V[i];
 		} else if (i == N) {
-			m_i = pi / 8. * d * d * l[N - 2] * rho;
+			m_i = pi / 8. * d * d * l[N - 1] * rho;
 			v_i = 1. / 2. * F[i - 1] * V[i - 1];
 		} else {
 			m_i = pi / 8. * (d * d * rho * (l[i] + l[i - 1]));
@@ -823,41 +1103,50 @@ Line::getStateDeriv()
 
 		// Make node mass matrix
 		const mat I = mat::Identity();
-		const mat Q = q[i] * q[i].transpose();
+		const vec q_i = q.col(i);
+		const mat Q = q_i * q_i.transpose();
+		if (fict_m > 0.0) {
+			// The end nodes have just half of a segment
+			M[i] = ((i == 0) || (i == N) ? 0.5 : 1.0) * fict_m * I;
+			continue;
+		}
 		M[i] = m_i * I + env->rho_w * v_i * (Can * (I - Q) + Cat * Q);
 	}
 
 	// ============  CALCULATE FORCES ON EACH NODE
 	// ===============================
 
-	// loop through the segments
-	for (unsigned int i = 0; i < N; i++) {
-		// line tension
-		if (nEApoints > 0)
-			E = getNonlinearE(lstr[i], l[i]);
-
-		if (lstr[i] / l[i] > 1.0) {
-			T[i] = E * A * (1. / l[i] - 1. / lstr[i]) * (r[i + 1] - r[i]);
-		} else {
-			// cable can't "push" ...
-			// or can it, if bending stiffness is nonzero? <<<<<<<<<
-			T[i] = vec(0.0, 0.0, 0.0);
-		}
-
-		// line internal damping force
-		if (nCpoints > 0)
-			c = getNonlinearC(ldstr[i], l[i]);
-
-		Td[i] = c * A * (ldstr[i] / l[i]) * (r[i + 1] - r[i]) / lstr[i];
-	}
+	// line tension
+	if (has<FEATS>(LINE_NONLINEAR_EA)) {
+		for (unsigned int i = 0; i < N; i++)
+			seg_w[i] = getNonlinearE(lstr[i], l[i]);
+	} else
+		seg_w.setConstant(E);
+	// cable can't "push" ...
+	// or can it, if bending stiffness is nonzero? <<<<<<<<<
+	seg_w.array() =
+	    (lstr.array() / l.array() > 1.0)
+	        .select(seg_w.array() * A * (1. / l.array() - 1. / lstr.array()),
+	                0.0);
+	// line internal damping force, computed before the segment vectors are
+	// overwritten by the tension forces
+	Td = T;
+	T.array().rowwise() *= seg_w.transpose().array();
+	if (has<FEATS>(LINE_NONLINEAR_C)) {
+		for (unsigned int i = 0; i < N; i++)
+			seg_w[i] = getNonlinearC(ldstr[i], l[i]);
+	} else
+		seg_w.setConstant(c);
+	seg_w.array() = seg_w.array() * A * (ldstr.array() / l.array());
+	Td.array().rowwise() *= seg_w.transpose().array();
+	Td.array().rowwise() /= lstr.transpose().array();
 
 	// Bending loads
 	// first zero out the forces from last run
-	for (unsigned int i = 0; i <= N; i++)
-		Bs[i] = vec(0.0, 0.0, 0.0);
+	Bs.setZero();
 
 	// and now compute them (if possible)
-	if (EI > 0) {
+	if (has<FEATS>(LINE_BENDING)) {
 		// loop through all nodes to calculate bending forces
 		for (unsigned int i = 0; i <= N; i++) {
 			moordyn::real Kurvi = 0.0;
@@ -877,14 +1166,14 @@ Line::getStateDeriv()
 					// curvature <<< check if this approximation works for an
 					// end (assuming rod angle is node angle which is middle of
 					// if there was a segment -1/2
-					Kurvi = GetCurvature(lstr[i], q[i], qs[i]);
+					Kurvi = GetCurvature(lstr[i], q.col(i), qs.col(i));
 
 					// get direction of bending radius axis
-					pvec = q[0].cross(qs[i]);
+					pvec = q.col(0).cross(qs.col(i));
 
 					// get direction of resulting force from bending to apply on
 					// node i+1
-					Mforce_ip1 = qs[i].cross(pvec);
+					Mforce_ip1 = qs.col(i).cross(pvec);
 
 					// record bending moment at end for potential application to
 					// attached object   <<<< do double check this....
@@ -899,8 +1188,8 @@ Line::getStateDeriv()
 					Mforce_i = -Mforce_ip1;
 
 					// apply these forces to the node forces
-					Bs[i] = Mforce_i;
-					Bs[i + 1] = Mforce_ip1;
+					Bs.col(i) = Mforce_i;
+					Bs.col(i + 1) = Mforce_ip1;
 				}
 			}
 			// end node A case (only if attached to a Rod, i.e. a cantilever
@@ -913,14 +1202,14 @@ Line::getStateDeriv()
 					// works for an end (assuming rod angle is node
 					// angle which is middle of if there was a
 					// segment -1/2
-					Kurvi = GetCurvature(lstr[i - 1], qs[i - 1], q[i]);
+					Kurvi = GetCurvature(lstr[i - 1], qs.col(i - 1), q.col(i));
 
 					// get direction of bending radius axis
-					pvec = qs[i - 1].cross(q[N]);
+					pvec = qs.col(i - 1).cross(q.col(N));
 
 					// get direction of resulting force from bending to apply on
 					// node i-1
-					Mforce_im1 = qs[i - 1].cross(pvec);
+					Mforce_im1 = qs.col(i - 1).cross(pvec);
 
 					// record bending moment at end for potential application to
 					// attached object   <<<< do double check this....
@@ -939,24 +1228,25 @@ Line::getStateDeriv()
 					Mforce_i = -Mforce_im1;
 
 					// apply these forces to the node forces
-					Bs[i - 1] = Mforce_im1;
-					Bs[i] = Mforce_i;
+					Bs.col(i - 1) = Mforce_im1;
+					Bs.col(i) = Mforce_i;
 				}
 			} else // internal node
 			{
 				// curvature <<< remember to check
 				// sign, or just take abs
-				Kurvi = GetCurvature(lstr[i - 1] + lstr[i], qs[i - 1], qs[i]);
+				Kurvi = GetCurvature(
+				    lstr[i - 1] + lstr[i], qs.col(i - 1), qs.col(i));
 
 				// get direction of bending radius axis
-				pvec = qs[i - 1].cross(q[i]);
+				pvec = qs.col(i - 1).cross(q.col(i));
 
 				// get direction of resulting force from bending to apply on
 				// node i-1
-				Mforce_im1 = qs[i - 1].cross(pvec);
+				Mforce_im1 = qs.col(i - 1).cross(pvec);
 				// get direction of resulting force from bending to apply on
 				// node i+1
-				Mforce_ip1 = qs[i].cross(pvec);
+				Mforce_ip1 = qs.col(i).cross(pvec);
 
 				// scale force direction vectors by desired moment force
 				// magnitudes to get resulting forces on adjacent nodes
@@ -967,21 +1257,21 @@ Line::getStateDeriv()
 				Mforce_i = -Mforce_im1 - Mforce_ip1;
 
 				// apply these forces to the node forces
-				Bs[i - 1] = Mforce_im1;
-				Bs[i] = Mforce_i;
-				Bs[i + 1] = Mforce_ip1;
+				Bs.col(i - 1) = Mforce_im1;
+				Bs.col(i) = Mforce_i;
+				Bs.col(i + 1) = Mforce_ip1;
 			}
 
 			// check for NaNs <<<<<<<<<<<<<<< temporary measure <<<<<<<
-			if (isnan(Bs[i][0]) || isnan(Bs[i][1]) || isnan(Bs[i][2])) {
+			if (Bs.col(i).hasNaN()) {
 				cout << "   Error: NaN value detected in bending force at Line "
 				     << number << " node " << i << endl;
 				cout << lstr[i - 1] + lstr[i] << endl;
-				cout << sqrt(0.5 * (1 - qs[i - 1].dot(qs[i]))) << endl;
+				cout << sqrt(0.5 * (1 - qs.col(i - 1).dot(qs.col(i)))) << endl;
 
-				cout << Bs[i - 1] << endl;
-				cout << Bs[i] << endl;
-				cout << Bs[i + 1] << endl;
+				cout << Bs.col(i - 1) << endl;
+				cout << Bs.col(i) << endl;
+				cout << Bs.col(i + 1) << endl;
 				cout << Mforce_im1 << endl;
 				cout << Mforce_i << endl;
 				cout << Mforce_ip1 << endl;
@@ -1040,172 +1330,246 @@ Line::getStateDeriv()
 		} // for i=0,N (looping through nodes)
 	}     // if EI > 0
 
-	// loop through the nodes
-	for (unsigned int i = 0; i <= N; i++) {
-		W[i][0] = W[i][1] = 0.0;
-		// submerged weight (including buoyancy)
-		if (i == 0)
-			W[i][2] = 0.5 * A * (l[i] * (rho - F[i] * env->rho_w)) * (-env->g);
-		else if (i == N)
-			W[i][2] = 0.5 * A * (l[i - 1] * (rho - F[i - 1] * env->rho_w)) *
-			          (-env->g); // missing the "W[i][2] =" previously!
-		else
-			W[i][2] = 0.5 * A *
-			          (l[i] * (rho - F[i] * env->rho_w) +
-			           l[i - 1] * (rho - F[i - 1] * env->rho_w)) *
-			          (-env->g);
-
-		// relative flow velocity over node
-		const vec vi = U[i] - rd[i];
-		// tangential relative flow component
-		// <<<<<<< check sign since I've reversed q
-		const moordyn::real vql = vi.dot(q[i]);
-		const vec vq = vql * q[i];
-		// transverse relative flow component
-		const vec vp = vi - vq;
-
-		const moordyn::real vq_mag = vq.norm();
-		const moordyn::real vp_mag = vp.norm();
-
-		// transverse drag
-		if (i == 0)
-			Dp[i] = 0.25 * vp_mag * env->rho_w * Cdn * d * (F[i] * l[i]) * vp;
-		else if (i == N)
-			Dp[i] = 0.25 * vp_mag * env->rho_w * Cdn * d *
-			        (F[i - 1] * l[i - 1]) * vp;
-		else
-			Dp[i] = 0.25 * vp_mag * env->rho_w * Cdn * d *
-			        (F[i] * l[i] + F[i - 1] * l[i - 1]) * vp;
-
-		// tangential drag
-		if (i == 0)
-			Dq[i] =
-			    0.25 * vq_mag * env->rho_w * Cdt * pi * d * (F[i] * l[i]) * vq;
-		else if (i == N)
-			Dq[i] = 0.25 * vq_mag * env->rho_w * Cdt * pi * d *
-			        (F[i - 1] * l[i - 1]) * vq;
-		else
-			Dq[i] = 0.25 * vq_mag * env->rho_w * Cdt * pi * d *
-			        (F[i] * l[i] + F[i - 1] * l[i - 1]) * vq;
-
-		// tangential component of fluid acceleration
-		// <<<<<<< check sign since I've reversed q
-		const moordyn::real aql = Ud[i].dot(q[i]);
-		const vec aq = aql * q[i];
-		// normal component of fluid acceleration
-		const vec ap = Ud[i] - aq;
-
-		// transverse Froude-Krylov force
-		if (i == 0)
-			Ap[i] = env->rho_w * (1. + Can) * 0.5 * (V[i]) * ap;
-		else if (i == N)
-			Ap[i] = env->rho_w * (1. + Can) * 0.5 * (V[i - 1]) * ap;
-		else
-			Ap[i] = env->rho_w * (1. + Can) * 0.5 * (V[i] + V[i - 1]) * ap;
-		// tangential Froude-Krylov force
-		if (i == 0)
-			Aq[i] = 0.5 * env->rho_w * (1. + Cat) * 0.5 * (V[i]) * aq;
-		else if (i == N)
-			Aq[i] = 0.5 * env->rho_w * (1. + Cat) * 0.5 * (V[i - 1]) * aq;
-		else
-			Aq[i] = env->rho_w * (1. + Cat) * 0.5 * (V[i] + V[i - 1]) * aq;
-
-		// bottom contact (stiffness and damping, vertical-only for now) -
-		// updated for general case of potentially anchor or fairlead end in
-		// contact
-		if (r[i][2] < -env->WtrDpth) {
-			if (i == 0)
-				B[i][2] =
-				    ((-env->WtrDpth - r[i][2]) * env->kb - rd[i][2] * env->cb) *
-				    0.5 * d * (l[i]);
-			else if (i == N)
-				B[i][2] =
-				    ((-env->WtrDpth - r[i][2]) * env->kb - rd[i][2] * env->cb) *
-				    0.5 * d * (l[i - 1]);
-			else
-				B[i][2] =
-				    ((-env->WtrDpth - r[i][2]) * env->kb - rd[i][2] * env->cb) *
-				    0.5 * d * (l[i - 1] + l[i]);
-
-			// new rough-draft addition of seabed friction
-			real FrictionMax =
-			    abs(B[i][2]) *
-			    env->FrictionCoefficient; // dynamic friction force saturation
-			                              // level based on bottom contact force
-
-			// saturated damping approach to applying friction, for now
-			real BottomVel =
-			    sqrt(rd[i][0] * rd[i][0] +
-			         rd[i][1] * rd[i][1]); // velocity of node along sea bed
-			real FrictionForce =
-			    BottomVel * env->FrictionCoefficient *
-			    env->FricDamp; // some arbitrary damping scaling thing at end
-			if (FrictionForce > env->StatDynFricScale * FrictionMax)
-				FrictionForce =
-				    FrictionMax; // saturate (quickly) to static/dynamic
-				                 // friction force level
-
-			if (BottomVel == 0.0) { // check for zero velocity, in which case
-				                    // friction force is zero
-				B[i][0] = 0.0;
-				B[i][1] = 0.0;
-			} else { // otherwise, apply friction force in correct
-				     // direction(opposing direction of motion)
-				B[i][0] = -FrictionForce * rd[i][0] / BottomVel;
-				B[i][1] = -FrictionForce * rd[i][1] / BottomVel;
-			}
-		} else
-			B[i] = vec(0.0, 0.0, 0.0);
-
-		// total forces
-		if (i == 0)
-			Fnet[i] = T[i] + Td[i];
-		else if (i == N)
-			Fnet[i] = -T[i - 1] - Td[i - 1];
-		else
-			Fnet[i] = T[i] - T[i - 1] + Td[i] - Td[i - 1];
-		Fnet[i] += W[i] + (Dp[i] + Dq[i] + Ap[i] + Aq[i]) + B[i] + Bs[i];
+	// submerged weight (including buoyancy)
+	lumpSegments(
+	    l.cwiseProduct((rho - F.head(N).array() * env->rho_w).matrix()),
+	    node_w1);
+	W.row(2).array() = 0.5 * A * node_w1.transpose().array() * (-env->g);
+
+	// relative flow velocity over node, which is split on its tangential
+	// (Dq) and transverse (Dp) components
+	// <<<<<<< check sign since I've reversed q
+	Dp = U - rd;
+	coldots(Dp, q, node_w1);
+	Dq = q.array().rowwise() * node_w1.transpose().array();
+	Dp -= Dq;
+
+	// transverse and tangential drag, on the lumped submerged lengths
+	lumpSegments(F.head(N).cwiseProduct(l), node_w2);
+	colnorms(Dp, node_w1);
+	node_w1.array() =
+	    0.25 * node_w1.array() * env->rho_w * Cdn * d * node_w2.array();
+	Dp.array().rowwise() *= node_w1.transpose().array();
+	colnorms(Dq, node_w1);
+	node_w1.array() =
+	    0.25 * node_w1.array() * env->rho_w * Cdt * pi * d * node_w2.array();
+	Dq.array().rowwise() *= node_w1.transpose().array();
+
+	// tangential (Aq) and normal (Ap) components of fluid acceleration
+	// <<<<<<< check sign since I've reversed q
+	coldots(Ud, q, node_w1);
+	Aq = q.array().rowwise() * node_w1.transpose().array();
+	Ap = Ud - Aq;
+
+	// transverse and tangential Froude-Krylov force, on the lumped volumes.
+	// NOTE: The end nodes have historically used half of the lumped volume
+	// for the tangential component
+	lumpSegments(V, node_w2);
+	node_w1 = node_w2 * (env->rho_w * (1. + Can) * 0.5);
+	Ap.array().rowwise() *= node_w1.transpose().array();
+	node_w2[0] *= 0.5;
+	node_w2[N] *= 0.5;
+	node_w1 = node_w2 * (env->rho_w * (1. + Cat) * 0.5);
+	Aq.array().rowwise() *= node_w1.transpose().array();
+
+	// bottom contact (stiffness and damping, vertical-only for now) - updated
+	// for general case of potentially anchor or fairlead end in contact
+	if (r.row(2).minCoeff() >= -env->WtrDpth) {
+		// Most of the lines are not touching the seabed at all
+		B.setZero();
+	} else {
+		lumpSegments(l, node_w1);
+		B.row(2).array() =
+		    (r.row(2).array() < -env->WtrDpth)
+		        .select(((-env->WtrDpth - r.row(2).array()) * env->kb -
+		                 rd.row(2).array() * env->cb) *
+		                    0.5 * d * node_w1.transpose().array(),
+		                0.0);
+		// new rough-draft addition of seabed friction, with a saturated
+		// damping approach to applying it, for now. The velocity of the node
+		// along sea bed is stored in node_w1, while the friction force is
+		// stored in node_w2
+		node_w1 = (rd.row(0).array().square() + rd.row(1).array().square())
+		              .sqrt()
+		              .transpose();
+		node_w2.array() =
+		    node_w1.array() * env->FrictionCoefficient * env->FricDamp;
+		// saturate (quickly) to static/dynamic friction force level, based on
+		// bottom contact force
+		node_w2.array() =
+		    (node_w2.array() > env->StatDynFricScale *
+		                           (B.row(2).transpose().array().abs() *
+		                            env->FrictionCoefficient))
+		        .select(B.row(2).transpose().array().abs() *
+		                    env->FrictionCoefficient,
+		                node_w2.array());
+		// apply friction force in correct direction (opposing direction of
+		// motion), unless the velocity is null, in which case friction force is
+		// zero too
+		for (unsigned int j = 0; j < 2; j++) {
+			B.row(j).array() =
+			    (node_w1.transpose().array() == 0.0)
+			        .select(0.0,
+			                -node_w2.transpose().array() * rd.row(j).array() /
+			                    node_w1.transpose().array());
+		}
 	}
 
-	//	if (t > 5)
-	//	{
-	//		cout << " in getStateDeriv of line " << number << endl;
-	//
-	//		B[0][0] = 0.001; // meaningless
-	//	}
+	// total forces
+	Fnet.col(0) = T.col(0) + Td.col(0);
+	Fnet.middleCols(1, N - 1) = T.rightCols(N - 1) - T.leftCols(N - 1) +
+	                            Td.rightCols(N - 1) - Td.leftCols(N - 1);
+	Fnet.col(N) = -T.col(N - 1) - Td.col(N - 1);
+	Fnet += W + (Dp + Dq + Ap + Aq) + B + Bs;
 
 	// loop through internal nodes and compute the accelerations
-	std::vector<vec> u, a;
-	u.reserve(N - 1);
-	a.reserve(N - 1);
 	for (unsigned int i = 1; i < N; i++) {
-		//	double M_out[9];
-		//	double F_out[3];
-		//	for (int I=0; I<3; I++)
-		//	{	F_out[I] = Fnet[i][I];
-		//		for (int J=0; J<3; J++) M_out[3*I + J] = M[i][I][J];
-		//	}
+		// For small systems it is usually faster to compute the inverse
+		// of the matrix. See
+		// https://eigen.tuxfamily.org/dox/group__TutorialLinearAlgebra.html
+		const vec acc = M[i].inverse() * Fnet.col(i);
+		drdt.acc.col(i - 1) = acc;
+	}
+	drdt.vel = rd.middleCols(1, N - 1);
+};
 
-		// solve for accelerations in [M]{a}={f} using LU decomposition
-		//	double LU[9];                        // serialized matrix that will
-		// hold LU matrices combined 	Crout(3, M_out, LU);                  //
-		// perform LU decomposition on mass matrix 	double acc[3]; //
-		// acceleration vector to solve for 	solveCrout(3, LU, F_out, acc);
-		// // solve for acceleration vector
+void
+Line::initializeQuasiStatic()
+{
+	if (rho <= env->rho_w) {
+		LOGERR << "Line " << number << " cannot be quasi-static, since it is "
+		       << "not heavier than water" << endl;
+		throw moordyn::invalid_value_error("Buoyant quasi-static line");
+	}
+	// the catenary only considers the weight and the axial stiffness
+	if ((EI > 0.0) || nEIpoints) {
+		LOGWRN << "The bending stiffness of the quasi-static Line " << number
+		       << " is neglected" << endl;
+		EI = 0.0;
+		nEIpoints = 0;
+	}
+	if (nEApoints) {
+		LOGWRN << "The nonlinear stiffness of the quasi-static Line "
+		       << number << " is linearized, EA = " << E * A << " N" << endl;
+	}
+	if (WaterKin != WAVES_NONE) {
+		LOGWRN << "The water kinematics are neglected on the quasi-static "
+		       << "Line " << number << endl;
+	}
+
+	qs_s.assign(N + 1, 0.0);
+	qs_X.assign(N + 1, 0.0);
+	qs_Z.assign(N + 1, 0.0);
+	qs_Te.assign(N + 1, 0.0);
+	qs_HF = qs_VF = 0.0;
+	qs_fails = 0;
+	kernel = &Line::quasiStaticKernel;
+
+	// get the initial profile and end forces
+	DLineStateDt drdt(Eigen::Map<vec3N>(NULL, 3, 0),
+	                  Eigen::Map<vec3N>(NULL, 3, 0));
+	quasiStaticKernel(drdt);
+	if (qs_fails) {
+		LOGERR << "The catenary of the quasi-static Line " << number
+		       << " cannot be solved" << endl;
+		throw moordyn::invalid_value_error("Invalid quasi-static line");
+	}
+	LOGMSG << "Line " << number << " solved as a quasi-static catenary"
+	       << endl;
+}
 
-		//	LUsolve3(M[i], acc, Fnet[i]);
+void
+Line::quasiStaticKernel(DLineStateDt&)
+{
+	if (r.col(0).hasNaN() || r.col(N).hasNaN()) {
+		LOGERR << "NaN detected" << endl << "Line " << number << endl;
+		throw moordyn::nan_error("NaN in end point positions");
+	}
 
-		//	Solve3(M[i], acc, (const double*)Fnet[i]);
+	// The catenary hangs from the highest end point, the other one being the
+	// anchor, which might rest on the seabed
+	const bool flip = r(2, N) < r(2, 0);
+	const unsigned int ia = flip ? N : 0;
+	const unsigned int ib = flip ? 0 : N;
+	const vec dir = r.col(ib) - r.col(ia);
+	const real XF = dir.head<2>().norm();
+	const real ZF = dir[2];
+	vec h(1.0, 0.0, 0.0);
+	if (XF > 0.0)
+		h.head<2>() = dir.head<2>() / XF;
+	const real LW = ((rho - env->rho_w) * A) * env->g;
+	const real CB = (r(2, ia) <= -env->WtrDpth + d) ? 0.0 : -1.0;
+	const real Tol = 0.00001;
+
+	for (unsigned int i = 1; i <= N; i++)
+		qs_s[i] = qs_s[i - 1] + l[i - 1];
+	qs_s[N] = UnstrLen;
+
+	// The previous solution is the initial guess, and it is only updated
+	// if the new one is found
+	real HA, VA;
+	const int success = Catenary(XF,
+	                             ZF,
+	                             UnstrLen,
+	                             E * A,
+	                             LW,
+	                             CB,
+	                             Tol,
+	                             &qs_HF,
+	                             &qs_VF,
+	                             &HA,
+	                             &VA,
+	                             N + 1,
+	                             qs_s,
+	                             qs_X,
+	                             qs_Z,
+	                             qs_Te,
+	                             true);
+	if (success < 0) {
+		if (!qs_fails++) {
+			LOGWRN << "The catenary of the quasi-static Line " << number
+			       << " cannot be solved at t = " << t
+			       << " s, the last solution is kept" << endl;
+		}
+		return;
+	}
 
-		// For small systems it is usually faster to compute the inverse
-		// of the matrix. See
-		// https://eigen.tuxfamily.org/dox/group__TutorialLinearAlgebra.html
-		a.push_back(M[i].inverse() * Fnet[i]);
-		u.push_back(rd[i]);
+	// Internal nodes, keeping the end points untouched. The uniform
+	// segments are symmetric, so the node k from the anchor has the arc
+	// length of the node k from end A
+	for (unsigned int k = 1; k < N; k++) {
+		const unsigned int i = flip ? N - k : k;
+		r.col(i) = r.col(ia) + qs_X[k] * h;
+		r(2, i) += qs_Z[k];
+		rd.col(i) = rd.col(0) + (rd.col(N) - rd.col(0)) * (i / (real)N);
 	}
 
-	return make_pair(u, a);
-};
+	// Segments tensions, as the average of their nodes ones
+	T = r.rightCols(N) - r.leftCols(N);
+	colnorms(T, lstr);
+	qs = T.array().rowwise() / lstr.transpose().array();
+	for (unsigned int i = 0; i < N; i++) {
+		const unsigned int k = flip ? N - i : i;
+		const unsigned int kp = flip ? k - 1 : k + 1;
+		T.col(i) = (0.5 * (qs_Te[k] + qs_Te[kp])) * qs.col(i);
+	}
+	ldstr.setZero();
+
+	// The weight is already accounted in the end forces, but the end masses
+	// are kept, so the attached free points have some inertia
+	Fnet.setZero();
+	Fnet.col(ia) = HA * h;
+	Fnet(2, ia) += VA;
+	Fnet.col(ib) = -qs_HF * h;
+	Fnet(2, ib) -= qs_VF;
+	const mat I = mat::Identity();
+	for (unsigned int i : { 0u, N }) {
+		const vec qi = qs.col(i ? N - 1 : 0);
+		const mat Q = qi * qi.transpose();
+		const real v_i = 0.5 * A * l[i ? N - 1 : 0];
+		M[i] = rho * v_i * I + env->rho_w * v_i * (Can * (I - Q) + Cat * Q);
+	}
+}
 
 // write output file for line  (accepts time parameter since retained time value
 // (t) will be behind by one line time step
@@ -1233,7 +1597,7 @@ Line::Output(real time)
 			for (unsigned int i = 0; i <= N; i++) // loop through nodes
 			{
 				for (unsigned int J = 0; J < 3; J++)
-					*outfile << r[i][J] << "\t ";
+					*outfile << r(J, i) << "\t ";
 			}
 		}
 		// output curvatures?
@@ -1246,28 +1610,28 @@ Line::Output(real time)
 		if (channels.find("v") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
 				for (int J = 0; J < 3; J++)
-					*outfile << rd[i][J] << "\t ";
+					*outfile << rd(J, i) << "\t ";
 			}
 		}
 		// output wave velocities?
 		if (channels.find("U") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
 				for (int J = 0; J < 3; J++)
-					*outfile << U[i][J] << "\t ";
+					*outfile << U(J, i) << "\t ";
 			}
 		}
 		// output hydro drag force?
 		if (channels.find("D") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
 				for (int J = 0; J < 3; J++)
-					*outfile << Dp[i][J] + Dq[i][J] + Ap[i][J] + Aq[i][J]
+					*outfile << Dp(J, i) + Dq(J, i) + Ap(J, i) + Aq(J, i)
 					         << "\t ";
 			}
 		}
 		// output segment tensions?
 		if (channels.find("t") != string::npos) {
 			for (unsigned int i = 0; i < N; i++) {
-				*outfile << T[i].norm() << "\t ";
+				*outfile << T.col(i).norm() << "\t ";
 				// >>> preparation below for switching to outputs at nodes
 				// <<< note that tension of end nodes will need weight and
 				// buoyancy adjustment
@@ -1276,14 +1640,14 @@ Line::Output(real time)
 				// else if (i==N)
 				//      *outfile << (T[i] - W[i]).norm() << "\t ";
 				// else
-				//	*outfile << T[i].norm() << "\t ";
+				//	*outfile << T.col(i).norm() << "\t ";
 			}
 		}
 		// output internal damping force?
 		if (channels.find("c") != string::npos) {
 			for (unsigned int i = 0; i < N; i++) {
 				for (int J = 0; J < 3; J++)
-					*outfile << Td[i][J] + Td[i][J] + Td[i][J] << "\t ";
+					*outfile << Td(J, i) + Td(J, i) + Td(J, i) << "\t ";
 			}
 		}
 		// output segment strains?
@@ -1302,7 +1666,7 @@ Line::Output(real time)
 		if (channels.find("b") != string::npos) {
 			for (unsigned int i = 0; i <= N; i++) {
 				for (int J = 0; J < 3; J++)
-					*outfile << B[i][J] << "\t ";
+					*outfile << B(J, i) << "\t ";
 			}
 		}
 
@@ -1411,21 +1775,21 @@ Line::getVTK() const
 {
 	auto points = vtkSmartPointer<vtkPoints>::New();
 	auto line = vtkSmartPointer<vtkPolyLine>::New();
-	// Node fields, i.e. r.size() number of tuples
-	auto vtk_rd = io::vtk_farray("rd", 3, r.size());
-	auto vtk_Kurv = io::vtk_farray("Kurv", 1, r.size());
-	auto vtk_M = io::vtk_farray("M", 9, r.size());
-	auto vtk_Fnet = io::vtk_farray("Fnet", 3, r.size());
-	// Segment fields, i.e. r.size()-1 number of tuples
-	auto vtk_lstr = io::vtk_farray("lstr", 1, r.size() - 1);
-	auto vtk_ldstr = io::vtk_farray("ldstr", 1, r.size() - 1);
-	auto vtk_V = io::vtk_farray("V", 1, r.size() - 1);
-
-	line->GetPointIds()->SetNumberOfIds(r.size());
-	for (unsigned int i = 0; i < r.size(); i++) {
-		points->InsertNextPoint(r[i][0], r[i][1], r[i][2]);
+	// Node fields, i.e. r.cols() number of tuples
+	auto vtk_rd = io::vtk_farray("rd", 3, r.cols());
+	auto vtk_Kurv = io::vtk_farray("Kurv", 1, r.cols());
+	auto vtk_M = io::vtk_farray("M", 9, r.cols());
+	auto vtk_Fnet = io::vtk_farray("Fnet", 3, r.cols());
+	// Segment fields, i.e. r.cols()-1 number of tuples
+	auto vtk_lstr = io::vtk_farray("lstr", 1, r.cols() - 1);
+	auto vtk_ldstr = io::vtk_farray("ldstr", 1, r.cols() - 1);
+	auto vtk_V = io::vtk_farray("V", 1, r.cols() - 1);
+
+	line->GetPointIds()->SetNumberOfIds(r.cols());
+	for (unsigned int i = 0; i < r.cols(); i++) {
+		points->InsertNextPoint(r(0, i), r(1, i), r(2, i));
 		line->GetPointIds()->SetId(i, i);
-		vtk_rd->SetTuple3(i, rd[i][0], rd[i][1], rd[i][2]);
+		vtk_rd->SetTuple3(i, rd(0, i), rd(1, i), rd(2, i));
 		vtk_Kurv->SetTuple1(i, Kurv[i]);
 		vtk_M->SetTuple9(i,
 		                 M[i](0, 0),
@@ -1437,8 +1801,8 @@ Line::getVTK() const
 		                 M[i](2, 0),
 		                 M[i](2, 1),
 		                 M[i](2, 2));
-		vtk_Fnet->SetTuple3(i, Fnet[i][0], Fnet[i][1], Fnet[i][2]);
-		if (i == r.size() - 1)
+		vtk_Fnet->SetTuple3(i, Fnet(0, i), Fnet(1, i), Fnet(2, i));
+		if (i == r.cols() - 1)
 			continue;
 		vtk_lstr->SetTuple1(i, lstr[i]);
 		vtk_ldstr->SetTuple1(i, ldstr[i]);
@@ -1501,7 +1865,7 @@ Line::drawGL(void)
 	glColor3f(0.5, 0.5, 1.0);
 	glBegin(GL_LINE_STRIP);
 	for (int i = 0; i <= N; i++) {
-		glVertex3d(r[i][0], r[i][1], r[i][2]);
+		glVertex3d(r(0, i), r(1, i), r(2, i));
 		if (i < N) {
 			normTen = getNodeTen(i).norm() / maxTen;
 			ColorMap(normTen, rgb);
@@ -1529,12 +1893,12 @@ Line::drawGL2(void)
 		ColorMap(normTen, rgb);
 		glColor3d(rgb[0], rgb[1], rgb[2]);
 
-		Cylinder(r[i][0],
-		         r[i][1],
-		         r[i][2],
-		         r[i + 1][0],
-		         r[i + 1][1],
-		         r[i + 1][2],
+		Cylinder(r(0, i),
+		         r(1, i),
+		         r(2, i),
+		         r(0, i + 1),
+		         r(1, i + 1),
+		         r(2, i + 1),
 		         27,
 		         0.5);
 	}
@@ -1543,12 +1907,12 @@ Line::drawGL2(void)
 		glColor3d(0.0, 0.2, 0.8);
 		double vscal = 5.0;
 
-		Arrow(r[i][0],
-		      r[i][1],
-		      r[i][2],
-		      vscal * rd[i][0],
-		      vscal * rd[i][1],
-		      vscal * rd[i][2],
+		Arrow(r(0, i),
+		      r(1, i),
+		      r(2, i),
+		      vscal * rd(0, i),
+		      vscal * rd(1, i),
+		      vscal * rd(2, i),
 		      0.1,
 		      0.7);
 	}
@@ -36,7 +36,9 @@
 
 #include "Misc.hpp"
 #include "IO.hpp"
+#include "State.hpp"
 #include <utility>
+#include <array>
 
 #ifdef USE_VTK
 #include <vtkSmartPointer.h>
@@ -49,6 +51,28 @@ namespace moordyn {
 
 class Waves;
 
+/** @brief Features of a line, which select the getStateDeriv() kernel
+ *
+ * A kernel is compiled for each combination of features, so the branches
+ * on the disabled ones are dropped at compile time
+ * @see moordyn::Line::getFeatures()
+ */
+typedef enum
+{
+	/// Nonlinear axial stiffness, from a lookup table
+	LINE_NONLINEAR_EA = 1 << 0,
+	/// Nonlinear internal damping, from a lookup table
+	LINE_NONLINEAR_C = 1 << 1,
+	/// Bending stiffness
+	LINE_BENDING = 1 << 2,
+	/// Water kinematics time series set for each node
+	LINE_WAVES_EXTERNAL = 1 << 3,
+	/// Water kinematics interpolated from the moordyn::Waves object
+	LINE_WAVES_GRID = 1 << 4,
+	/// Check the features at runtime, instead of at compile time
+	LINE_GENERIC = 1 << 5,
+} line_features;
+
 /** @class Line Line.hpp
  * @brief A mooring line
  *
@@ -96,6 +120,20 @@ class Line : public io::IO
 	 */
 	real getNonlinearEI(real curv);
 
+	/** @brief Resample a nonlinear curve on an uniform table
+	 *
+	 * The number of points is taken from EnvCond::CurvePoints, and the
+	 * maximum error is reported
+	 * @param curve The table
+	 * @param x The x values of the curve
+	 * @param y The y values of the curve
+	 * @param name The name of the curve, for the log
+	 */
+	void resampleCurve(UniformCurve& curve,
+	                   const std::vector<real>& x,
+	                   const std::vector<real>& y,
+	                   const char* name);
+
 	// ENVIRONMENTAL STUFF
 	/// Global struct that holds environmental settings
 	EnvCond* env;
@@ -162,63 +200,178 @@ class Line : public io::IO
 	std::vector<moordyn::real> dampXs;
 	/// y array for stress-strainrate lookup table
 	std::vector<moordyn::real> dampYs;
+	/// stress-strain lookup table resampled with uniform spacing
+	UniformCurve stiff_curve;
+	/// bent stiffness lookup table resampled with uniform spacing
+	UniformCurve bstiff_curve;
+	/// stress-strainrate lookup table resampled with uniform spacing
+	UniformCurve damp_curve;
+
+	// The per-node and per-segment quantities are stored as structures of
+	// arrays, i.e. 3xN blocks where each component is contiguous in memory,
+	// so getStateDeriv() can process the whole line with vectorized kernels
 
 	// kinematics
 	/// node positions
-	std::vector<vec> r;
+	vec3N r;
 	/// node velocities
-	std::vector<vec> rd;
+	vec3N rd;
 	/// unit tangent vectors for each node
-	std::vector<vec> q;
+	vec3N q;
 	/// unit tangent vectors for each segment (used in bending calcs)
-	std::vector<vec> qs;
+	vec3N qs;
 	/// unstretched line segment lengths
-	std::vector<moordyn::real> l;
+	vecN l;
 	/// stretched segment lengths
-	std::vector<moordyn::real> lstr;
+	vecN lstr;
 	/// rate of stretch
-	std::vector<moordyn::real> ldstr;
+	vecN ldstr;
 	/// curvatures at node points (1/m)
-	std::vector<moordyn::real> Kurv;
+	vecN Kurv;
 
 	/// node mass + added mass matrix
 	std::vector<mat> M;
+	/// fictitious mass of the internal nodes, 0 to use the actual masses
+	real fict_m;
 	// line segment volumes
-	std::vector<moordyn::real> V;
+	vecN V;
 
 	// forces
 	/// segment tensions
-	std::vector<vec> T;
+	vec3N T;
 	/// segment damping forces
-	std::vector<vec> Td;
+	vec3N Td;
 	/// bending stiffness forces
-	std::vector<vec> Bs;
+	vec3N Bs;
 	/// node weights
-	std::vector<vec> W;
+	vec3N W;
 	/// node drag (transversal)
-	std::vector<vec> Dp;
+	vec3N Dp;
 	/// node drag (axial)
-	std::vector<vec> Dq;
+	vec3N Dq;
 	/// node added mass forcing (transversal)
-	std::vector<vec> Ap;
+	vec3N Ap;
 	/// node added mass forcing (axial)
-	std::vector<vec> Aq;
+	vec3N Aq;
 	/// node bottom contact force
-	std::vector<vec> B;
+	vec3N B;
 	/// total force on node
-	std::vector<vec> Fnet;
+	vec3N Fnet;
 
 	// wave things
 	/// VOF scalar for each segment (1 = fully submerged, 0 = out of water)
-	std::vector<moordyn::real> F;
+	vecN F;
 	/// free surface elevations
-	std::vector<moordyn::real> zeta;
+	vecN zeta;
 	/// dynamic pressures
-	std::vector<moordyn::real> PDyn;
+	vecN PDyn;
 	/// wave velocities
-	std::vector<vec> U;
+	vec3N U;
 	/// wave accelerations
-	std::vector<vec> Ud;
+	vec3N Ud;
+	/// wave grid cells of each node, used as search hints by the waves
+	std::vector<ivec> wave_cells;
+
+	/// Per-segment work array for getStateDeriv()
+	vecN seg_w;
+	/// Per-node work array for getStateDeriv()
+	vecN node_w1;
+	/// Per-node work array for getStateDeriv()
+	vecN node_w2;
+
+	// quasi-static model
+	/// true if the line is solved as a quasi-static catenary
+	bool quasi_static;
+	/// horizontal fairlead tension of the last catenary solution
+	real qs_HF;
+	/// vertical fairlead tension of the last catenary solution
+	real qs_VF;
+	/// number of catenary solutions that failed
+	unsigned int qs_fails;
+	/// unstretched arc length of each node from the lowest end point
+	std::vector<real> qs_s;
+	/// horizontal catenary coordinate of each node
+	std::vector<real> qs_X;
+	/// vertical catenary coordinate of each node
+	std::vector<real> qs_Z;
+	/// catenary tension at each node
+	std::vector<real> qs_Te;
+
+	/** @brief Lump a per-segment quantity on the nodes
+	 *
+	 * Each node gets the sum of the values of its adjacent segments, i.e.
+	 * the end nodes just get the value of a single segment
+	 * @param seg The per-segment values, with moordyn::Line::N components
+	 * @param node The output per-node values, with moordyn::Line::N + 1
+	 * components
+	 */
+	template<typename Derived>
+	inline void lumpSegments(const Eigen::MatrixBase<Derived>& seg,
+	                         vecN& node) const
+	{
+		node.head(N) = seg;
+		node[N] = 0.0;
+		node.tail(N) += seg;
+	}
+
+	/// A getStateDeriv() kernel
+	typedef void (Line::*deriv_kernel)(DLineStateDt&);
+
+	/// The getStateDeriv() kernel bound at initialize()
+	deriv_kernel kernel;
+
+	/** @brief Get the getStateDeriv() kernel for a set of features
+	 * @param features The features, see moordyn::line_features
+	 * @return The kernel
+	 */
+	static deriv_kernel getKernel(unsigned int features);
+
+	/** @brief Build the table of specialized getStateDeriv() kernels
+	 * @return The kernels
+	 */
+	template<std::size_t... I>
+	static constexpr std::array<deriv_kernel, sizeof...(I)> makeKernels(
+	    std::index_sequence<I...>);
+
+	/** @brief Check whether a kernel shall consider a feature
+	 *
+	 * For the specialized kernels this is a compile time constant, so the
+	 * branches depending on it are optimized out
+	 * @param f The feature
+	 * @return true if the feature shall be considered, false otherwise
+	 */
+	template<unsigned int FEATS>
+	inline bool has(line_features f) const
+	{
+		if constexpr ((FEATS & LINE_GENERIC) != 0)
+			return (getFeatures() & f) != 0;
+		else
+			return (FEATS & f) != 0;
+	}
+
+	/** @brief Calculate forces and get the derivative of the line's states
+	 * @param drdt The output states derivative
+	 * @see moordyn::Line::getStateDeriv()
+	 */
+	template<unsigned int FEATS>
+	void stateDerivKernel(DLineStateDt& drdt);
+
+	/** @brief Solve the quasi-static catenary
+	 *
+	 * The internal nodes positions, the segments tensions and the end
+	 * points forces are computed with the Catenary() solver, starting the
+	 * iterations from the previous solution. The line has no states, so
+	 * @p drdt is not modified
+	 * @param drdt The output states derivative, with 0 columns
+	 * @see moordyn::Line::isQuasiStatic()
+	 */
+	void quasiStaticKernel(DLineStateDt& drdt);
+
+	/** @brief Setup the quasi-static model, solving the initial catenary
+	 * @throws invalid_value_error If the line is not heavier than water, or
+	 * the catenary cannot be solved
+	 */
+	void initializeQuasiStatic();
 
 	// time
 	/// simulation time
@@ -294,13 +447,16 @@ class Line : public io::IO
 	 * @param n Number of segments
 	 * @param outfile The outfile where information shall be witten
 	 * @param channels The channels/fields that shall be printed in the file
+	 * @param quasi_static true if the line shall be solved as a quasi-static
+	 * catenary, see moordyn::Line::isQuasiStatic()
 	 */
 	void setup(int number,
 	           LineProps* props,
 	           real l,
 	           unsigned int n,
 	           shared_ptr<ofstream> outfile,
-	           string channels);
+	           string channels,
+	           bool quasi_static = false);
 
 	/** @brief Set the environmental data
 	 * @param env_in Global struct that holds environmental settings
@@ -310,12 +466,13 @@ class Line : public io::IO
 
 	/** @brief Compute the stationary Initial Condition (IC)
 	 * @param return The states, i.e. the positions of the internal nodes
-	 * (first) and the velocities of the internal nodes (second)
+	 * (first) and the velocities of the internal nodes (second), with a column
+	 * per node
 	 * @throws moordyn::output_file_error If an outfile has been provided, but
 	 * it cannot be written
 	 * @throws invalid_value_error If there is no enough water depth
 	 */
-	std::pair<std::vector<vec>, std::vector<vec>> initialize();
+	std::pair<vec3N, vec3N> initialize();
 
 	/** @brief Number of segments
 	 *
@@ -324,6 +481,15 @@ class Line : public io::IO
 	 */
 	inline unsigned int getN() const { return N; }
 
+	/** @brief Check whether the line is solved as a quasi-static catenary
+	 *
+	 * Such lines are selected with the QSLines option, and they have no
+	 * states, i.e. the time integrator shall register 0 internal nodes for
+	 * them
+	 * @return true if the line is quasi-static, false otherwise
+	 */
+	inline bool isQuasiStatic() const { return quasi_static; }
+
 	/** @brief Get the unstretched length of the line
 	 * @return The unstretched length, moordyn::Line::UnstrLen
 	 */
@@ -375,6 +541,41 @@ class Line : public io::IO
 		setUnstretchedLength(UnstrLen0 + dt * UnstrLend);
 	}
 
+	/** @brief Get the axial stiffness of a segment
+	 *
+	 * For nonlinear stiffness lines the slope at the last point of the
+	 * stress-strain lookup table is considered
+	 * @return The axial stiffness, \f$ E A / l \f$. 0 if the unstretched
+	 * length is not known yet
+	 */
+	real getSegmentStiffness() const;
+
+	/** @brief Get the critical time step of the line
+	 *
+	 * The highest natural frequency of the discretized line, \f$ \omega \f$,
+	 * is estimated from the axial stiffness, the bending stiffness and the
+	 * seabed stiffness, considering the added mass. The critical time step is
+	 * then \f$ 2 / \omega \f$, i.e. the stability limit of the central
+	 * differences scheme on an undamped system
+	 * @param axial false if the axial stiffness shall not be considered,
+	 * e.g. because it is integrated implicitly
+	 * @return The critical time step. Infinity if the unstretched length is
+	 * not known yet, i.e. it is relative to the end points distance and the
+	 * line has not been initialized, or if the line is quasi-static
+	 */
+	real getCriticalTimeStep(bool axial = true) const;
+
+	/** @brief Replace the nodes masses by fictitious ones
+	 *
+	 * The fictitious masses are the smallest ones granting that the critical
+	 * time step is the given one. The static equilibrium does not depend on
+	 * the masses, so they can be used to relax the line as fast as the time
+	 * step allows
+	 * @param dt The critical time step. 0 to restore the actual masses
+	 * @see moordyn::Line::getCriticalTimeStep()
+	 */
+	void setFictitiousMass(real dt);
+
 	/** @brief Get the position of a node
 	 * @param i The line node index
 	 * @return The position
@@ -388,7 +589,23 @@ class Line : public io::IO
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
-		return r[i];
+		return r.col(i);
+	}
+
+	/** @brief Get the velocity of a node
+	 * @param i The line node index
+	 * @return The velocity
+	 * @throws invalid_value_error If the node index \p i is bigger than the
+	 * number of nodes, moordyn::Line::N + 1
+	 */
+	inline vec getNodeVel(unsigned int i) const
+	{
+		if (i > N) {
+			LOGERR << "Asking node " << i << " of line " << number
+			       << ", which only has " << N + 1 << " nodes" << std::endl;
+			throw moordyn::invalid_value_error("Invalid node index");
+		}
+		return rd.col(i);
 	}
 
 	/** @brief Get the tension in a node
@@ -407,13 +624,15 @@ class Line : public io::IO
 			       << ", which only has " << N + 1 << " nodes" << std::endl;
 			throw moordyn::invalid_value_error("Invalid node index");
 		}
+		if (((i == 0) || (i == N)) && quasi_static)
+			return Fnet.col(i);
 		if ((i == 0) || (i == N))
 			return (
-			    Fnet[i] +
+			    Fnet.col(i) +
 			    vec(0.0, 0.0, M[i](0, 0) * (-env->g))); // <<< update to use W
 
 		// take average of tension in adjacent segments
-		return (0.5 * (T[i] + T[i - 1]));
+		return (0.5 * (T.col(i) + T.col(i - 1)));
 	};
 
 	/** @brief Get the line curvature at a node position
@@ -438,7 +657,13 @@ class Line : public io::IO
 	/** @brief Get the array of coordinates of all nodes along the line
 	 * @return The positions array
 	 */
-	inline std::vector<vec> getNodeCoordinates() const { return r; }
+	inline std::vector<vec> getNodeCoordinates() const
+	{
+		std::vector<vec> coords(N + 1);
+		for (unsigned int i = 0; i <= N; i++)
+			coords[i] = r.col(i);
+		return coords;
+	}
 
 	/** @brief Set the water flow velocity and acceleration at the line nodes
 	 *
@@ -459,8 +684,36 @@ class Line : public io::IO
 			       << std::endl;
 			throw moordyn::invalid_value_error("Invalid size");
 		}
-		U = U_in;
-		Ud = Ud_in;
+		setNodeWaveKin(U_in, Ud_in, 0);
+	}
+
+	/** @brief Set the water flow velocity and acceleration at the line nodes
+	 *
+	 * This is the same than setNodeWaveKin(const std::vector<vec>&,
+	 * const std::vector<vec>&), but the data for this line is taken from a
+	 * larger list, without needing to slice it
+	 * @param U_in Velocities
+	 * @param Ud_in Accelerations
+	 * @param first Index of the first component on @p U_in and @p Ud_in
+	 * corresponding to this line. (moordyn::Line::N + 1) components are read
+	 * from there
+	 * @throws invalid_value_error If either @p U_in or @p Ud_in have not
+	 * enough components
+	 */
+	inline void setNodeWaveKin(const std::vector<vec>& U_in,
+	                           const std::vector<vec>& Ud_in,
+	                           unsigned int first)
+	{
+		if ((U_in.size() < first + N + 1) || (Ud_in.size() < first + N + 1)) {
+			LOGERR << "Invalid input size " << U_in.size() << " & "
+			       << Ud_in.size() << ". " << first + N + 1
+			       << " was expected at least" << std::endl;
+			throw moordyn::invalid_value_error("Invalid size");
+		}
+		for (unsigned int i = 0; i <= N; i++) {
+			U.col(i) = U_in[first + i];
+			Ud.col(i) = Ud_in[first + i];
+		}
 	}
 
 	/** @brief Get the tensions at the fairlead and anchor in a FASTv7 friendly
@@ -475,10 +728,12 @@ class Line : public io::IO
 	                        float* AnchHTen,
 	                        float* AnchVTen) const
 	{
-		*FairHTen = (float)(Fnet[N](Eigen::seqN(0, 2)).norm());
-		*FairVTen = (float)(Fnet[N][2] + M[N](0, 0) * (-env->g));
-		*AnchHTen = (float)(Fnet[0](Eigen::seqN(0, 2)).norm());
-		*AnchVTen = (float)(Fnet[0][2] + M[0](0, 0) * (-env->g));
+		// The quasi-static end forces are already the tensions
+		const real g = quasi_static ? 0.0 : -env->g;
+		*FairHTen = (float)(Fnet.col(N).head<2>().norm());
+		*FairVTen = (float)(Fnet(2, N) + M[N](0, 0) * g);
+		*AnchHTen = (float)(Fnet.col(0).head<2>().norm());
+		*AnchVTen = (float)(Fnet(2, 0) + M[0](0, 0) * g);
 	}
 
 	/** @brief Get the force, moment and mass at the line endpoint
@@ -496,12 +751,12 @@ class Line : public io::IO
 	{
 		switch (end_point) {
 			case ENDPOINT_TOP:
-				Fnet_out = Fnet[N];
+				Fnet_out = Fnet.col(N);
 				Moment_out = endMomentB;
 				M_out = M[N];
 				break;
 			case ENDPOINT_BOTTOM:
-				Fnet_out = Fnet[0];
+				Fnet_out = Fnet.col(0);
 				Moment_out = endMomentA;
 				M_out = M[0];
 				break;
@@ -571,13 +826,16 @@ class Line : public io::IO
 	inline void setTime(real time) { t = time; }
 
 	/** @brief Set the line state
-	 * @param r The moordyn::Line::getN() - 1 positions
-	 * @param u The moordyn::Line::getN() - 1 velocities
+	 * @param r The moordyn::Line::getN() - 1 positions, one column per node
+	 * @param u The moordyn::Line::getN() - 1 velocities, one column per node
 	 * @note This method is not affecting the line end points
+	 * @note The quasi-static lines have no states, so @p r and @p u shall
+	 * have 0 columns, see moordyn::Line::isQuasiStatic()
 	 * @see moordyn::Line::setEndState
 	 * @throws invalid_value_error If either @p r or @p u have wrong sizes
 	 */
-	void setState(std::vector<vec> r, std::vector<vec> u);
+	void setState(const Eigen::Ref<const vec3N>& r,
+	              const Eigen::Ref<const vec3N>& u);
 
 	/** @brief Set the position and velocity of an end point
 	 * @param r Position
@@ -588,6 +846,19 @@ class Line : public io::IO
 	 */
 	void setEndKinematics(vec r, vec rd, EndPoints end_point);
 
+	/** @brief Move an end point, without modifying the way it is attached
+	 *
+	 * This is useful to interpolate the end points motion while the line is
+	 * integrated on its own
+	 * @param r Position
+	 * @param rd Velocity
+	 * @param end_point Either ENDPOINT_TOP or ENDPOINT_BOTTOM
+	 * @throws invalid_value_error If @p end_point is not a valid end point
+	 * qualifier
+	 * @see moordyn::Line::setEndKinematics
+	 */
+	void moveEndPoint(const vec& r, const vec& rd, EndPoints end_point);
+
 	/** @brief set end node unit vector
 	 *
 	 * This method is called by an eventually attached Rod, only applicable for
@@ -616,12 +887,80 @@ class Line : public io::IO
 	 */
 	vec getEndSegmentMoment(EndPoints end_point, EndPoints rod_end_point) const;
 
+	/** @brief Get the mass matrix of a node, including the added mass
+	 * @param i The line node index
+	 * @return The mass matrix
+	 * @note The mass matrices are computed on getStateDeriv()
+	 */
+	inline const mat& getNodeMass(unsigned int i) const { return M[i]; }
+
+	/** @brief Get the linearized axial forces of the segments
+	 *
+	 * The tension and the internal damping forces of each segment are
+	 * linearized with respect to the relative position and velocity of its
+	 * end nodes, considering the current state. The slack segments are not
+	 * contributing
+	 * @param K The N stiffness matrices, i.e. the derivative of the force
+	 * on the first node of each segment with respect to the position of the
+	 * second node. The vector is resized if needed
+	 * @param C The N damping matrices, i.e. the derivative of the force on
+	 * the first node of each segment with respect to the velocity of the
+	 * second node. The vector is resized if needed
+	 */
+	void getAxialJacobian(std::vector<mat>& K, std::vector<mat>& C);
+
+	/** @brief Find the static equilibrium of the internal nodes
+	 *
+	 * The end points are kept fixed, while the net forces on the internal
+	 * nodes are driven to zero with Newton iterations. The Jacobian of the
+	 * tension and seabed forces is block tridiagonal, so each iteration is
+	 * solved in O(N) operations. The bending stiffness is left out of the
+	 * Jacobian, which is regularized with a pseudo-transient mass term, so
+	 * slack lines can find their way from a straight initial profile
+	 * @param tol The tolerance, i.e. the maximum acceptable acceleration
+	 * of the internal nodes
+	 * @param max_iters The maximum number of iterations
+	 * @return The remaining maximum acceleration of the internal nodes
+	 * @note The velocities of the internal nodes are set to zero
+	 * @note The quasi-static lines are already in equilibrium, so nothing
+	 * is done on them
+	 * @throws nan_error If nan values are detected in any node position
+	 */
+	real solveStatics(real tol, unsigned int max_iters);
+
 	/** @brief Calculate forces and get the derivative of the line's states
-	 * @return The velocties of the internal nodes (first) and the accelerations
-	 * of the internal nodes (second)
+	 *
+	 * The derivative is written in place, so no memory is allocated
+	 * @param drdt The output states derivative, i.e. the velocities of the
+	 * internal nodes and their accelerations. Both arrays shall have
+	 * moordyn::Line::getN() - 1 columns already
 	 * @throws nan_error If nan values are detected in any node position
+	 * @note The kernel specialized for the line features is used, see
+	 * moordyn::Line::getFeatures()
+	 */
+	inline void getStateDeriv(DLineStateDt& drdt) { (this->*kernel)(drdt); }
+
+	/** @brief Calculate forces and get the derivative of the line's states
+	 * with the kernel specialized for a set of features
+	 *
+	 * This is meant for testing purposes. The kernels of nonlinear
+	 * stiffness, nonlinear damping and bending produce the same results on
+	 * lines without such features, but the water kinematics shall match the
+	 * ones of the line
+	 * @param drdt The output states derivative
+	 * @param features The features, see moordyn::line_features.
+	 * moordyn::LINE_GENERIC to check the features at runtime
+	 * @throws nan_error If nan values are detected in any node position
+	 */
+	inline void getStateDeriv(DLineStateDt& drdt, unsigned int features)
+	{
+		(this->*getKernel(features))(drdt);
+	}
+
+	/** @brief Get the features of the line
+	 * @return The features, see moordyn::line_features
 	 */
-	std::pair<std::vector<vec>, std::vector<vec>> getStateDeriv();
+	unsigned int getFeatures() const;
 
 	// void initiateStep(vector<double> &rFairIn, vector<double> &rdFairIn,
 	// double time);
@@ -325,6 +325,65 @@ GetCurvature(moordyn::real length, const vec& q1, const vec& q2)
 	return 4.0 / length * sqrt(0.5 * (1.0 - q1_dot_q2));
 }
 
+real
+UniformCurve::resample(const vector<real>& xp,
+                       const vector<real>& yp,
+                       unsigned int n)
+{
+	if ((xp.size() < 2) || (xp.size() != yp.size()) || (n < 2))
+		throw moordyn::invalid_value_error("Invalid curve size");
+	if (!(xp.back() > xp.front()))
+		throw moordyn::invalid_value_error("Null curve range");
+
+	x0 = xp.front();
+	const real dx = (xp.back() - xp.front()) / (n - 1);
+	inv_dx = 1.0 / dx;
+	y.resize(n);
+	unsigned int j = 1;
+	for (unsigned int i = 0; i < n - 1; i++) {
+		const real x = x0 + i * dx;
+		while ((j < xp.size() - 1) && (x > xp[j]))
+			j++;
+		const real f = (x - xp[j - 1]) / (xp[j] - xp[j - 1]);
+		y[i] = yp[j - 1] + f * (yp[j] - yp[j - 1]);
+	}
+	y.back() = yp.back();
+
+	// Both the curve and the table are piecewise linear, and the table is
+	// exact on its own points, so the largest error is found on the curve
+	// points
+	real err = 0.0;
+	for (unsigned int i = 0; i < xp.size(); i++)
+		err = std::max(err, std::abs((*this)(xp[i]) - yp[i]));
+	return err;
+}
+
+void
+solve_block_tridiagonal(std::vector<mat>& D,
+                        const std::vector<mat>& U,
+                        Eigen::Ref<vec3N> b)
+{
+	const unsigned int n = b.cols();
+	if (!n)
+		return;
+
+	// Forward elimination, keeping the inverted diagonal blocks
+	D[0] = D[0].inverse().eval();
+	for (unsigned int i = 1; i < n; i++) {
+		const mat W = U[i - 1].transpose() * D[i - 1];
+		D[i] -= W * U[i - 1];
+		b.col(i) -= W * b.col(i - 1);
+		D[i] = D[i].inverse().eval();
+	}
+
+	// Back substitution
+	b.col(n - 1) = (D[n - 1] * b.col(n - 1)).eval();
+	for (int i = n - 2; i >= 0; i--) {
+		const vec x = D[i] * (b.col(i) - U[i] * b.col(i + 1));
+		b.col(i) = x;
+	}
+}
+
 } // ::moordyn
 
 /*
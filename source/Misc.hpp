@@ -107,6 +107,9 @@ typedef Eigen::Matrix3f mat3;
 typedef Eigen::Matrix4f mat4;
 typedef Eigen::Matrix6f mat6;
 typedef mat3 mat;
+typedef Eigen::VectorXf vecN;
+typedef Eigen::Matrix<float, 3, Eigen::Dynamic, Eigen::RowMajor> vec3N;
+typedef Eigen::MatrixXf matN;
 #else
 typedef double real;
 typedef Eigen::Vector2d vec2;
@@ -119,6 +122,9 @@ typedef Eigen::Matrix3d mat3;
 typedef Eigen::Matrix4d mat4;
 typedef Eigen::Matrix6d mat6;
 typedef mat3 mat;
+typedef Eigen::VectorXd vecN;
+typedef Eigen::Matrix<double, 3, Eigen::Dynamic, Eigen::RowMajor> vec3N;
+typedef Eigen::MatrixXd matN;
 #endif
 typedef Eigen::Vector2i ivec2;
 typedef Eigen::Vector3i ivec3;
@@ -559,6 +565,8 @@ typedef enum
 	WAVES_NODE = 5,
 	/// velocity, acceleration, and wave elevation grid data
 	WAVES_KIN = 6,
+	/// Wave elevation time series, spectral components summed on the nodes
+	WAVES_SPECTRAL = 7,
 } waves_settings;
 
 // Current options: 0 - no currents or set externally (as part of WaveKin =0 or
@@ -586,6 +594,18 @@ typedef enum
 	CURRENTS_DYNAMIC_NODE = 4,
 } currents_settings;
 
+/** @brief Available precisions to store the waves grid
+ */
+typedef enum
+{
+	/// The same precision than the rest of the solver, see moordyn::real
+	WAVES_PREC_REAL = 0,
+	/// 32-bit floating point
+	WAVES_PREC_FLOAT = 1,
+	/// 16-bit fixed point, scaled on each field and grid point
+	WAVES_PREC_FIXED16 = 2,
+} waves_precision;
+
 /** @brief Are the waves settings grid based?
  * @param opt Waves settings
  * @return true if the waves are provided in a grid, false otherwise
@@ -755,6 +775,78 @@ interp(const vector<Tx>& xp, const vector<Ty>& yp, Tx x)
 	return yp[j - 1] + f * (yp[j] - yp[j - 1]);
 }
 
+/** @brief Piecewise linear curve resampled on an uniformly spaced table
+ *
+ * The evaluation of the curve takes a constant time, without looking for
+ * the interval the point belongs to, as interp() does. Out of the range of
+ * the curve the closest end value is returned, as interp() does
+ */
+class UniformCurve
+{
+  public:
+	/** @brief Constructor
+	 */
+	UniformCurve()
+	  : x0(0.0)
+	  , inv_dx(0.0)
+	{
+	}
+
+	/** @brief Resample a curve
+	 * @param xp The points where data is available, monotonically
+	 * increasing
+	 * @param yp The data values
+	 * @param n The number of points of the table, at least 2
+	 * @return The maximum absolute error of the table on the curve points,
+	 * which is the maximum error along the whole curve
+	 * @throws moordyn::invalid_value_error If the curve has less than 2
+	 * points, or its range is null
+	 */
+	real resample(const vector<real>& xp,
+	              const vector<real>& yp,
+	              unsigned int n);
+
+	/** @brief Check whether the table is empty, i.e. the curve has not been
+	 * resampled yet
+	 * @return true if the table is empty, false otherwise
+	 */
+	inline bool empty() const { return y.size() == 0; }
+
+	/** @brief Evaluate the curve
+	 * @param x The evaluation point
+	 * @return The interpolated value
+	 */
+	inline real operator()(real x) const
+	{
+		const unsigned int n = y.size() - 1;
+		const real s = std::min(std::max((x - x0) * inv_dx, (real)0.0),
+		                        (real)n);
+		const unsigned int i = std::min((unsigned int)s, n - 1);
+		const real f = s - i;
+		return y[i] + f * (y[i + 1] - y[i]);
+	}
+
+	/** @brief Evaluate the curve on a set of points
+	 * @param x The evaluation points
+	 * @param v The interpolated values. It shall have the same size as x
+	 */
+	template<typename Derived, typename DerivedOut>
+	inline void eval(const Eigen::MatrixBase<Derived>& x,
+	                 Eigen::MatrixBase<DerivedOut>& v) const
+	{
+		for (Eigen::Index i = 0; i < x.size(); i++)
+			v[i] = (*this)(x[i]);
+	}
+
+  private:
+	/// The first point of the table
+	real x0;
+	/// The inverse of the table spacing
+	real inv_dx;
+	/// The table values
+	std::vector<real> y;
+};
+
 /** @brief Bilinear filter
  * @param values The available data
  * @param i The upper bound index in the x direction
@@ -904,6 +996,42 @@ unitvector(vec& u, const vec& r1, const vec& r2)
 	return l;
 }
 
+/** @brief Compute the norms of a set of 3D vectors stored as columns
+ *
+ * The components are processed as contiguous rows, so the operation can be
+ * vectorized on moordyn::vec3N arrays
+ * @param v The 3xN array of vectors
+ * @param l The output norms, with N components
+ */
+template<typename T>
+inline void
+colnorms(const Eigen::MatrixBase<T>& v, vecN& l)
+{
+	l = (v.row(0).array().square() + v.row(1).array().square() +
+	     v.row(2).array().square())
+	        .sqrt()
+	        .transpose();
+}
+
+/** @brief Compute the dot products of two sets of 3D vectors stored as
+ * columns
+ * @param a The first 3xN array of vectors
+ * @param b The second 3xN array of vectors
+ * @param p The output dot products, with N components
+ * @see colnorms()
+ */
+template<typename T1, typename T2>
+inline void
+coldots(const Eigen::MatrixBase<T1>& a,
+        const Eigen::MatrixBase<T2>& b,
+        vecN& p)
+{
+	p = (a.row(0).array() * b.row(0).array() +
+	     a.row(1).array() * b.row(1).array() +
+	     a.row(2).array() * b.row(2).array())
+	        .transpose();
+}
+
 /** @brief Compute a vector with the same direction but different length
  * @param u The input vector
  * @param newlength The new length of the output vector
@@ -1076,6 +1204,126 @@ orientationAngles(vec q);
 moordyn::real
 GetCurvature(moordyn::real length, const vec& q1, const vec& q2);
 
+/** @brief Solve a block tridiagonal linear system with 3x3 blocks
+ *
+ * The Thomas algorithm is applied, so the system is solved in O(n)
+ * operations. There is no pivoting, so the system shall be either diagonally
+ * dominant or symmetric positive definite
+ * @param D The n diagonal blocks. They are overwritten by the factorization
+ * @param U The n - 1 upper diagonal blocks. The lower diagonal blocks are
+ * their transposes
+ * @param b The right hand side, with a column per block. It is overwritten
+ * by the solution
+ */
+void
+solve_block_tridiagonal(std::vector<mat>& D,
+                        const std::vector<mat>& U,
+                        Eigen::Ref<vec3N> b);
+
+/** @brief Cached solver of symmetric positive definite mass matrices
+ *
+ * The 6x6 mass matrices of the rods and bodies are factorized with a LDLT
+ * decomposition, which is cheaper than the general purpose QR one. For 3x3
+ * matrices the closed form inverse is still faster, even if it is computed
+ * every time.
+ *
+ * Moreover, since they change slowly, the factorization is reused while
+ * the matrix has not changed beyond a tolerance, correcting the solution
+ * with an iterative refinement step using the actual matrix. That way the
+ * error is of the order of the squared relative change of the matrix.
+ *
+ * The relative change of each component is measured against the diagonal,
+ * i.e. \f$ |M_{ij} - M^0_{ij}| \leq tol \sqrt{M^0_{ii} M^0_{jj}} \f$, so
+ * the translational and rotational blocks are not mixed up
+ */
+template<int N>
+class MassSolver
+{
+  public:
+	/// The matrix type
+	typedef Eigen::Matrix<real, N, N> matrix;
+	/// The vector type
+	typedef Eigen::Matrix<real, N, 1> vector;
+
+	/** @brief Constructor
+	 */
+	MassSolver()
+	  : _valid(false)
+	  , _n(0)
+	{
+	}
+
+	/** @brief Solve the system \f$ M a = f \f$
+	 * @param m The mass matrix
+	 * @param f The force
+	 * @param tol The relative change of the matrix below which the former
+	 * factorization is reused. 0 to always factorize the matrix
+	 * @return The acceleration
+	 */
+	vector solve(const matrix& m, const vector& f, real tol)
+	{
+		if (!reusable(m, tol)) {
+			factorize(m);
+			return apply(f);
+		}
+		const vector a = apply(f);
+		return a + apply(f - m * a);
+	}
+
+	/** @brief Get the number of factorizations carried out so far
+	 * @return The number of factorizations
+	 */
+	inline unsigned long factorizations() const { return _n; }
+
+	/** @brief Drop the factorization, so it is computed again on the next
+	 * solve
+	 */
+	inline void reset() { _valid = false; }
+
+  private:
+	/** @brief Factorize a matrix
+	 * @param m The mass matrix
+	 */
+	void factorize(const matrix& m)
+	{
+		_ldlt.compute(m);
+		_m = m;
+		const vector s = m.diagonal().cwiseAbs().cwiseSqrt();
+		_scale = s * s.transpose();
+		_valid = true;
+		_n++;
+	}
+
+	/** @brief Apply the inverse of the factorized matrix
+	 * @param f The force
+	 * @return The acceleration
+	 */
+	inline vector apply(const vector& f) const { return _ldlt.solve(f); }
+
+	/** @brief Check whether the cached factorization can be used
+	 * @param m The mass matrix
+	 * @param tol The relative tolerance
+	 * @return true if the factorization can be reused, false otherwise
+	 */
+	bool reusable(const matrix& m, real tol) const
+	{
+		if (!_valid || (tol <= 0.0))
+			return false;
+		return ((m - _m).cwiseAbs().array() <= tol * _scale.array()).all();
+	}
+
+	/// The factorization
+	Eigen::LDLT<matrix> _ldlt;
+	/// The factorized matrix
+	matrix _m;
+	/// The scale of each component of the matrix
+	matrix _scale;
+	/// Whether there is a factorization at all
+	bool _valid;
+	/// The number of factorizations
+	unsigned long _n;
+};
+
 /**
  * @}
  */
@@ -1150,6 +1398,20 @@ typedef struct
 	moordyn::currents_settings Current;
 	/// time step used to downsample wave elevation data with
 	double dtWave;
+	/// precision of the stored waves grid
+	moordyn::waves_precision WavePrec;
+	/// whether to cache the waves grid on disk (0=no, 1=yes)
+	int WaveCache;
+	/// length of the streamed waves grid windows (0=no streaming)
+	double WaveWindow;
+	/// whether to fit the waves grid to the nodes (0=no, 1=yes)
+	int WaveGridFit;
+	/// margin around the nodes of the fitted waves grid (m)
+	double WaveGridMargin;
+	/// horizontal spacing of the fitted waves grid (m)
+	double WaveGridDx;
+	/// number of depths of the fitted waves grid
+	int WaveGridNz;
 
 	/// general bottom friction coefficient, as a start
 	double FrictionCoefficient;
@@ -1158,6 +1420,13 @@ typedef struct
 	/// a ratio of static to dynamic friction ( = mu_static/mu_dynamic)
 	double StatDynFricScale;
 
+	/// relative change of the rods and bodies mass matrices below which
+	/// their factorization is reused (0=always factorize, the default)
+	double MassTol;
+	/// number of points of the uniform tables where the lines nonlinear
+	/// curves are resampled (0=use the curves as they are)
+	int CurvePoints;
+
 	/// a global switch for whether to show the units line in the output files
 	/// (1, default), or skip it (0)
 	int WriteUnits;
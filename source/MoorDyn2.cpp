@@ -37,6 +37,7 @@
 #ifdef LINUX
 #include <cmath>
 #include <ctype.h>
+#include <limits>
 
 // contributed by Yi-Hsiang Yu at NREL
 #define isnan(x) std::isnan(x)
@@ -61,13 +62,16 @@ moordyn::MoorDyn::MoorDyn(const char* infilename)
   , _filepath("Mooring/lines.txt")
   , _basename("lines")
   , _basepath("Mooring/")
+  , ICmethod("relaxation")
   , ICDfac(5.0)
   , ICdt(1.0)
   , ICTmax(120.0)
   , ICthresh(0.001)
   , WaveKinTemp(WAVES_NONE)
   , dtM0(0.001)
+  , dtM_auto(false)
   , dtOut(0.0)
+  , nThreads(1)
   , _t_integrator(NULL)
   , GroundBody(NULL)
   , waves(NULL)
@@ -113,11 +117,20 @@ moordyn::MoorDyn::MoorDyn(const char* infilename)
 	env.WaveKin = moordyn::WAVES_NONE;
 	env.Current = moordyn::CURRENTS_NONE;
 	env.dtWave = 0.25;
+	env.WavePrec = moordyn::WAVES_PREC_REAL;
+	env.WaveCache = 0;
+	env.WaveWindow = 0.0;
+	env.WaveGridFit = 0;
+	env.WaveGridMargin = 20.0;
+	env.WaveGridDx = 5.0;
+	env.WaveGridNz = 16;
 	env.WriteUnits = 1; // by default, write units line
 	env.writeLog = 0;   // by default, don't write out a log file
 	env.FrictionCoefficient = 0.0;
 	env.FricDamp = 200.0;
 	env.StatDynFricScale = 1.0;
+	env.MassTol = 0.0; // by default, always factorize the mass matrices
+	env.CurvePoints = 1024;
 
 	const moordyn::error_id err = ReadInFile();
 	MOORDYN_THROW(err, "Exception while reading the input file");
@@ -163,6 +176,31 @@ moordyn::MoorDyn::~MoorDyn()
 	delete _log;
 }
 
+moordyn::real
+moordyn::MoorDyn::GetStableTimeStep(std::string* obj) const
+{
+	real dt = std::numeric_limits<real>::infinity();
+	if (!_t_integrator)
+		return dt;
+	for (auto line : LineList) {
+		const real dt_obj = _t_integrator->GetStableTimeStep(line);
+		if (dt_obj < dt) {
+			dt = dt_obj;
+			if (obj)
+				*obj = "Line " + to_string(line->number);
+		}
+	}
+	for (auto rod : RodList) {
+		const real dt_obj = _t_integrator->GetStableTimeStep(rod);
+		if (dt_obj < dt) {
+			dt = dt_obj;
+			if (obj)
+				*obj = "Rod " + to_string(rod->number);
+		}
+	}
+	return dt;
+}
+
 moordyn::error_id
 moordyn::MoorDyn::Init(const double* x, const double* xd, bool skip_ic)
 {
@@ -255,9 +293,88 @@ moordyn::MoorDyn::Init(const double* x, const double* xd, bool skip_ic)
 	// Initialize the system state
 	_t_integrator->init();
 
+	// Check the time step against the stability limit of the time scheme,
+	// now that all the lines lengths are known
+	string dt_obj;
+	const real dt_stable = GetStableTimeStep(&dt_obj);
+	if (std::isinf(dt_stable)) {
+		if (dtM_auto) {
+			LOGWRN << "The stable time step cannot be estimated, dtM = "
+			       << dtM0 << " s will be used" << endl;
+		}
+	} else {
+		LOGMSG << "Estimated stable time step = " << dt_stable
+		       << " s, governed by " << dt_obj << endl;
+		if (dtM_auto) {
+			dtM0 = dt_stable;
+			LOGMSG << "dtM automatically set to " << dtM0 << " s" << endl;
+		} else if (dtM0 > dt_stable) {
+			LOGWRN << "dtM = " << dtM0 << " s is larger than the estimated "
+			       << "stable time step, " << dt_stable << " s, governed by "
+			       << dt_obj << endl;
+		}
+	}
+
+	// ------------------ do static solver IC gen --------------------
+
+	// A non-positive TmaxIC skips the initial condition generation, whatever
+	// the method is, so the unbalanced initial state is kept. TmaxIC does not
+	// bound the Newton iterations otherwise
+	const bool ic_gen = !skip_ic && (ICTmax > 0.0);
+	bool ic_relax = ic_gen && (ICmethod == "relaxation");
+	if (ic_gen && (ICmethod == "newton")) {
+		LOGMSG << "Finalizing ICs using the static solver" << endl;
+		const unsigned int static_iters = 100;
+		bool static_converged = false;
+		moordyn::error_id err = MOORDYN_SUCCESS;
+		string err_msg;
+		try {
+			static_converged =
+			    _t_integrator->SolveStatics(ICthresh * env.g, static_iters);
+		}
+		MOORDYN_CATCHER(err, err_msg);
+		if (err != MOORDYN_SUCCESS) {
+			LOGWRN << "The static solver failed: " << err_msg << endl;
+		}
+		if (static_converged) {
+			LOGMSG << "Static equilibrium found" << endl;
+		} else {
+			LOGWRN << "The static solver did not converge, falling back to "
+			       << "dynamic relaxation" << endl;
+			ic_relax = true;
+		}
+	}
+
+	// ------------------ do kinetic damping IC gen --------------------
+
+	if (ic_gen && (ICmethod == "kinetic")) {
+		LOGMSG << "Finalizing ICs using kinetic damping" << endl;
+		bool kinetic_converged = false;
+		moordyn::error_id err = MOORDYN_SUCCESS;
+		string err_msg;
+		// threshIC is the tolerance on the accelerations as a fraction of
+		// the gravity here, not on the fairlead tensions relative errors
+		try {
+			kinetic_converged = _t_integrator->RelaxKinetic(
+			    dtM0, ICthresh * env.g, ICTmax);
+		}
+		MOORDYN_CATCHER(err, err_msg);
+		if (err != MOORDYN_SUCCESS) {
+			LOGERR << "The kinetic damping failed: " << err_msg << endl;
+			return err;
+		}
+		if (kinetic_converged) {
+			LOGMSG << "Static equilibrium found" << endl;
+		} else {
+			LOGWRN << "The kinetic damping did not converge, falling back to "
+			       << "dynamic relaxation" << endl;
+			ic_relax = true;
+		}
+	}
+
 	// ------------------ do dynamic relaxation IC gen --------------------
 
-	if (!skip_ic) {
+	if (ic_relax) {
 		LOGMSG << "Finalizing ICs using dynamic relaxation (" << ICDfac
 		       << "X normal drag)" << endl;
 	}
@@ -279,7 +396,7 @@ moordyn::MoorDyn::Init(const double* x, const double* xd, bool skip_ic)
 	real t = 0;
 	bool converged = true;
 	real max_error = 0.0;
-	while ((t < ICTmax) && (!skip_ic)) {
+	while ((t < ICTmax) && ic_relax) {
 		// Integrate one ICD timestep (ICdt)
 		real t_target = ICdt;
 		real dt;
@@ -352,13 +469,15 @@ moordyn::MoorDyn::Init(const double* x, const double* xd, bool skip_ic)
 		iic++;
 	}
 
-	if (converged) {
-		LOGMSG << "Fairlead tensions converged" << endl;
-	} else {
-		LOGWRN << "Fairlead tensions did not converged" << endl;
+	if (ic_relax) {
+		if (converged) {
+			LOGMSG << "Fairlead tensions converged" << endl;
+		} else {
+			LOGWRN << "Fairlead tensions did not converged" << endl;
+		}
+		LOGMSG << "Remaining error after " << t << " s = "
+		       << 100.0 * max_error << "%" << endl;
 	}
-	LOGMSG << "Remaining error after " << t << " s = " << 100.0 * max_error
-	       << "%" << endl;
 
 	// restore drag coefficients to normal values and restart time counter of
 	// each object
@@ -518,6 +637,8 @@ moordyn::MoorDyn::Step(const double* x,
 			return err;
 		}
 	}
+	// Let the waves be queried at the new time
+	waves->setTime(t, 0);
 
 	// --------------- check for line failures (detachments!) ----------------
 	// step 1: check for time-triggered failures
@@ -643,7 +764,9 @@ moordyn::MoorDyn::ReadInFile()
 	unsigned int i = 0;
 
 	// We are really interested in looking for the writeLog option, to start
-	// logging as soon as possible
+	// logging as soon as possible, and the QSLines one, which is required
+	// while the lines list is parsed
+	vector<int> qs_lines;
 	ifstream in_file(_filepath);
 	vector<string> in_txt;
 	string line;
@@ -675,6 +798,12 @@ moordyn::MoorDyn::ReadInFile()
 			}
 			const string value = entries[0];
 			const string name = entries[1];
+			if (name == "QSLines") {
+				for (auto id : moordyn::str::split(value, ','))
+					qs_lines.push_back(atoi(id.c_str()));
+				i++;
+				continue;
+			}
 			if (name != "writeLog") {
 				i++;
 				continue;
@@ -688,6 +817,8 @@ moordyn::MoorDyn::ReadInFile()
 		}
 	}
 
+	// dynamic relaxation to find the initial conditions, as in former versions
+	ICmethod = "relaxation";
 	// factor by which to boost drag coefficients during dynamic relaxation IC
 	// generation
 	ICDfac = 5.0;
@@ -707,6 +838,9 @@ moordyn::MoorDyn::ReadInFile()
 	dtM0 = 0.001;
 	// default time integration scheme
 	string t_integrator_name = "RK2";
+	// adaptive time integration settings, non-positive values to keep the
+	// scheme defaults
+	real t_atol = 0.0, t_rtol = 0.0, dtM_min = -1.0;
 
 	// string containing which channels to write to output
 	vector<string> outchannels;
@@ -1389,18 +1523,25 @@ moordyn::MoorDyn::ReadInFile()
 				       << " - of class " << type << " (" << TypeNum << ")"
 				       << " with id " << LineList.size() << endl;
 
+				bool quasi_static = false;
+				for (auto id : qs_lines)
+					quasi_static = quasi_static || (id == number);
+
 				Line* obj = new Line(_log);
 				obj->setup(number,
 				           LinePropList[TypeNum],
 				           UnstrLen,
 				           NumSegs,
 				           outfiles.back(),
-				           outchannels);
+				           outchannels,
+				           quasi_static);
 				LineList.push_back(obj);
 				LineStateIs.push_back(
 				    nX); // assign start index of this Line's states
-				nX += 6 * (NumSegs - 1); // add 6 state variables for each
-				                         // internal node of this line
+				// add 6 state variables for each internal node of this line,
+				// unless it is quasi-static
+				if (!obj->isQuasiStatic())
+					nX += 6 * (NumSegs - 1);
 
 				for (unsigned int I = 0; I < 2; I++) {
 					const EndPoints end_point =
@@ -1597,16 +1738,33 @@ moordyn::MoorDyn::ReadInFile()
 				LOGDBG << "\t" << entries[1] << " = " << entries[0] << endl;
 				const string value = entries[0];
 				const string name = entries[1];
-				if (name == "writeLog") {
+				if ((name == "writeLog") || (name == "QSLines")) {
 					// Already registered
 					i++;
 					continue;
 				}
 				// DT is old way, should phase out
-				else if ((name == "dtM") || (name == "DT"))
-					dtM0 = atof(entries[0].c_str());
+				else if ((name == "dtM") || (name == "DT")) {
+					if (moordyn::str::lower(value) == "auto")
+						dtM_auto = true;
+					else
+						dtM0 = atof(entries[0].c_str());
+				}
 				else if (name == "tScheme")
 					t_integrator_name = entries[0];
+				else if (name == "AbsTol")
+					t_atol = atof(entries[0].c_str());
+				else if (name == "RelTol")
+					t_rtol = atof(entries[0].c_str());
+				else if (name == "dtMmin")
+					dtM_min = atof(entries[0].c_str());
+				else if (name == "Threads") {
+					const int n = atoi(entries[0].c_str());
+					if (n < 0)
+						LOGWRN << "Invalid Threads option value " << n << endl;
+					else
+						nThreads = n;
+				}
 				else if ((name == "g") || (name == "gravity"))
 					env.g = atof(entries[0].c_str());
 				else if ((name == "Rho") || (name == "rho") ||
@@ -1618,7 +1776,15 @@ moordyn::MoorDyn::ReadInFile()
 					env.kb = atof(entries[0].c_str());
 				else if ((name == "cBot") || (name == "cb"))
 					env.cb = atof(entries[0].c_str());
-				else if ((name == "dtIC") || (name == "ICdt"))
+				else if (name == "ICmethod") {
+					ICmethod = moordyn::str::lower(value);
+					if ((ICmethod != "newton") && (ICmethod != "relaxation") &&
+					    (ICmethod != "kinetic")) {
+						LOGWRN << "Unknown ICmethod option value " << value
+						       << ", dynamic relaxation will be used" << endl;
+						ICmethod = "relaxation";
+					}
+				} else if ((name == "dtIC") || (name == "ICdt"))
 					ICdt = atof(entries[0].c_str());
 				else if ((name == "TmaxIC") || (name == "ICTmax"))
 					ICTmax = atof(entries[0].c_str());
@@ -1629,19 +1795,41 @@ moordyn::MoorDyn::ReadInFile()
 				else if (name == "WaveKin") {
 					WaveKinTemp =
 					    (moordyn::waves_settings)atoi(entries[0].c_str());
-					if ((WaveKinTemp < WAVES_NONE) || (WaveKinTemp > WAVES_KIN))
+					if ((WaveKinTemp < WAVES_NONE) ||
+					    (WaveKinTemp > WAVES_SPECTRAL))
 						LOGWRN << "Unknown WaveKin option value " << WaveKinTemp
 						       << endl;
 				} else if (name == "dtWave")
-					env.dtWave = atoi(entries[0].c_str());
-				else if (name == "Currents") {
+					env.dtWave = atof(entries[0].c_str());
+				else if (name == "WaveGridPrec") {
+					env.WavePrec =
+					    (moordyn::waves_precision)atoi(entries[0].c_str());
+					if ((env.WavePrec < WAVES_PREC_REAL) ||
+					    (env.WavePrec > WAVES_PREC_FIXED16)) {
+						LOGWRN << "Unknown WaveGridPrec option value "
+						       << env.WavePrec << endl;
+						env.WavePrec = WAVES_PREC_REAL;
+					}
+				} else if (name == "Currents") {
 					env.Current =
 					    (moordyn::currents_settings)atoi(entries[0].c_str());
 					if ((env.Current < CURRENTS_NONE) ||
 					    (env.Current > CURRENTS_DYNAMIC_NODE))
 						LOGWRN << "Unknown Currents option value "
 						       << env.Current << endl;
-				} else if (name == "WriteUnits")
+				} else if (name == "WaveCache")
+					env.WaveCache = atoi(entries[0].c_str());
+				else if (name == "WaveWindow")
+					env.WaveWindow = atof(entries[0].c_str());
+				else if (name == "WaveGridFit")
+					env.WaveGridFit = atoi(entries[0].c_str());
+				else if (name == "WaveGridMargin")
+					env.WaveGridMargin = atof(entries[0].c_str());
+				else if (name == "WaveGridDx")
+					env.WaveGridDx = atof(entries[0].c_str());
+				else if (name == "WaveGridNz")
+					env.WaveGridNz = atoi(entries[0].c_str());
+				else if (name == "WriteUnits")
 					env.WriteUnits = atoi(entries[0].c_str());
 				else if (name == "FrictionCoefficient")
 					env.FrictionCoefficient = atof(entries[0].c_str());
@@ -1649,6 +1837,10 @@ moordyn::MoorDyn::ReadInFile()
 					env.FricDamp = atof(entries[0].c_str());
 				else if (name == "StatDynFricScale")
 					env.StatDynFricScale = atof(entries[0].c_str());
+				else if (name == "MassTol")
+					env.MassTol = atof(entries[0].c_str());
+				else if (name == "CurvePoints")
+					env.CurvePoints = atoi(entries[0].c_str());
 				// output writing period (0 for at every call)
 				else if (name == "dtOut")
 					dtOut = atof(entries[0].c_str());
@@ -1842,6 +2034,15 @@ moordyn::MoorDyn::ReadInFile()
 		i++;
 	}
 
+	for (auto id : qs_lines) {
+		bool found = false;
+		for (auto obj : LineList)
+			found = found || (obj->number == id);
+		if (!found)
+			LOGWRN << "The quasi-static line " << id
+			       << " on the QSLines option does not exist" << endl;
+	}
+
 	// do some input validity checking?
 	// should there be a flag in the input file that clearly distingiushes the
 	// coupling type?
@@ -1874,6 +2075,19 @@ moordyn::MoorDyn::ReadInFile()
 	string err_msg;
 	try {
 		_t_integrator = create_time_scheme(t_integrator_name, _log);
+		RK45Scheme* adaptive = dynamic_cast<RK45Scheme*>(_t_integrator);
+		if (adaptive) {
+			if ((t_atol > 0.0) || (t_rtol > 0.0)) {
+				adaptive->SetTolerances(
+				    (t_atol > 0.0) ? t_atol : adaptive->GetAbsTolerance(),
+				    (t_rtol > 0.0) ? t_rtol : adaptive->GetRelTolerance());
+			}
+			if (dtM_min >= 0.0)
+				adaptive->SetMinTimeStep(dtM_min);
+		} else if ((t_atol > 0.0) || (t_rtol > 0.0) || (dtM_min >= 0.0)) {
+			LOGWRN << "AbsTol, RelTol and dtMmin options are ignored by the "
+			       << _t_integrator->GetName() << " time scheme" << endl;
+		}
 	}
 	MOORDYN_CATCHER(err, err_msg);
 	if (err != MOORDYN_SUCCESS) {
@@ -1881,6 +2095,8 @@ moordyn::MoorDyn::ReadInFile()
 		return err;
 	}
 	LOGMSG << "Time integrator = " << _t_integrator->GetName() << endl;
+	_t_integrator->SetThreads(nThreads);
+	LOGDBG << "Threads = " << _t_integrator->GetThreads() << endl;
 	_t_integrator->SetGround(GroundBody);
 	for (auto obj : BodyList)
 		_t_integrator->AddBody(obj);
@@ -1899,6 +2115,7 @@ moordyn::MoorDyn::ReadInFile()
 	MOORDYN_CATCHER(err, err_msg);
 	if (err != MOORDYN_SUCCESS)
 		return err;
+	_t_integrator->SetWaves(waves);
 
 	GroundBody->setEnv(&env, waves);
 	for (auto obj : BodyList)
@@ -2065,6 +2282,22 @@ MoorDyn_SetVerbosity(MoorDyn system, int verbosity)
 	return MOORDYN_SUCCESS;
 }
 
+int DECLDIR
+MoorDyn_SetThreads(MoorDyn system, unsigned int n)
+{
+	CHECK_SYSTEM(system);
+	((moordyn::MoorDyn*)system)->SetThreads(n);
+	return MOORDYN_SUCCESS;
+}
+
+int DECLDIR
+MoorDyn_GetStableTimeStep(MoorDyn system, double* dt)
+{
+	CHECK_SYSTEM(system);
+	*dt = ((moordyn::MoorDyn*)system)->GetStableTimeStep();
+	return MOORDYN_SUCCESS;
+}
+
 int DECLDIR
 MoorDyn_SetLogFile(MoorDyn system, const char* log_path)
 {
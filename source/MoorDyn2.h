@@ -95,6 +95,34 @@ extern "C"
 	 */
 	int DECLDIR MoorDyn_SetVerbosity(MoorDyn system, int verbosity);
 
+	/** @brief Set the number of threads used to evaluate the lines
+	 *
+	 * The lines are evaluated in parallel, while the rest of entities are
+	 * evaluated afterwards. The results do not depend on the number of threads.
+	 * This overrides the Threads option of the input file
+	 * @param system The Moordyn system
+	 * @param n The number of threads. 1 to work in serial (default), 0 to use
+	 * all the available hardware threads
+	 * @return MOORDYN_SUCESS If the number of threads is correctly set, an
+	 * error code otherwise (see @ref moordyn_errors)
+	 */
+	int DECLDIR MoorDyn_SetThreads(MoorDyn system, unsigned int n);
+
+	/** @brief Estimate the largest stable time step
+	 *
+	 * The estimation considers the stability limit of the chosen time scheme
+	 * on each line and rod, so it can be used to size the simulation before
+	 * running it
+	 * @param system The Moordyn system
+	 * @param dt The stable time step. Infinity if none of the objects is
+	 * limiting it
+	 * @return MOORDYN_SUCESS If the time step is correctly estimated, an
+	 * error code otherwise (see @ref moordyn_errors)
+	 * @note The lines which unstretched length is relative to the distance
+	 * between their end points are just considered after MoorDyn_Init()
+	 */
+	int DECLDIR MoorDyn_GetStableTimeStep(MoorDyn system, double* dt);
+
 	/** @brief Set the instance log file
 	 * @param system The Moordyn system
 	 * @param log_path The file path to print the log file
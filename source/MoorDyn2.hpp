@@ -125,6 +125,10 @@ class MoorDyn : public io::IO
 	 */
 	inline vector<Line*> GetLines() const { return LineList; }
 
+	/** @brief Get the time integrator
+	 */
+	inline TimeScheme* GetTimeScheme() const { return _t_integrator; }
+
 	/** @brief Return the number of coupled Degrees Of Freedom (DOF)
 	 *
 	 * This should match with the number of components of the positions and
@@ -152,11 +156,39 @@ class MoorDyn : public io::IO
 		return n;
 	}
 
+	/** @brief Estimate the largest stable time step
+	 *
+	 * The critical time step of each line and rod is scaled by the stability
+	 * factor of the time scheme, and the smallest one is returned
+	 * @param obj If not NULL, it is filled with the name of the object
+	 * governing the stable time step
+	 * @return The stable time step. Infinity if none of the objects is
+	 * limiting it
+	 * @note The lines which unstretched length is relative to the distance
+	 * between their end points are just considered after MoorDyn::Init()
+	 * @see TimeScheme::GetStableTimeStep()
+	 */
+	real GetStableTimeStep(std::string* obj = NULL) const;
+
+	/** @brief Set the number of threads used to evaluate the lines
+	 *
+	 * This overrides the value set with the Threads option of the input file
+	 * @param n The number of threads. 1 to work in serial (default), 0 to use
+	 * all the available hardware threads
+	 * @see TimeScheme::SetThreads()
+	 */
+	inline void SetThreads(unsigned int n)
+	{
+		nThreads = n;
+		if (_t_integrator)
+			_t_integrator->SetThreads(n);
+	}
+
 	/** @brief Get the wave kinematics instance
 	 *
 	 * The wave kinematics instance is used if env.WaveKin is one of
-	 * WAVES_FFT_GRID, WAVES_GRID, WAVES_FFT_NODE, WAVES_NODE or if
-	 * env.Currents is not CURRENTS_NONE
+	 * WAVES_FFT_GRID, WAVES_GRID, WAVES_FFT_NODE, WAVES_NODE, WAVES_SPECTRAL
+	 * or if env.Currents is not CURRENTS_NONE
 	 * @return The wave knematics instance
 	 */
 	inline moordyn::Waves* GetWaves() const { return waves; }
@@ -412,6 +444,10 @@ class MoorDyn : public io::IO
 	/// The input file directory
 	string _basepath;
 
+	/// The method to find the initial conditions, either "relaxation" for
+	/// dynamic relaxation, "newton" for the static solver or "kinetic" for
+	/// kinetic damping relaxation
+	string ICmethod;
 	// factor by which to boost drag coefficients during dynamic relaxation IC
 	// generation
 	real ICDfac;
@@ -419,16 +455,23 @@ class MoorDyn : public io::IO
 	real ICdt;
 	// max time for IC generation
 	real ICTmax;
-	// threshold for relative change in tensions to call it converged
+	// threshold for relative change in tensions to call it converged. With
+	// the newton and kinetic ICmethod, threshold for the accelerations as a
+	// fraction of the gravity
 	real ICthresh;
 	// temporary wave kinematics flag used to store input value while keeping
 	// env.WaveKin=0 for IC gen
 	moordyn::waves_settings WaveKinTemp;
 	/// (s) desired mooring line model time step
 	real dtM0;
+	/// Whether the mooring line model time step is automatically set as the
+	/// estimated stable one
+	bool dtM_auto;
 	/// (s) desired output interval (the default zero value provides output at
 	/// every call to MoorDyn)
 	real dtOut;
+	/// Number of threads used to evaluate the lines (0 for all the available)
+	unsigned int nThreads;
 
 	/// The time integration scheme
 	TimeScheme* _t_integrator;
@@ -598,6 +641,8 @@ class MoorDyn : public io::IO
 
 		for (auto fline : flines) {
 			vector<string> entries = moordyn::str::split(fline, ' ');
+			if (entries.empty())
+				continue;
 			if (entries.size() < 2) {
 				LOGERR << "Error: Bad curve point" << std::endl
 				       << "\t'" << fline << "'" << std::endl
@@ -606,7 +651,7 @@ class MoorDyn : public io::IO
 				return MOORDYN_INVALID_INPUT;
 			}
 			x.push_back(atof(entries[0].c_str()));
-			y.push_back(atof(entries[0].c_str()));
+			y.push_back(atof(entries[1].c_str()));
 			LOGDBG << "(" << x.back() << ", " << y.back() << ")" << std::endl;
 		}
 
@@ -641,7 +686,7 @@ class MoorDyn : public io::IO
 
 		if (xv.size() == 1) {
 			*c = yv.back();
-			n = 0;
+			*n = 0;
 			return MOORDYN_SUCCESS;
 		}
 
@@ -79,6 +79,9 @@ int longwinded = 0;
  * @param Z Output vertical locations of each line node relative to the anchor
  *          (meters)
  * @param Te Output effective line tensions at each node (N)
+ * @param warm true to start the Newton-Raphson iterations from the input
+ *             values of @p HFout and @p VFout, e.g. the previous time step
+ *             solution, false to estimate them from the line geometry
  * @return 1 if the quasi-static equilibrium is found, -1 otherwise
  */
 template<typename T>
@@ -98,7 +101,8 @@ Catenary(T XF,
          const vector<T>& s,
          vector<T>& X,
          vector<T>& Z,
-         vector<T>& Te)
+         vector<T>& Te,
+         bool warm = false)
 {
 	if (longwinded == 1)
 		cout << "In Catenary.  XF is " << XF << " and ZF is " << ZF << endl;
@@ -229,6 +233,10 @@ Catenary(T XF,
 	// ! As above, set the lower limit of the guess value of HF to the tolerance
 	HF = max((T)abs(0.5 * W * XF / Lamda0), Tol);
 	VF = 0.5 * W * (ZF / tanh(Lamda0) + L);
+	if (warm && (*HFout > 0.0)) {
+		HF = *HFout;
+		VF = *VFout;
+	}
 
 	/*
 	! To avoid an ill-conditioned situation, ensure that the initial guess for
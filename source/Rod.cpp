@@ -33,6 +33,7 @@
 #include "Line.hpp"
 #include "Waves.hpp"
 #include <tuple>
+#include <limits>
 
 #ifdef USE_VTK
 #include <vtkCellArray.h>
@@ -54,6 +55,9 @@ namespace moordyn {
 
 Rod::Rod(moordyn::Log* log)
   : io::IO(log)
+  , rhs_memo(false)
+  , rhs_done(false)
+  , rhs_count(0)
 {
 }
 
@@ -225,6 +229,24 @@ Rod::removeLine(EndPoints end_point, Line* line)
 	throw moordyn::invalid_value_error("Invalid line");
 };
 
+real
+Rod::getCriticalTimeStep() const
+{
+	const real inf = std::numeric_limits<real>::infinity();
+	if ((type != FREE) && (type != PINNED) && (type != CPLDPIN))
+		return inf;
+	const real A = 0.25 * pi * d * d;
+	const real m = (rho + env->rho_w * std::min(Can, Cat)) * A * UnstrLen;
+	real k = env->kb * d * UnstrLen;
+	for (auto attached : attachedA)
+		k += attached.line->getSegmentStiffness();
+	for (auto attached : attachedB)
+		k += attached.line->getSegmentStiffness();
+	if ((m <= 0.0) || (k <= 0.0))
+		return inf;
+	return 2.0 / sqrt(k / m);
+}
+
 std::pair<vec6, vec6>
 Rod::initialize()
 {
@@ -301,10 +323,11 @@ Rod::initialize()
 	// set water kinematics flag based on global wave and current settings (for
 	// now)
 	if ((env->WaveKin == WAVES_FFT_GRID) || (env->WaveKin == WAVES_GRID) ||
-	    (env->WaveKin == WAVES_KIN) || (env->Current == CURRENTS_STEADY_GRID) ||
+	    (env->WaveKin == WAVES_KIN) || (env->WaveKin == WAVES_SPECTRAL) ||
+	    (env->Current == CURRENTS_STEADY_GRID) ||
 	    (env->Current == CURRENTS_DYNAMIC_GRID)) {
 		// water kinematics to be considered through precalculated global grid
-		// stored in Waves object
+		// or spectral components stored in Waves object
 		WaterKin = WAVES_GRID;
 	} else if ((env->WaveKin == WAVES_FFT_NODE) ||
 	           (env->WaveKin == WAVES_NODE) ||
@@ -592,8 +615,8 @@ Rod::setDependentStates()
 		attached.line->setEndOrientation(q, attached.end_point, ENDPOINT_B);
 }
 
-std::pair<vec6, vec6>
-Rod::getStateDeriv()
+void
+Rod::getStateDeriv(DRodStateDt& drdt)
 {
 	// attempting error handling <<<<<<<<
 	for (unsigned int i = 0; i <= N; i++) {
@@ -626,7 +649,6 @@ Rod::getStateDeriv()
 	    rho * d * d * d * d / 64.0 * q2.asDiagonal();
 
 	// solve for accelerations in [M]{a}={f}, then fill in state derivatives
-	vec6 vel6, acc6;
 	if (type == FREE) {
 		if (N == 0) {
 			// special zero-length Rod case, orientation is not an actual state
@@ -639,44 +661,32 @@ Rod::getStateDeriv()
 			const vec acc = M_out3.inverse() * Fnet_out3;
 
 			// dxdt = V   (velocities)
-			vel6(Eigen::seqN(0, 3)) = v6(Eigen::seqN(0, 3));
-			vel6(Eigen::seqN(3, 3)) = vec::Zero();
+			drdt.vel(Eigen::seqN(0, 3)) = v6(Eigen::seqN(0, 3));
+			drdt.vel(Eigen::seqN(3, 3)) = vec::Zero();
 			// dVdt = a   (accelerations)
-			acc6(Eigen::seqN(0, 3)) = acc;
-			acc6(Eigen::seqN(3, 3)) = vec::Zero();
+			drdt.acc(Eigen::seqN(0, 3)) = acc;
+			drdt.acc(Eigen::seqN(3, 3)) = vec::Zero();
 		} else {
-			// For small systems, which are anyway larger than 4x4, we can use
-			// the ColPivHouseholderQR algorithm, which is working with every
-			// single matrix, retaining a very good accuracy, and becoming yet
-			// faster See:
-			// https://eigen.tuxfamily.org/dox/group__TutorialLinearAlgebra.html
-			Eigen::ColPivHouseholderQR<mat6> solver(M_out6);
-			acc6 = solver.solve(Fnet_out);
+			// The mass matrix is symmetric positive definite, see MassSolver
+			drdt.acc = M_solver.solve(M_out6, Fnet_out, env->MassTol);
 
 			// dxdt = V   (velocities)
-			vel6(Eigen::seqN(0, 3)) = v6(Eigen::seqN(0, 3));
+			drdt.vel(Eigen::seqN(0, 3)) = v6(Eigen::seqN(0, 3));
 			// rate of change of unit vector components!!  CHECK!   <<<<<
 			const vec v3 = v6(Eigen::seqN(3, 3));
 			const vec r3 = r6(Eigen::seqN(3, 3));
-			vel6(Eigen::seqN(3, 3)) = v3.cross(r3);
+			drdt.vel(Eigen::seqN(3, 3)) = v3.cross(r3);
 		}
 	} else {
-		// For small systems, which are anyway larger than 4x4, we can use the
-		// ColPivHouseholderQR algorithm, which is working with every single
-		// matrix, retaining a very good accuracy, and becoming yet faster
-		// See:
-		// https://eigen.tuxfamily.org/dox/group__TutorialLinearAlgebra.html
-		Eigen::ColPivHouseholderQR<mat6> solver(M_out6);
-		acc6 = solver.solve(Fnet_out);
+		// The mass matrix is symmetric positive definite, see MassSolver
+		drdt.acc = M_solver.solve(M_out6, Fnet_out, env->MassTol);
 
 		// dxdt = V   (velocities)
-		vel6(Eigen::seqN(0, 3)) = vec::Zero();
-		vel6(Eigen::seqN(3, 3)) = v6(Eigen::seqN(3, 3));
+		drdt.vel(Eigen::seqN(0, 3)) = vec::Zero();
+		drdt.vel(Eigen::seqN(3, 3)) = v6(Eigen::seqN(3, 3));
 		// dVdt = a   (accelerations)
-		acc6(Eigen::seqN(0, 3)) = vec::Zero();
+		drdt.acc(Eigen::seqN(0, 3)) = vec::Zero();
 	}
-
-	return std::make_pair(vel6, acc6);
 }
 
 vec6
@@ -809,6 +819,13 @@ Rod::getNetForceAndMass(vec6& Fnet_out, mat6& M_out, vec rRef)
 void
 Rod::doRHS()
 {
+	// The forces and masses might be already computed on this time
+	// derivatives evaluation, see beginRHS()
+	if (rhs_memo && rhs_done)
+		return;
+	rhs_done = true;
+	rhs_count++;
+
 	// ---------------------------- initial rod and node calculations
 	// ------------------------
 
@@ -876,24 +893,16 @@ Rod::doRHS()
 			U[i] = UTS[i][it] + frac * (UTS[i][it + 1] - UTS[i][it]);
 			Ud[i] = UdTS[i][it] + frac * (UdTS[i][it + 1] - UdTS[i][it]);
 		}
-	} else if (WaterKin == WAVES_FFT_GRID) {
+	} else if (WaterKin == WAVES_GRID) {
 		// wave kinematics interpolated from global grid in Waves object
-		for (unsigned int i = 0; i <= N; i++) {
-			waves->getWaveKin(
-			    r[i][0],
-			    r[i][1],
-			    r[i][2],
-			    U[i],
-			    Ud[i],
-			    zeta[i],
-			    PDyn[i]); // call generic function to get water velocities
-
-			// >>> add Pd variable for dynamic pressure, which will be applied
-			// on Rod surface
-
-			F[i] = 1.0; // set VOF value to one for now (everything submerged -
-			            // eventually this should be element-based!!!) <<<<
-		}
+		waves->getWaveKin(r, U, Ud, zeta, PDyn, wave_cells);
+
+		// >>> add Pd variable for dynamic pressure, which will be applied
+		// on Rod surface
+
+		// set VOF value to one for now (everything submerged - eventually
+		// this should be element-based!!!) <<<<
+		std::fill(F.begin(), F.end(), 1.0);
 	} else if (WaterKin != WAVES_NONE) {
 		// Hopefully WaterKin is set to zero, meaning no waves or set
 		// externally, otherwise it's an error
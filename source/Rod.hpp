@@ -36,6 +36,7 @@
 
 #include "Misc.hpp"
 #include "IO.hpp"
+#include "State.hpp"
 #include <vector>
 #include <utility>
 
@@ -151,6 +152,8 @@ class Rod : public io::IO
 	vec6 F6net;
 	/// total mass matrix about end A of Rod and any attached Points
 	mat6 M6net;
+	/// solver of the mass matrix, reusing the factorization
+	MassSolver<6> M_solver;
 
 	// forces
 	/// node dry weights
@@ -184,6 +187,8 @@ class Rod : public io::IO
 	std::vector<vec> U;
 	/// wave accelerations
 	std::vector<vec> Ud;
+	/// wave grid cells of each node, used as search hints by the waves
+	std::vector<ivec> wave_cells;
 	/// instantaneous axial submerged length [m]
 	real h0;
 
@@ -219,6 +224,13 @@ class Rod : public io::IO
 	/// water kinematics time step size (s)
 	moordyn::real dtWater;
 
+	/// Whether doRHS() is memoized, see beginRHS()
+	bool rhs_memo;
+	/// Whether doRHS() has been already evaluated since beginRHS()
+	bool rhs_done;
+	/// Number of doRHS() evaluations, for debugging purposes
+	unsigned long rhs_count;
+
 	/**
 	 * @}
 	 */
@@ -319,6 +331,19 @@ class Rod : public io::IO
 	 */
 	EndPoints removeLine(EndPoints end_point, Line* line);
 
+	/** @brief Get the critical time step of the rod
+	 *
+	 * The rod is a rigid body, so its natural frequency, \f$ \omega \f$, is
+	 * estimated from the seabed stiffness and the axial stiffness of the
+	 * attached lines end segments, considering the added mass. The critical
+	 * time step is then \f$ 2 / \omega \f$, i.e. the stability limit of the
+	 * central differences scheme on an undamped system
+	 * @return The critical time step. Infinity for the rods which are not
+	 * integrated in time, or the ones without mass or stiffness
+	 * @note The environmental data shall be already set
+	 */
+	real getCriticalTimeStep() const;
+
 	/** @brief Set the environmental data
 	 * @param env_in Global struct that holds environmental settings
 	 * @param waves_in Global Waves object
@@ -501,13 +526,13 @@ class Rod : public io::IO
 	void setDependentStates();
 
 	/** @brief calculate the forces and state derivatives of the rod
-	 * @return The linear and angular velocity (first), and the linear and
-	 * angular accelerations (second)
+	 * @param drdt The output states derivatives, i.e. the linear and angular
+	 * velocity, and the linear and angular accelerations
 	 * @throws nan_error If nan values are detected in any node position
 	 * @note The returned linear velocity and accelerations for pinned rods
 	 * should be ignored
 	 */
-	std::pair<vec6, vec6> getStateDeriv();
+	void getStateDeriv(DRodStateDt& drdt);
 
 	/** @brief function to return net force on rod (and possibly moment at end A
 	 * if it's not pinned)
@@ -517,6 +542,13 @@ class Rod : public io::IO
 	 */
 	vec6 getFnet();
 
+	/** @brief Get the mass and intertia matrix about end A
+	 * @return The mass and inertia matrix, without the contributions of the
+	 * attached lines
+	 * @note The matrix is computed on doRHS()
+	 */
+	inline const mat6& getM() const { return M6net; }
+
 	/** @brief Calculate the force and mass contributions of the connect on the
 	 * parent body
 	 * @param Fnet_out Output Force about body ref point
@@ -540,6 +572,26 @@ class Rod : public io::IO
 	 */
 	void doRHS();
 
+	/** @brief Start a time derivatives evaluation
+	 *
+	 * The forces and masses are computed the first time doRHS() is called,
+	 * and then reused by the rest of consumers, until endRHS() is called
+	 */
+	inline void beginRHS()
+	{
+		rhs_memo = true;
+		rhs_done = false;
+	}
+
+	/** @brief Finish the time derivatives evaluation started with beginRHS()
+	 */
+	inline void endRHS() { rhs_memo = false; }
+
+	/** @brief Get the number of doRHS() evaluations so far
+	 * @return The number of evaluations
+	 */
+	inline unsigned long getRHSCount() const { return rhs_count; }
+
 	void Output(real);
 
 	/** @brief Produce the packed data to be saved
@@ -34,497 +34,96 @@ using namespace std;
 
 namespace moordyn {
 
-template<>
 string
-StateVar<vec>::AsString() const
+PackedState::AsString() const
 {
 	stringstream s;
-	s << "pos = [" << pos.transpose() << "]; ";
-	s << "vel = [" << vel.transpose() << "]" << endl;
-	return s.str();
-}
-
-template<>
-string
-StateVar<vec6>::AsString() const
-{
-	stringstream s;
-	s << "pos = [" << pos.transpose() << "]; ";
-	s << "vel = [" << vel.transpose() << "]" << endl;
-	return s.str();
-}
-
-template<>
-string
-StateVar<std::vector<vec>>::AsString() const
-{
-	stringstream s;
-	s << "pos = [";
-	for (auto v : pos)
-		s << "[" << v.transpose() << "], ";
-	s << "]" << endl;
-	s << "vel = [";
-	for (auto v : vel)
-		s << "[" << v.transpose() << "], ";
-	s << "]" << endl;
-	return s.str();
-}
-
-template<>
-StateVar<vec>
-StateVar<vec>::operator+(const StateVar<vec>& rhs)
-{
-	StateVar<vec> out;
-	out.pos = pos + rhs.pos;
-	out.vel = vel + rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<vec6>
-StateVar<vec6>::operator+(const StateVar<vec6>& rhs)
-{
-	StateVar<vec6> out;
-	out.pos = pos + rhs.pos;
-	out.vel = vel + rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<std::vector<vec>>
-StateVar<std::vector<vec>>::operator+(const StateVar<std::vector<vec>>& rhs)
-{
-	if ((pos.size() != rhs.pos.size()) || (vel.size() != rhs.vel.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVar<std::vector<vec>> out;
-	out.pos.reserve(pos.size());
-	out.vel.reserve(vel.size());
-	// NOTE: At this point we are assuming that both pos and vel have the same
-	// length
-	for (unsigned int i = 0; i < pos.size(); i++) {
-		out.pos.push_back(pos[i] + rhs.pos[i]);
-		out.vel.push_back(vel[i] + rhs.vel[i]);
-	}
-	return out;
-}
-
-template<>
-StateVar<vec>
-StateVar<vec>::operator-(const StateVar<vec>& rhs)
-{
-	StateVar<vec> out;
-	out.pos = pos - rhs.pos;
-	out.vel = vel - rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<vec6>
-StateVar<vec6>::operator-(const StateVar<vec6>& rhs)
-{
-	StateVar<vec6> out;
-	out.pos = pos - rhs.pos;
-	out.vel = vel - rhs.vel;
-	return out;
-}
-
-template<>
-StateVar<std::vector<vec>>
-StateVar<std::vector<vec>>::operator-(const StateVar<std::vector<vec>>& rhs)
-{
-	if ((pos.size() != rhs.pos.size()) || (vel.size() != rhs.vel.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVar<std::vector<vec>> out;
-	out.pos.reserve(pos.size());
-	out.vel.reserve(vel.size());
-	// NOTE: At this point we are assuming that both pos and vel have the same
-	// length
-	for (unsigned int i = 0; i < pos.size(); i++) {
-		out.pos.push_back(pos[i] - rhs.pos[i]);
-		out.vel.push_back(vel[i] - rhs.vel[i]);
-	}
-	return out;
-}
-
-template<>
-string
-StateVarDeriv<vec>::AsString() const
-{
-	stringstream s;
-	s << "vel = [" << vel.transpose() << "]; ";
-	s << "acc = [" << acc.transpose() << "]" << endl;
-	return s.str();
-}
-
-template<>
-string
-StateVarDeriv<vec6>::AsString() const
-{
-	stringstream s;
-	s << "vel = [" << vel.transpose() << "]; ";
-	s << "acc = [" << acc.transpose() << "]" << endl;
-	return s.str();
-}
-
-template<>
-string
-StateVarDeriv<std::vector<vec>>::AsString() const
-{
-	stringstream s;
-	s << "vel = [";
-	for (auto v : vel)
-		s << "[" << v.transpose() << "], ";
-	s << "]" << endl;
-	s << "acc = [";
-	for (auto v : acc)
-		s << "[" << v.transpose() << "], ";
-	s << "]" << endl;
-	return s.str();
-}
-
-template<>
-StateVar<vec>
-StateVarDeriv<vec>::operator*(const real& dt)
-{
-	StateVar<vec> out;
-	out.pos = vel * dt;
-	out.vel = acc * dt;
-	return out;
-}
-
-template<>
-StateVar<vec6>
-StateVarDeriv<vec6>::operator*(const real& dt)
-{
-	StateVar<vec6> out;
-	out.pos = vel * dt;
-	out.vel = acc * dt;
-	return out;
-}
-
-template<>
-StateVar<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::operator*(const real& dt)
-{
-	StateVar<std::vector<vec>> out;
-	out.pos.reserve(vel.size());
-	out.vel.reserve(acc.size());
-	// NOTE: At this point we are assuming that both vel and acc have the same
-	// length
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		out.pos.push_back(vel[i] * dt);
-		out.vel.push_back(acc[i] * dt);
-	}
-	return out;
-}
-
-template<>
-StateVarDeriv<vec>
-StateVarDeriv<vec>::operator+(const StateVarDeriv<vec>& rhs)
-{
-	StateVarDeriv<vec> out;
-	out.vel = vel + rhs.vel;
-	out.acc = acc + rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<vec6>
-StateVarDeriv<vec6>::operator+(const StateVarDeriv<vec6>& rhs)
-{
-	StateVarDeriv<vec6> out;
-	out.vel = vel + rhs.vel;
-	out.acc = acc + rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::operator+(
-    const StateVarDeriv<std::vector<vec>>& rhs)
-{
-	if ((vel.size() != rhs.vel.size()) || (acc.size() != rhs.acc.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVarDeriv<std::vector<vec>> out;
-	out.vel.reserve(vel.size());
-	out.acc.reserve(acc.size());
-	// NOTE: At this point we are assuming that both vel and acc have the same
-	// length
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		out.vel.push_back(vel[i] + rhs.vel[i]);
-		out.acc.push_back(acc[i] + rhs.acc[i]);
-	}
-	return out;
-}
-
-template<>
-StateVarDeriv<vec>
-StateVarDeriv<vec>::operator-(const StateVarDeriv<vec>& rhs)
-{
-	StateVarDeriv<vec> out;
-	out.vel = vel - rhs.vel;
-	out.acc = acc - rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<vec6>
-StateVarDeriv<vec6>::operator-(const StateVarDeriv<vec6>& rhs)
-{
-	StateVarDeriv<vec6> out;
-	out.vel = vel - rhs.vel;
-	out.acc = acc - rhs.acc;
-	return out;
-}
-
-template<>
-StateVarDeriv<std::vector<vec>>
-StateVarDeriv<std::vector<vec>>::operator-(
-    const StateVarDeriv<std::vector<vec>>& rhs)
-{
-	if ((vel.size() != rhs.vel.size()) || (acc.size() != rhs.acc.size()))
-		throw moordyn::invalid_value_error("Invalid input size");
-	StateVarDeriv<std::vector<vec>> out;
-	out.vel.reserve(vel.size());
-	out.acc.reserve(acc.size());
-	// NOTE: At this point we are assuming that both vel and acc have the same
-	// length
-	for (unsigned int i = 0; i < vel.size(); i++) {
-		out.vel.push_back(vel[i] - rhs.vel[i]);
-		out.acc.push_back(acc[i] - rhs.acc[i]);
-	}
-	return out;
-}
-
-string
-MoorDynState::AsString() const
-{
-	stringstream s;
-	for (unsigned int i = 0; i < lines.size(); i++) {
+	for (unsigned int i = 0; i < line_n.size(); i++) {
+		const unsigned int n = 3 * line_n[i];
 		s << "Line " << i << ":" << endl;
-		s << lines[i].AsString();
+		s << "[" << data.segment(line_offset[i], n).transpose() << "]; ";
+		s << "[" << data.segment(line_offset[i] + n, n).transpose() << "]"
+		  << endl;
 	}
-	for (unsigned int i = 0; i < conns.size(); i++) {
+	for (unsigned int i = 0; i < conn_offset.size(); i++) {
 		s << "Conn " << i << ":" << endl;
-		s << conns[i].AsString();
+		s << "[" << data.segment(conn_offset[i], 3).transpose() << "]; ";
+		s << "[" << data.segment(conn_offset[i] + 3, 3).transpose() << "]"
+		  << endl;
 	}
-	for (unsigned int i = 0; i < rods.size(); i++) {
+	for (unsigned int i = 0; i < rod_offset.size(); i++) {
 		s << "Rod " << i << ":" << endl;
-		s << rods[i].AsString();
+		s << "[" << data.segment(rod_offset[i], 6).transpose() << "]; ";
+		s << "[" << data.segment(rod_offset[i] + 6, 6).transpose() << "]"
+		  << endl;
 	}
-	for (unsigned int i = 0; i < bodies.size(); i++) {
+	for (unsigned int i = 0; i < body_offset.size(); i++) {
 		s << "Body " << i << ":" << endl;
-		s << bodies[i].AsString();
+		s << "[" << data.segment(body_offset[i], 6).transpose() << "]; ";
+		s << "[" << data.segment(body_offset[i] + 6, 6).transpose() << "]"
+		  << endl;
 	}
 	s << endl;
 	return s.str();
 }
 
-MoorDynState&
-MoorDynState::operator=(const MoorDynState& rhs)
+PackedState&
+PackedState::operator=(const PackedState& rhs)
 {
-	lines.clear();
-	lines.reserve(rhs.lines.size());
-	for (auto l : rhs.lines)
-		lines.push_back(l);
-	conns.clear();
-	conns.reserve(rhs.conns.size());
-	for (auto l : rhs.conns)
-		conns.push_back(l);
-	rods.clear();
-	rods.reserve(rhs.rods.size());
-	for (auto l : rhs.rods)
-		rods.push_back(l);
-	bodies.clear();
-	bodies.reserve(rhs.bodies.size());
-	for (auto l : rhs.bodies)
-		bodies.push_back(l);
+	// The already allocated memory is reused when the sizes match
+	data = rhs.data;
+	line_n = rhs.line_n;
+	line_offset = rhs.line_offset;
+	conn_offset = rhs.conn_offset;
+	rod_offset = rhs.rod_offset;
+	body_offset = rhs.body_offset;
 
 	return *this;
 }
 
-MoorDynState
-MoorDynState::operator+(const MoorDynState& rhs)
+void
+PackedState::add(std::vector<unsigned int>& offsets, unsigned int n)
 {
-	MoorDynState out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] + rhs.lines[i]);
-	if (conns.size() != rhs.conns.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.conns.reserve(conns.size());
-	for (unsigned int i = 0; i < conns.size(); i++)
-		out.conns.push_back(conns[i] + rhs.conns[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] + rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] + rhs.bodies[i]);
-
-	return out;
+	const unsigned int offset = data.size();
+	offsets.push_back(offset);
+	data.conservativeResize(offset + n);
+	data.tail(n).setZero();
 }
 
-MoorDynState
-MoorDynState::operator-(const MoorDynState& rhs)
+void
+PackedState::remove(std::vector<unsigned int>& offsets,
+                    unsigned int i,
+                    unsigned int n)
 {
-	MoorDynState out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] - rhs.lines[i]);
-	if (conns.size() != rhs.conns.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.conns.reserve(conns.size());
-	for (unsigned int i = 0; i < conns.size(); i++)
-		out.conns.push_back(conns[i] - rhs.conns[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] - rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] - rhs.bodies[i]);
+	const unsigned int offset = offsets[i];
+	const unsigned int tail = data.size() - offset - n;
+	data.segment(offset, tail) = data.tail(tail).eval();
+	data.conservativeResize(data.size() - n);
+	offsets.erase(offsets.begin() + i);
 
-	return out;
-}
-
-string
-DMoorDynStateDt::AsString() const
-{
-	stringstream s;
-	for (unsigned int i = 0; i < lines.size(); i++) {
-		s << "Line " << i << ":" << endl;
-		s << lines[i].AsString();
-	}
-	for (unsigned int i = 0; i < conns.size(); i++) {
-		s << "Conn " << i << ":" << endl;
-		s << conns[i].AsString();
+	// Move back the chunks placed afterwards
+	for (auto l : { &line_offset, &conn_offset, &rod_offset, &body_offset }) {
+		for (auto& o : *l) {
+			if (o > offset)
+				o -= n;
+		}
 	}
-	for (unsigned int i = 0; i < rods.size(); i++) {
-		s << "Rod " << i << ":" << endl;
-		s << rods[i].AsString();
-	}
-	for (unsigned int i = 0; i < bodies.size(); i++) {
-		s << "Body " << i << ":" << endl;
-		s << bodies[i].AsString();
-	}
-	s << endl;
-	return s.str();
 }
 
 DMoorDynStateDt&
-DMoorDynStateDt::operator=(const DMoorDynStateDt& rhs)
+DMoorDynStateDt::operator+=(const DMoorDynStateDt& rhs)
 {
-	lines.clear();
-	lines.reserve(rhs.lines.size());
-	for (auto l : rhs.lines)
-		lines.push_back(l);
-	conns.clear();
-	conns.reserve(rhs.conns.size());
-	for (auto l : rhs.conns)
-		conns.push_back(l);
-	rods.clear();
-	rods.reserve(rhs.rods.size());
-	for (auto l : rhs.rods)
-		rods.push_back(l);
-	bodies.clear();
-	bodies.reserve(rhs.bodies.size());
-	for (auto l : rhs.bodies)
-		bodies.push_back(l);
-
+	check_size(rhs);
+	data += rhs.data;
 	return *this;
 }
 
-MoorDynState
-DMoorDynStateDt::operator*(const real& dt)
-{
-	MoorDynState out;
-
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] * dt);
-	out.conns.reserve(conns.size());
-	for (unsigned int i = 0; i < conns.size(); i++)
-		out.conns.push_back(conns[i] * dt);
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] * dt);
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] * dt);
-
-	return out;
-}
-
-DMoorDynStateDt
-DMoorDynStateDt::operator+(const DMoorDynStateDt& rhs)
-{
-	DMoorDynStateDt out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] + rhs.lines[i]);
-	if (conns.size() != rhs.conns.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.conns.reserve(conns.size());
-	for (unsigned int i = 0; i < conns.size(); i++)
-		out.conns.push_back(conns[i] + rhs.conns[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] + rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] + rhs.bodies[i]);
-
-	return out;
-}
-
-DMoorDynStateDt
-DMoorDynStateDt::operator-(const DMoorDynStateDt& rhs)
+DMoorDynStateDt&
+DMoorDynStateDt::operator-=(const DMoorDynStateDt& rhs)
 {
-	DMoorDynStateDt out;
-
-	if (lines.size() != rhs.lines.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.lines.reserve(lines.size());
-	for (unsigned int i = 0; i < lines.size(); i++)
-		out.lines.push_back(lines[i] - rhs.lines[i]);
-	if (conns.size() != rhs.conns.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.conns.reserve(conns.size());
-	for (unsigned int i = 0; i < conns.size(); i++)
-		out.conns.push_back(conns[i] - rhs.conns[i]);
-	if (rods.size() != rhs.rods.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.rods.reserve(rods.size());
-	for (unsigned int i = 0; i < rods.size(); i++)
-		out.rods.push_back(rods[i] - rhs.rods[i]);
-	if (bodies.size() != rhs.bodies.size())
-		throw moordyn::invalid_value_error("Invalid input size");
-	out.bodies.reserve(bodies.size());
-	for (unsigned int i = 0; i < bodies.size(); i++)
-		out.bodies.push_back(bodies[i] - rhs.bodies[i]);
-
-	return out;
+	check_size(rhs);
+	data -= rhs.data;
+	return *this;
 }
 
 } // ::moordyn
@@ -41,17 +41,26 @@
 
 namespace moordyn {
 
-/** @class StateVar Time.hpp
- * @brief Generic state variables
+/** @class StateVar State.hpp
+ * @brief View of the state variables of an entity
  *
- * This is holding the position and velocitites
+ * This is holding the position and velocitites. The variables are not owned
+ * by this object, which is just mapping a chunk of moordyn::MoorDynState::data
+ * so writing on them is actually writing on the system state
  */
 template<typename T>
 class StateVar
 {
   public:
-	/// @brief Costructor
-	StateVar() {}
+	/** @brief Costructor
+	 * @param p The positions map
+	 * @param v The velocities map
+	 */
+	StateVar(const T& p, const T& v)
+	  : pos(p)
+	  , vel(v)
+	{
+	}
 
 	/// @brief Destructor
 	~StateVar() {}
@@ -60,46 +69,28 @@ class StateVar
 	T pos;
 	/// The velocity
 	T vel;
-
-	/** @brief Give a string representation of the state variables
-	 *
-	 * Useful for debugging purposes
-	 * @return A string representation
-	 */
-	string AsString() const;
-
-	/** @brief Copy operator
-	 * @param visitor The entity to copy
-	 */
-	StateVar<T>& operator=(const StateVar<T>& visitor)
-	{
-		pos = visitor.pos;
-		vel = visitor.vel;
-		return *this;
-	}
-
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
-	 */
-	StateVar<T> operator+(const StateVar<T>& visitor);
-
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
-	 */
-	StateVar<T> operator-(const StateVar<T>& visitor);
 };
 
-/** @class StateVarDeriv Time.hpp
- * @brief Generic state variables derivative
+/** @class StateVarDeriv State.hpp
+ * @brief View of the state variables derivative of an entity
  *
- * This is holding the velocitites and accelerations
+ * This is holding the velocitites and accelerations. The variables are not
+ * owned by this object, which is just mapping a chunk of
+ * moordyn::DMoorDynStateDt::data
  */
-template<class T>
+template<typename T>
 class StateVarDeriv
 {
   public:
-	/// @brief Costructor
-	StateVarDeriv() {}
+	/** @brief Costructor
+	 * @param v The velocities map
+	 * @param a The accelerations map
+	 */
+	StateVarDeriv(const T& v, const T& a)
+	  : vel(v)
+	  , acc(a)
+	{
+	}
 
 	/// @brief Destructor
 	~StateVarDeriv() {}
@@ -108,69 +99,200 @@ class StateVarDeriv
 	T vel;
 	/// The acceleration
 	T acc;
+};
+
+/// The state variables for lines, with a column per internal node
+typedef StateVar<Eigen::Map<vec3N>> LineState;
+
+/// The state variables derivative for lines, with a column per internal node
+typedef StateVarDeriv<Eigen::Map<vec3N>> DLineStateDt;
+
+/// The state variables for connections
+typedef StateVar<Eigen::Map<vec>> ConnState;
+
+/// The state variables derivative for connections
+typedef StateVarDeriv<Eigen::Map<vec>> DConnStateDt;
+
+/// The state variables for rods
+typedef StateVar<Eigen::Map<vec6>> RodState;
+
+/// The state variables derivative for rods
+typedef StateVarDeriv<Eigen::Map<vec6>> DRodStateDt;
 
-	/** @brief Give a string representation of the state variables
+/// The state variables for bodies
+typedef StateVar<Eigen::Map<vec6>> BodyState;
+
+/// The state variables derivative for bodies
+typedef StateVarDeriv<Eigen::Map<vec6>> DBodyStateDt;
+
+/** @class PackedState State.hpp
+ * @brief The variables of the whole system, packed in a single array
+ *
+ * Each entity owns a chunk of the array, where first the positions (or the
+ * velocities) and then the velocities (or the accelerations) are stored. The
+ * lines chunks are stored by coordinates, i.e. first the x coordinate of all
+ * the internal nodes, then the y coordinates and finally the z ones.
+ *
+ * Since the states and their derivatives share the very same layout, the time
+ * integration can be carried out as a single vectorized operation on the
+ * whole array
+ */
+class PackedState
+{
+  public:
+	/// @brief Costructor
+	PackedState() {}
+
+	/** @brief Copy constructor
 	 *
-	 * Useful for debugging purposes
-	 * @return A string representation
+	 * The entities views are built on demand on top of the packed array, so
+	 * the copy owns its own array and never aliases @p visitor
+	 * @param visitor The entity to copy
 	 */
-	string AsString() const;
+	PackedState(const PackedState& visitor) = default;
 
-	/** @brief Copy operator
-	 * @param visitor The entity to copy
+	/// @brief Destructor
+	~PackedState() {}
+
+	/// The packed variables
+	vecN data;
+
+	/** @brief Add a line
+	 * @param n The number of internal nodes
 	 */
-	StateVarDeriv<T>& operator=(const StateVarDeriv<T>& visitor)
+	inline void AddLine(unsigned int n)
 	{
-		vel = visitor.vel;
-		acc = visitor.acc;
-		return *this;
+		line_n.push_back(n);
+		add(line_offset, 6 * n);
 	}
 
-	/** @brief Integrate in time
-	 * @param dt The time step
-	 * @return The state variables increment
+	/** @brief Add a connection
 	 */
-	StateVar<T> operator*(const real& dt);
+	inline void AddConnection() { add(conn_offset, 6); }
 
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
+	/** @brief Add a rod
 	 */
-	StateVarDeriv<T> operator+(const StateVarDeriv<T>& visitor);
+	inline void AddRod() { add(rod_offset, 12); }
 
-	/** @brief Subtract operator
-	 * @param visitor The entity to subtract
+	/** @brief Add a body
 	 */
-	StateVarDeriv<T> operator-(const StateVarDeriv<T>& visitor);
-};
+	inline void AddBody() { add(body_offset, 12); }
 
-/// The state variables for lines
-typedef StateVar<std::vector<vec>> LineState;
+	/** @brief Remove a line
+	 * @param i The index of the line
+	 * @throws moordyn::invalid_value_error If there is not such a line
+	 */
+	inline void RemoveLine(unsigned int i)
+	{
+		if (i >= line_n.size())
+			throw moordyn::invalid_value_error("Invalid line index");
+		remove(line_offset, i, 6 * line_n[i]);
+		line_n.erase(line_n.begin() + i);
+	}
 
-/// The state variables derivative for lines
-typedef StateVarDeriv<std::vector<vec>> DLineStateDt;
+	/** @brief Remove a connection
+	 * @param i The index of the connection
+	 * @throws moordyn::invalid_value_error If there is not such a connection
+	 */
+	inline void RemoveConnection(unsigned int i)
+	{
+		if (i >= conn_offset.size())
+			throw moordyn::invalid_value_error("Invalid connection index");
+		remove(conn_offset, i, 6);
+	}
 
-/// The state variables for connections
-typedef StateVar<vec> ConnState;
+	/** @brief Remove a rod
+	 * @param i The index of the rod
+	 * @throws moordyn::invalid_value_error If there is not such a rod
+	 */
+	inline void RemoveRod(unsigned int i)
+	{
+		if (i >= rod_offset.size())
+			throw moordyn::invalid_value_error("Invalid rod index");
+		remove(rod_offset, i, 12);
+	}
 
-/// The state variables derivative for connections
-typedef StateVarDeriv<vec> DConnStateDt;
+	/** @brief Remove a body
+	 * @param i The index of the body
+	 * @throws moordyn::invalid_value_error If there is not such a body
+	 */
+	inline void RemoveBody(unsigned int i)
+	{
+		if (i >= body_offset.size())
+			throw moordyn::invalid_value_error("Invalid body index");
+		remove(body_offset, i, 12);
+	}
 
-/// The state variables for rods
-typedef StateVar<vec6> RodState;
+	/** @brief Give a string representation of the variables
+	 *
+	 * Useful for debugging purposes
+	 * @return A string representation
+	 */
+	string AsString() const;
 
-/// The state variables derivative for rods
-typedef StateVarDeriv<vec6> DRodStateDt;
+	/** @brief Copy operator
+	 *
+	 * The already allocated memory is reused if the sizes match
+	 * @param visitor The entity to copy
+	 */
+	PackedState& operator=(const PackedState& visitor);
+
+  protected:
+	/// The number of internal nodes of each line
+	std::vector<unsigned int> line_n;
+	/// The first component of each line
+	std::vector<unsigned int> line_offset;
+	/// The first component of each connection
+	std::vector<unsigned int> conn_offset;
+	/// The first component of each rod
+	std::vector<unsigned int> rod_offset;
+	/// The first component of each body
+	std::vector<unsigned int> body_offset;
+
+	/** @brief Get a pointer to the first of the second half of the variables
+	 * of a chunk
+	 * @param offset The first component of the chunk
+	 * @param n The number of components of the chunk
+	 * @return The pointer
+	 */
+	inline real* second(unsigned int offset, unsigned int n)
+	{
+		return data.data() + offset + n / 2;
+	}
 
-/// The state variables for bodies
-typedef StateVar<vec6> BodyState;
+	/** @brief Check that other variables have the same size
+	 * @param visitor The other variables
+	 * @throws moordyn::invalid_value_error If the sizes do not match
+	 */
+	inline void check_size(const PackedState& visitor) const
+	{
+		if (data.size() != visitor.data.size())
+			throw moordyn::invalid_value_error("Invalid input size");
+	}
 
-/// The state variables derivative for bodies
-typedef StateVarDeriv<vec6> DBodyStateDt;
+  private:
+	/** @brief Append a new chunk
+	 * @param offsets The list of offsets of the entity type
+	 * @param n The number of components of the chunk
+	 */
+	void add(std::vector<unsigned int>& offsets, unsigned int n);
+
+	/** @brief Remove a chunk
+	 * @param offsets The list of offsets of the entity type
+	 * @param i The index of the entity within @p offsets
+	 * @param n The number of components of the chunk
+	 */
+	void remove(std::vector<unsigned int>& offsets,
+	            unsigned int i,
+	            unsigned int n);
+};
+
+class DMoorDynStateDt;
 
-/** @class MoorDynState Time.hpp
+/** @class MoorDynState State.hpp
  * @brief The collection of state variables of the whole system
  */
-class MoorDynState
+class MoorDynState : public PackedState
 {
   public:
 	/// @brief Costructor
@@ -179,45 +301,110 @@ class MoorDynState
 	/// @brief Destructor
 	~MoorDynState() {}
 
-	/// The states of the lines
-	std::vector<LineState> lines;
+	/** @brief Get the state of a line
+	 * @param i The index of the line
+	 * @return The positions and velocities of the internal nodes
+	 */
+	inline LineState line(unsigned int i)
+	{
+		const unsigned int n = line_n[i];
+		return LineState(
+		    Eigen::Map<vec3N>(data.data() + line_offset[i], 3, n),
+		    Eigen::Map<vec3N>(second(line_offset[i], 6 * n), 3, n));
+	}
 
-	/// The states of the connections
-	std::vector<ConnState> conns;
+	/** @brief Get the state of a connection
+	 * @param i The index of the connection
+	 * @return The position and velocity
+	 */
+	inline ConnState conn(unsigned int i)
+	{
+		return ConnState(Eigen::Map<vec>(data.data() + conn_offset[i]),
+		                 Eigen::Map<vec>(second(conn_offset[i], 6)));
+	}
 
-	/// The states of the rods
-	std::vector<RodState> rods;
+	/** @brief Get the state of a rod
+	 * @param i The index of the rod
+	 * @return The position and velocity
+	 */
+	inline RodState rod(unsigned int i)
+	{
+		return RodState(Eigen::Map<vec6>(data.data() + rod_offset[i]),
+		                Eigen::Map<vec6>(second(rod_offset[i], 12)));
+	}
 
-	/// The states of the bodies
-	std::vector<BodyState> bodies;
+	/** @brief Get the state of a body
+	 * @param i The index of the body
+	 * @return The position and velocity
+	 */
+	inline BodyState body(unsigned int i)
+	{
+		return BodyState(Eigen::Map<vec6>(data.data() + body_offset[i]),
+		                 Eigen::Map<vec6>(second(body_offset[i], 12)));
+	}
 
-	/** @brief Give a string representation of the state variables
+	/** @brief Set the state as the integration of another one
 	 *
-	 * Useful for debugging purposes
-	 * @return A string representation
+	 * This is equivalent to
+	 * `*this = r0 + drdt_0 * dt_0 + drdt_1 * dt_1 + ...`, computed in a
+	 * single pass over the whole array, without creating temporary objects,
+	 * i.e. without allocating memory. The terms are summed up from left to
+	 * right. @p r0 can be this very same object
+	 * @param r0 The initial state
+	 * @param drdt The first state derivative
+	 * @param dt The first time step
+	 * @param others The rest of derivatives and time steps pairs
+	 * @throws moordyn::invalid_value_error If the sizes do not match
 	 */
-	string AsString() const;
-
-	/** @brief Copy operator
-	 * @param visitor The entity to copy
+	template<typename... Args>
+	inline void Integrate(const MoorDynState& r0,
+	                      const DMoorDynStateDt& drdt,
+	                      const real& dt,
+	                      const Args&... others);
+
+  private:
+	/** @brief Check the sizes of a list of derivatives
+	 * @param drdt The first state derivative
+	 * @param dt The first time step
+	 * @param others The rest of derivatives and time steps pairs
 	 */
-	MoorDynState& operator=(const MoorDynState& visitor);
+	template<typename... Args>
+	inline void check_sizes(const DMoorDynStateDt& drdt,
+	                        const real& dt,
+	                        const Args&... others) const;
 
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
+	/** @brief Terminate the recursion of check_sizes()
 	 */
-	MoorDynState operator+(const MoorDynState& visitor);
-
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
+	inline void check_sizes() const {}
+
+	/** @brief Add the derivatives terms to an Eigen expression
+	 * @param expr The Eigen expression so far
+	 * @param drdt The next state derivative
+	 * @param dt The next time step
+	 * @param others The rest of derivatives and time steps pairs
+	 * @return The Eigen expression
 	 */
-	MoorDynState operator-(const MoorDynState& visitor);
+	template<typename Expr, typename... Args>
+	static inline auto sum(const Expr& expr,
+	                       const DMoorDynStateDt& drdt,
+	                       const real& dt,
+	                       const Args&... others);
+
+	/** @brief Terminate the recursion of sum()
+	 * @param expr The Eigen expression
+	 * @return The Eigen expression
+	 */
+	template<typename Expr>
+	static inline const Expr& sum(const Expr& expr)
+	{
+		return expr;
+	}
 };
 
-/** @class DMoorDynStateDt Time.hpp
+/** @class DMoorDynStateDt State.hpp
  * @brief The collection of state variable derivatives of the whole system
  */
-class DMoorDynStateDt
+class DMoorDynStateDt : public PackedState
 {
   public:
 	/// @brief Costructor
@@ -226,45 +413,95 @@ class DMoorDynStateDt
 	/// @brief Destructor
 	~DMoorDynStateDt() {}
 
-	/// The state derivatives of the lines
-	std::vector<DLineStateDt> lines;
-
-	/// The state derivatives of the connections
-	std::vector<DConnStateDt> conns;
-
-	/// The state derivatives of the rods
-	std::vector<DRodStateDt> rods;
-
-	/// The state derivatives of the bodies
-	std::vector<DBodyStateDt> bodies;
+	/** @brief Get the state derivative of a line
+	 * @param i The index of the line
+	 * @return The velocities and accelerations of the internal nodes
+	 */
+	inline DLineStateDt line(unsigned int i)
+	{
+		const unsigned int n = line_n[i];
+		return DLineStateDt(
+		    Eigen::Map<vec3N>(data.data() + line_offset[i], 3, n),
+		    Eigen::Map<vec3N>(second(line_offset[i], 6 * n), 3, n));
+	}
 
-	/** @brief Give a string representation of the state variables
-	 *
-	 * Useful for debugging purposes
-	 * @return A string representation
+	/** @brief Get the state derivative of a connection
+	 * @param i The index of the connection
+	 * @return The velocity and acceleration
 	 */
-	string AsString() const;
+	inline DConnStateDt conn(unsigned int i)
+	{
+		return DConnStateDt(Eigen::Map<vec>(data.data() + conn_offset[i]),
+		                    Eigen::Map<vec>(second(conn_offset[i], 6)));
+	}
 
-	/** @brief Copy operator
-	 * @param visitor The entity to copy
+	/** @brief Get the state derivative of a rod
+	 * @param i The index of the rod
+	 * @return The velocity and acceleration
 	 */
-	DMoorDynStateDt& operator=(const DMoorDynStateDt& visitor);
+	inline DRodStateDt rod(unsigned int i)
+	{
+		return DRodStateDt(Eigen::Map<vec6>(data.data() + rod_offset[i]),
+		                   Eigen::Map<vec6>(second(rod_offset[i], 12)));
+	}
 
-	/** @brief Integrate in time
-	 * @param dt The time step
-	 * @return The state variables increment
+	/** @brief Get the state derivative of a body
+	 * @param i The index of the body
+	 * @return The velocity and acceleration
 	 */
-	MoorDynState operator*(const real& dt);
+	inline DBodyStateDt body(unsigned int i)
+	{
+		return DBodyStateDt(Eigen::Map<vec6>(data.data() + body_offset[i]),
+		                    Eigen::Map<vec6>(second(body_offset[i], 12)));
+	}
 
-	/** @brief Sum operator
+	/** @brief In place sum operator
+	 *
+	 * No memory is allocated
 	 * @param visitor The entity to sum
+	 * @throws moordyn::invalid_value_error If the sizes do not match
 	 */
-	DMoorDynStateDt operator+(const DMoorDynStateDt& visitor);
+	DMoorDynStateDt& operator+=(const DMoorDynStateDt& visitor);
 
-	/** @brief Sum operator
-	 * @param visitor The entity to sum
+	/** @brief In place subtract operator
+	 *
+	 * No memory is allocated
+	 * @param visitor The entity to subtract
+	 * @throws moordyn::invalid_value_error If the sizes do not match
 	 */
-	DMoorDynStateDt operator-(const DMoorDynStateDt& visitor);
+	DMoorDynStateDt& operator-=(const DMoorDynStateDt& visitor);
 };
 
+template<typename... Args>
+inline void
+MoorDynState::check_sizes(const DMoorDynStateDt& drdt,
+                          const real&,
+                          const Args&... others) const
+{
+	check_size(drdt);
+	check_sizes(others...);
+}
+
+template<typename Expr, typename... Args>
+inline auto
+MoorDynState::sum(const Expr& expr,
+                  const DMoorDynStateDt& drdt,
+                  const real& dt,
+                  const Args&... others)
+{
+	return sum(expr + drdt.data * dt, others...);
+}
+
+template<typename... Args>
+inline void
+MoorDynState::Integrate(const MoorDynState& r0,
+                        const DMoorDynStateDt& drdt,
+                        const real& dt,
+                        const Args&... others)
+{
+	check_size(r0);
+	check_sizes(drdt, dt, others...);
+	data = sum(r0.data + drdt.data * dt, others...);
+}
+
 } // ::moordyn
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022, Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ThreadPool.hpp"
+
+namespace moordyn {
+
+ThreadPool::ThreadPool(unsigned int n)
+  : _batch(0)
+  , _busy(0)
+  , _quit(false)
+  , _fn(NULL)
+  , _ctx(NULL)
+  , _n(0)
+  , _next(0)
+{
+	SetThreads(n);
+}
+
+ThreadPool::~ThreadPool()
+{
+	stop();
+}
+
+void
+ThreadPool::SetThreads(unsigned int n)
+{
+	if (!n)
+		n = std::thread::hardware_concurrency();
+	if (!n)
+		n = 1;
+	if (n == GetThreads())
+		return;
+
+	stop();
+	_quit = false;
+	_workers.reserve(n - 1);
+	for (unsigned int i = 0; i < n - 1; i++)
+		_workers.push_back(std::thread(&ThreadPool::loop, this, _batch));
+}
+
+void
+ThreadPool::run(unsigned int n, task_fn fn, void* ctx)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_fn = fn;
+		_ctx = ctx;
+		_n = n;
+		_next = 0;
+		_error = nullptr;
+		_busy = (unsigned int)_workers.size();
+		_batch++;
+	}
+	_cv_start.notify_all();
+
+	// The calling thread is working as well
+	work();
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_cv_done.wait(lock, [this] { return _busy == 0; });
+		std::swap(error, _error);
+	}
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void
+ThreadPool::work()
+{
+	for (;;) {
+		const unsigned int i = _next.fetch_add(1);
+		if (i >= _n)
+			break;
+		try {
+			_fn(_ctx, i);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (!_error)
+				_error = std::current_exception();
+			// Skip the rest of the tasks
+			_next = _n;
+		}
+	}
+}
+
+void
+ThreadPool::loop(unsigned long batch)
+{
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_cv_start.wait(lock,
+			               [this, batch] { return _quit || (_batch != batch); });
+			if (_quit)
+				return;
+			batch = _batch;
+		}
+		work();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (--_busy == 0)
+				_cv_done.notify_one();
+		}
+	}
+}
+
+void
+ThreadPool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_quit = true;
+	}
+	_cv_start.notify_all();
+	for (auto& worker : _workers)
+		worker.join();
+	_workers.clear();
+}
+
+} // ::moordyn
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2022, Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file ThreadPool.hpp
+ * A minimal persistent thread pool, used to evaluate the objects in parallel
+ */
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace moordyn {
+
+/** @class ThreadPool ThreadPool.hpp
+ * @brief Persistent pool of worker threads
+ *
+ * The pool runs a number of independent tasks, identified by an index. The
+ * tasks are not statically split among the threads. Instead, each thread
+ * (including the calling one) keeps grabbing the next pending task until none
+ * is left, so the load gets balanced if the tasks are sorted from the most
+ * to the least expensive one.
+ *
+ * Dispatching a batch of tasks is not allocating memory, so it can be safely
+ * called on each time step
+ */
+class ThreadPool
+{
+  public:
+	/** @brief Constructor
+	 * @param n The number of threads, including the calling one. 0 to use
+	 * as many threads as hardware threads are available
+	 */
+	ThreadPool(unsigned int n = 1);
+
+	/// @brief Destructor
+	~ThreadPool();
+
+	/** @brief Set the number of threads
+	 *
+	 * The former workers are joined and new ones are launched
+	 * @param n The number of threads, including the calling one. 0 to use
+	 * as many threads as hardware threads are available
+	 */
+	void SetThreads(unsigned int n);
+
+	/** @brief Get the number of threads, including the calling one
+	 * @return The number of threads
+	 */
+	inline unsigned int GetThreads() const
+	{
+		return (unsigned int)_workers.size() + 1;
+	}
+
+	/** @brief Run a batch of tasks, and wait for all of them to finish
+	 *
+	 * If a task throws an exception, the rest of the pending tasks are
+	 * skipped, and the first exception is rethrown on the calling thread
+	 * @param n The number of tasks
+	 * @param f The task functor, called as `f(i)` for each task index
+	 */
+	template<typename F>
+	inline void Run(unsigned int n, F& f)
+	{
+		if (_workers.empty() || (n < 2)) {
+			for (unsigned int i = 0; i < n; i++)
+				f(i);
+			return;
+		}
+		run(n, &ThreadPool::call<F>, (void*)&f);
+	}
+
+  private:
+	/// Type-erased task function
+	typedef void (*task_fn)(void*, unsigned int);
+
+	/** @brief Call a task functor
+	 * @param f The functor
+	 * @param i The task index
+	 */
+	template<typename F>
+	static void call(void* f, unsigned int i)
+	{
+		(*(F*)f)(i);
+	}
+
+	/** @brief Run a batch of tasks
+	 * @param n The number of tasks
+	 * @param fn The task function
+	 * @param ctx The task context
+	 */
+	void run(unsigned int n, task_fn fn, void* ctx);
+
+	/** @brief Execute tasks until there is none left
+	 */
+	void work();
+
+	/** @brief Workers main loop
+	 * @param batch The last batch already known when the worker is launched
+	 */
+	void loop(unsigned long batch);
+
+	/** @brief Join all the workers
+	 */
+	void stop();
+
+	/// The worker threads
+	std::vector<std::thread> _workers;
+	/// Mutex protecting the batch data
+	std::mutex _mutex;
+	/// Condition signaled when a new batch is available
+	std::condition_variable _cv_start;
+	/// Condition signaled when a worker finishes a batch
+	std::condition_variable _cv_done;
+	/// Batch counter, to let the workers know there is a new batch
+	unsigned long _batch;
+	/// Number of workers still busy with the current batch
+	unsigned int _busy;
+	/// Flag to ask the workers to quit
+	bool _quit;
+	/// The current task function
+	task_fn _fn;
+	/// The current task context
+	void* _ctx;
+	/// The number of tasks of the current batch
+	unsigned int _n;
+	/// The next task to be executed
+	std::atomic<unsigned int> _next;
+	/// The first exception thrown by a task
+	std::exception_ptr _error;
+};
+
+} // ::moordyn
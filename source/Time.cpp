@@ -29,16 +29,33 @@
  */
 
 #include "Time.hpp"
+#include "Waves.hpp"
 #include <sstream>
+#include <cmath>
+#include <algorithm>
 
 using namespace std;
 
 namespace moordyn {
 
+void
+TimeScheme::UpdateWaves()
+{
+	if (!waves)
+		return;
+	unsigned int n = conns.size();
+	for (auto obj : lines)
+		n += obj->getN() + 1;
+	for (auto obj : rods)
+		n += obj->getN() + 1;
+	waves->setTime(t, n);
+}
+
 EulerScheme::EulerScheme(moordyn::Log* log)
   : TimeSchemeBase(log)
 {
 	name = "1st order Euler";
+	stab_factor = 0.07;
 }
 
 void
@@ -46,7 +63,7 @@ EulerScheme::Step(real& dt)
 {
 	Update(0.0, 0);
 	CalcStateDeriv(0);
-	r[0] = r[0] + rd[0] * dt;
+	r[0].Integrate(r[0], rd[0], dt);
 	t += dt;
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
@@ -56,19 +73,23 @@ HeunScheme::HeunScheme(moordyn::Log* log)
   : TimeSchemeBase(log)
 {
 	name = "2nd order Heun";
+	stab_factor = 0.3;
 }
 
 void
 HeunScheme::Step(real& dt)
 {
 	// Apply the latest knew derivative, as a predictor
-	r[0] = r[0] + rd[0] * dt;
+	r[0].Integrate(r[0], rd[0], dt);
 	rd[1] = rd[0];
 	// Compute the new derivative
 	Update(0.0, 0);
 	CalcStateDeriv(0);
-	// Correct the integration
-	r[0] = r[0] + (rd[0] - rd[1]) * (0.5 * dt);
+	// Correct the integration. The predictor derivative is not required
+	// anymore, so we can overwrite it with the derivatives difference, i.e.
+	// rd[1] - rd[0], which is applied with the opposite sign
+	rd[1] -= rd[0];
+	r[0].Integrate(r[0], rd[1], -0.5 * dt);
 
 	t += dt;
 	Update(dt, 0);
@@ -79,6 +100,7 @@ RK2Scheme::RK2Scheme(moordyn::Log* log)
   : TimeSchemeBase(log)
 {
 	name = "2nd order Runge-Kutta";
+	stab_factor = 0.5;
 }
 
 void
@@ -89,11 +111,11 @@ RK2Scheme::Step(real& dt)
 	// Compute the intermediate state
 	CalcStateDeriv(0);
 	t += 0.5 * dt;
-	r[1] = r[0] + rd[0] * (0.5 * dt);
+	r[1].Integrate(r[0], rd[0], 0.5 * dt);
 	Update(0.5 * dt, 1);
 	// And so we can compute the new derivative and apply it
 	CalcStateDeriv(0);
-	r[0] = r[0] + rd[0] * dt;
+	r[0].Integrate(r[0], rd[0], dt);
 
 	t += 0.5 * dt;
 	Update(dt, 0);
@@ -104,6 +126,7 @@ RK4Scheme::RK4Scheme(moordyn::Log* log)
   : TimeSchemeBase(log)
 {
 	name = "4th order Runge-Kutta";
+	stab_factor = 1.1;
 }
 
 void
@@ -116,23 +139,26 @@ RK4Scheme::Step(real& dt)
 
 	// k2
 	t += 0.5 * dt;
-	r[1] = r[0] + rd[0] * (0.5 * dt);
+	r[1].Integrate(r[0], rd[0], 0.5 * dt);
 	Update(0.5 * dt, 1);
 	CalcStateDeriv(1);
 
 	// k3
-	r[1] = r[0] + rd[1] * (0.5 * dt);
+	r[1].Integrate(r[0], rd[1], 0.5 * dt);
 	Update(0.5 * dt, 1);
 	CalcStateDeriv(2);
 
 	// k4
 	t += 0.5 * dt;
-	r[2] = r[0] + rd[2] * dt;
+	r[2].Integrate(r[0], rd[2], dt);
 	Update(dt, 2);
 	CalcStateDeriv(3);
 
-	// Apply
-	r[0] = r[0] + (rd[0] + rd[3]) * (dt / 6.0) + (rd[1] + rd[2]) * (dt / 3.0);
+	// Apply. The derivatives are not required anymore, so they are summed up
+	// in place
+	rd[0] += rd[3];
+	rd[1] += rd[2];
+	r[0].Integrate(r[0], rd[0], dt / 6.0, rd[1], dt / 3.0);
 
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
@@ -146,6 +172,7 @@ ABScheme<order>::ABScheme(moordyn::Log* log)
 	stringstream s;
 	s << order << "th order Adam-Bashforth";
 	name = s.str();
+	stab_factor = 0.07;
 	if (order > 4) {
 		LOGWRN << name
 		       << " scheme queried, but 4th order is the maximum implemented"
@@ -166,24 +193,43 @@ ABScheme<order>::Step(real& dt)
 	// Apply different formulas depending on the number of derivatives available
 	switch (n_steps) {
 		case 0:
-			r[0] = r[0] + rd[0] * dt;
+			r[0].Integrate(r[0], rd[0], dt);
 			break;
 		case 1:
-			r[0] = r[0] + rd[0] * (dt * 1.5) - rd[1] * (dt * 0.5);
+			r[0].Integrate(r[0], rd[0], dt * 1.5, rd[1], -(dt * 0.5));
 			break;
 		case 2:
-			r[0] = r[0] + rd[0] * (dt * 23.0 / 12.0) -
-			       rd[1] * (dt * 4.0 / 3.0) + rd[2] * (dt * 5.0 / 12.0);
+			r[0].Integrate(r[0],
+			               rd[0],
+			               dt * 23.0 / 12.0,
+			               rd[1],
+			               -(dt * 4.0 / 3.0),
+			               rd[2],
+			               dt * 5.0 / 12.0);
 			break;
 		case 3:
-			r[0] = r[0] + rd[0] * (dt * 55.0 / 24.0) -
-			       rd[1] * (dt * 59.0 / 24.0) + rd[2] * (dt * 37.0 / 24.0) -
-			       rd[3] * (dt * 3.0 / 8.0);
+			r[0].Integrate(r[0],
+			               rd[0],
+			               dt * 55.0 / 24.0,
+			               rd[1],
+			               -(dt * 59.0 / 24.0),
+			               rd[2],
+			               dt * 37.0 / 24.0,
+			               rd[3],
+			               -(dt * 3.0 / 8.0));
 			break;
 		default:
-			r[0] = r[0] + rd[0] * (dt * 1901.0 / 720.0) -
-			       rd[1] * (dt * 1387.0 / 360.0) + rd[2] * (dt * 109.0 / 30.0) -
-			       rd[3] * (dt * 637.0 / 360.0) + rd[4] * (dt * 251.0 / 720.0);
+			r[0].Integrate(r[0],
+			               rd[0],
+			               dt * 1901.0 / 720.0,
+			               rd[1],
+			               -(dt * 1387.0 / 360.0),
+			               rd[2],
+			               dt * 109.0 / 30.0,
+			               rd[3],
+			               -(dt * 637.0 / 360.0),
+			               rd[4],
+			               dt * 251.0 / 720.0);
 	}
 
 	t += dt;
@@ -201,6 +247,7 @@ ImplicitEulerScheme::ImplicitEulerScheme(moordyn::Log* log,
 	stringstream s;
 	s << "k=" << dt_factor << " implicit Euler (" << iters << " iterations)";
 	name = s.str();
+	stab_factor = (dt_factor < 1.0) ? 0.6 : 0.4;
 }
 
 void
@@ -208,18 +255,450 @@ ImplicitEulerScheme::Step(real& dt)
 {
 	t += _dt_factor * dt;
 	for (unsigned int i = 0; i < _iters; i++) {
-		r[1] = r[0] + rd[0] * (_dt_factor * dt);
+		r[1].Integrate(r[0], rd[0], _dt_factor * dt);
 		Update(_dt_factor * dt, 1);
 		CalcStateDeriv(0);
 	}
 
 	// Apply
-	r[0] = r[0] + rd[0] * dt;
+	r[0].Integrate(r[0], rd[0], dt);
 	t += (1.0 - _dt_factor) * dt;
 	Update(dt, 0);
 	TimeSchemeBase::Step(dt);
 }
 
+RK45Scheme::RK45Scheme(moordyn::Log* log)
+  : TimeSchemeBase(log)
+  , _atol(1.0e-6)
+  , _rtol(1.0e-4)
+  , _dt_min(1.0e-6)
+  , dt_next(0.0)
+  , fsal(false)
+  , n_accepted(0)
+  , n_rejected(0)
+  , dt_min_used(0.0)
+  , dt_max_used(0.0)
+{
+	name = "5th order adaptive Dormand-Prince Runge-Kutta";
+	stab_factor = 1.1;
+}
+
+RK45Scheme::~RK45Scheme()
+{
+	LOGMSG << name << ": " << n_accepted << " accepted and " << n_rejected
+	       << " rejected time steps, dt in [" << dt_min_used << ", "
+	       << dt_max_used << "] s" << endl;
+}
+
+void
+RK45Scheme::SetTolerances(real atol, real rtol)
+{
+	if ((atol <= 0.0) || (rtol <= 0.0)) {
+		LOGERR << "Invalid tolerances, atol = " << atol << ", rtol = " << rtol
+		       << endl;
+		throw moordyn::invalid_value_error("Invalid tolerances");
+	}
+	_atol = atol;
+	_rtol = rtol;
+}
+
+void
+RK45Scheme::SetMinTimeStep(real dt)
+{
+	if (dt < 0.0) {
+		LOGERR << "Invalid minimum time step, " << dt << endl;
+		throw moordyn::invalid_value_error("Invalid time step");
+	}
+	_dt_min = dt;
+}
+
+/** @brief Time step scaling factor to get a unit error
+ * @param err The scaled error with the current time step
+ * @return The scaling factor, including a safety factor
+ */
+inline real
+step_factor(real err)
+{
+	if (err <= 0.0)
+		return 5.0;
+	return 0.9 * std::pow(err, real(-0.2));
+}
+
+real
+RK45Scheme::Error(real dt)
+{
+	if (!r[0].data.size())
+		return 0.0;
+
+	// Difference between the 5th order and the 4th order solutions
+	r[1].data.setZero();
+	r[1].Integrate(r[1],
+	               rd[0],
+	               dt * 71.0 / 57600.0,
+	               rd[2],
+	               -(dt * 71.0 / 16695.0),
+	               rd[3],
+	               dt * 71.0 / 1920.0,
+	               rd[4],
+	               -(dt * 17253.0 / 339200.0),
+	               rd[5],
+	               dt * 22.0 / 525.0,
+	               rd[6],
+	               -(dt / 40.0));
+
+	return std::sqrt(
+	    (r[1].data.array() /
+	     (_atol + _rtol * r[0].data.array().abs().max(r[2].data.array().abs())))
+	        .square()
+	        .mean());
+}
+
+void
+RK45Scheme::Step(real& dt)
+{
+	// The last derivative of the former step can be reused, unless a new outer
+	// time step has just started, since the coupled entities have moved
+	if (!fsal || (t_local == 0.0)) {
+		Update(0.0, 0);
+		CalcStateDeriv(0);
+	} else {
+		rd[0] = rd[6];
+	}
+
+	// Try the time step proposed by the former step, but avoid leaving a tiny
+	// step to reach the target time
+	real h = dt;
+	if ((dt_next > 0.0) && (dt_next < dt))
+		h = (dt < 2.0 * dt_next) ? 0.5 * dt : dt_next;
+	// If the step is shortened to reach the target time, the next one shall
+	// not be reduced because of that
+	bool shortened = h < dt_next;
+
+	const real t0 = t;
+	real err;
+	for (;;) {
+		// k2
+		t = t0 + 0.2 * h;
+		r[1].Integrate(r[0], rd[0], h * 0.2);
+		Update(0.2 * h, 1);
+		CalcStateDeriv(1);
+
+		// k3
+		t = t0 + 0.3 * h;
+		r[1].Integrate(r[0], rd[0], h * 3.0 / 40.0, rd[1], h * 9.0 / 40.0);
+		Update(0.3 * h, 1);
+		CalcStateDeriv(2);
+
+		// k4
+		t = t0 + 0.8 * h;
+		r[1].Integrate(r[0],
+		               rd[0],
+		               h * 44.0 / 45.0,
+		               rd[1],
+		               -(h * 56.0 / 15.0),
+		               rd[2],
+		               h * 32.0 / 9.0);
+		Update(0.8 * h, 1);
+		CalcStateDeriv(3);
+
+		// k5
+		t = t0 + h * 8.0 / 9.0;
+		r[1].Integrate(r[0],
+		               rd[0],
+		               h * 19372.0 / 6561.0,
+		               rd[1],
+		               -(h * 25360.0 / 2187.0),
+		               rd[2],
+		               h * 64448.0 / 6561.0,
+		               rd[3],
+		               -(h * 212.0 / 729.0));
+		Update(h * 8.0 / 9.0, 1);
+		CalcStateDeriv(4);
+
+		// k6
+		t = t0 + h;
+		r[1].Integrate(r[0],
+		               rd[0],
+		               h * 9017.0 / 3168.0,
+		               rd[1],
+		               -(h * 355.0 / 33.0),
+		               rd[2],
+		               h * 46732.0 / 5247.0,
+		               rd[3],
+		               h * 49.0 / 176.0,
+		               rd[4],
+		               -(h * 5103.0 / 18656.0));
+		Update(h, 1);
+		CalcStateDeriv(5);
+
+		// 5th order solution, and its derivative, k7
+		r[2].Integrate(r[0],
+		               rd[0],
+		               h * 35.0 / 384.0,
+		               rd[2],
+		               h * 500.0 / 1113.0,
+		               rd[3],
+		               h * 125.0 / 192.0,
+		               rd[4],
+		               -(h * 2187.0 / 6784.0),
+		               rd[5],
+		               h * 11.0 / 84.0);
+		Update(h, 2);
+		CalcStateDeriv(6);
+
+		err = Error(h);
+		if (err <= 1.0)
+			break;
+		if (h <= _dt_min) {
+			LOGWRN << "t = " << t0 << " s: The tolerances cannot be met with "
+			       << "the minimum time step, dt = " << h << " s (error = "
+			       << err << ")" << endl;
+			break;
+		}
+
+		// Reject the step and try again with a smaller one. r[0] and rd[0]
+		// have not been modified
+		n_rejected++;
+		LOGDBG << "t = " << t0 << " s: Rejected dt = " << h
+		       << " s (error = " << err << ")" << endl;
+		h = std::max(_dt_min, h * std::max(real(0.2), step_factor(err)));
+		shortened = false;
+	}
+
+	// Accept the step. The entities are already set at the new state, and its
+	// derivative can be reused on the next step
+	r[0] = r[2];
+	t = t0 + h;
+	fsal = true;
+	n_accepted++;
+	dt_min_used = (n_accepted == 1) ? h : std::min(dt_min_used, h);
+	dt_max_used = std::max(dt_max_used, h);
+
+	// Estimate the next time step
+	const real factor =
+	    std::min(real(5.0), std::max(real(0.2), step_factor(err)));
+	dt_next = shortened ? std::max(dt_next, h * factor)
+	                    : std::max(_dt_min, h * factor);
+
+	dt = h;
+	TimeSchemeBase::Step(dt);
+}
+
+MultiRateScheme::MultiRateScheme(moordyn::Log* log, real cfl)
+  : TimeSchemeBase(log)
+  , _cfl(cfl)
+{
+	name = "2nd order multi-rate";
+	stab_factor = 0.3;
+}
+
+void
+MultiRateScheme::Step(real& dt)
+{
+	// Choose the lines substeps, which might change if the lines are
+	// stretched or the outer time step is modified
+	substeps.resize(lines.size(), 0);
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		const real dt_line = LineTimeStep(i);
+		const unsigned int n =
+		    std::max(1u, (unsigned int)std::ceil(dt / dt_line));
+		if (n != substeps[i]) {
+			LOGDBG << "Line " << lines[i]->number << " integrated in " << n
+			       << " substeps of " << dt / n << " s" << endl;
+		}
+		substeps[i] = n;
+	}
+
+	Update(0.0, 0);
+	CalcStateDeriv(0);
+	StoreEnds(ends0);
+
+	// Predict the state at the end of the time step to get the lines end
+	// points kinematics there
+	t += dt;
+	r[1].Integrate(r[0], rd[0], dt);
+	const real dt2 = 0.5 * dt * dt;
+	for (unsigned int i = 0; i < conns.size(); i++) {
+		auto dst = r[1].conn(i);
+		dst.pos += dt2 * rd[0].conn(i).acc;
+	}
+	for (unsigned int i = 0; i < rods.size(); i++) {
+		auto dst = r[1].rod(i);
+		dst.pos.head<3>() += dt2 * rd[0].rod(i).acc.head<3>();
+	}
+	for (unsigned int i = 0; i < bodies.size(); i++) {
+		auto dst = r[1].body(i);
+		dst.pos.head<3>() += dt2 * rd[0].body(i).acc.head<3>();
+	}
+	Update(dt, 1);
+	StoreEnds(ends1);
+
+	// Subcycle the lines, which are independent now
+	auto subcycle = [this, dt](unsigned int j) {
+		Subcycle(lines_order[j], dt);
+	};
+	pool.Run(lines.size(), subcycle);
+
+	// Correct the rest of entities with the derivative at the end of the time
+	// step, which is also considering the subcycled lines
+	Update(dt, 1);
+	CalcStateDeriv(1);
+	rd[0] += rd[1];
+	r[0].Integrate(r[0], rd[0], 0.5 * dt);
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		auto dst = r[0].line(i);
+		const auto src = r[1].line(i);
+		dst.pos = src.pos;
+		dst.vel = src.vel;
+	}
+
+	Update(dt, 0);
+	TimeSchemeBase::Step(dt);
+}
+
+void
+MultiRateScheme::StoreEnds(std::vector<std::array<vec, 4>>& ends)
+{
+	ends.resize(lines.size());
+	for (unsigned int i = 0; i < lines.size(); i++) {
+		const unsigned int n = lines[i]->getN();
+		ends[i][0] = lines[i]->getNodePos(0);
+		ends[i][1] = lines[i]->getNodeVel(0);
+		ends[i][2] = lines[i]->getNodePos(n);
+		ends[i][3] = lines[i]->getNodeVel(n);
+	}
+}
+
+void
+MultiRateScheme::SetLine(unsigned int i,
+                         real s,
+                         real dt,
+                         const LineState& state)
+{
+	const real f = s / dt;
+	const auto& e0 = ends0[i];
+	const auto& e1 = ends1[i];
+	Line* line = lines[i];
+	line->setTime(t - dt + s);
+	line->updateUnstretchedLength(t_local + s);
+	line->moveEndPoint((1.0 - f) * e0[0] + f * e1[0],
+	                   (1.0 - f) * e0[1] + f * e1[1],
+	                   ENDPOINT_A);
+	line->moveEndPoint((1.0 - f) * e0[2] + f * e1[2],
+	                   (1.0 - f) * e0[3] + f * e1[3],
+	                   ENDPOINT_B);
+	line->setState(state.pos, state.vel);
+}
+
+void
+MultiRateScheme::Subcycle(unsigned int i, real dt)
+{
+	// The quasi-static lines have nothing to integrate, they are already
+	// solved with the rest of entities
+	if (lines[i]->isQuasiStatic())
+		return;
+	const unsigned int n = substeps[i];
+	const real h = dt / n;
+	const auto r0 = r[0].line(i);
+	auto r1 = r[1].line(i);
+	auto d0 = rd[0].line(i);
+
+	r1.pos = r0.pos;
+	r1.vel = r0.vel;
+	for (unsigned int k = 0; k < n; k++) {
+		const real s = k * h;
+		SetLine(i, s, dt, r1);
+		// The derivative at the beginning of the first substep is already
+		// known
+		if (k)
+			lines[i]->getStateDeriv(d0);
+		LineSubstep(i, s, h, dt);
+	}
+}
+
+void
+MultiRateScheme::LineSubstep(unsigned int i, real s, real h, real dt)
+{
+	auto r1 = r[1].line(i);
+	auto r2 = r[2].line(i);
+	auto d0 = rd[0].line(i);
+	auto d1 = rd[1].line(i);
+
+	r2.pos = r1.pos + (0.5 * h) * d0.vel;
+	r2.vel = r1.vel + (0.5 * h) * d0.acc;
+	SetLine(i, s + 0.5 * h, dt, r2);
+	lines[i]->getStateDeriv(d1);
+	r1.pos += h * d1.vel;
+	r1.vel += h * d1.acc;
+}
+
+IMEXScheme::IMEXScheme(moordyn::Log* log, real cfl)
+  : MultiRateScheme(log, cfl)
+{
+	name = "2nd order implicit-explicit";
+}
+
+void
+IMEXScheme::Step(real& dt)
+{
+	// The work arrays are resized on demand, so they just allocate memory on
+	// the first time step
+	work.resize(lines.size());
+	MultiRateScheme::Step(dt);
+}
+
+void
+IMEXScheme::LineSubstep(unsigned int i, real, real h, real dt)
+{
+	Line* line = lines[i];
+	LineWork& w = work[i];
+	auto r1 = r[1].line(i);
+	const auto d0 = rd[0].line(i);
+	const unsigned int N = line->getN();
+
+	// Linearize the axial forces around the current state
+	line->getAxialJacobian(w.K, w.C);
+
+	// The nodes motion if the acceleration were kept constant, which is the
+	// known part of the Newmark displacements and velocity changes. For the
+	// end points it is the actual motion, linearly interpolated
+	const real f = h / dt;
+	const auto& e0 = ends0[i];
+	const auto& e1 = ends1[i];
+	w.u.resize(3, N + 1);
+	w.w.resize(3, N + 1);
+	w.u.middleCols(1, N - 1) = h * r1.vel + (0.5 * h * h) * d0.acc;
+	w.w.middleCols(1, N - 1) = h * d0.acc;
+	w.u.col(0) = f * (e1[0] - e0[0]);
+	w.w.col(0) = f * (e1[1] - e0[1]);
+	w.u.col(N) = f * (e1[2] - e0[2]);
+	w.w.col(N) = f * (e1[3] - e0[3]);
+
+	// Assemble the block tridiagonal system for the acceleration change
+	// at the internal nodes,
+	// (M + h^2 / 4 K + h / 2 C) da = K u + C w
+	const real kf = 0.25 * h * h;
+	const real cf = 0.5 * h;
+	w.D.resize(N - 1);
+	w.U.resize(N - 1);
+	w.b.resize(3, N - 1);
+	for (unsigned int j = 1; j < N; j++) {
+		w.D[j - 1] = line->getNodeMass(j) + kf * (w.K[j - 1] + w.K[j]) +
+		             cf * (w.C[j - 1] + w.C[j]);
+		w.U[j - 1] = -kf * w.K[j] - cf * w.C[j];
+		const vec b = w.K[j - 1] * (w.u.col(j - 1) - w.u.col(j)) +
+		              w.K[j] * (w.u.col(j + 1) - w.u.col(j)) +
+		              w.C[j - 1] * (w.w.col(j - 1) - w.w.col(j)) +
+		              w.C[j] * (w.w.col(j + 1) - w.w.col(j));
+		w.b.col(j - 1) = b;
+	}
+	solve_block_tridiagonal(w.D, w.U, w.b);
+
+	// Apply the Newmark scheme
+	r1.pos += w.u.middleCols(1, N - 1) + kf * w.b;
+	r1.vel += w.w.middleCols(1, N - 1) + cf * w.b;
+}
+
 TimeScheme*
 create_time_scheme(const std::string& name, moordyn::Log* log)
 {
@@ -232,6 +711,12 @@ create_time_scheme(const std::string& name, moordyn::Log* log)
 		out = new RK2Scheme(log);
 	} else if (str::lower(name) == "rk4") {
 		out = new RK4Scheme(log);
+	} else if (str::lower(name) == "rk45") {
+		out = new RK45Scheme(log);
+	} else if (str::lower(name) == "multirate") {
+		out = new MultiRateScheme(log);
+	} else if (str::lower(name) == "imex") {
+		out = new IMEXScheme(log);
 	} else if (str::lower(name) == "ab2") {
 		out = new ABScheme<2>(log);
 	} else if (str::lower(name) == "ab3") {
@@ -41,11 +41,17 @@
 #include "Connection.hpp"
 #include "Rod.hpp"
 #include "Body.hpp"
+#include "ThreadPool.hpp"
 #include <vector>
 #include <string>
+#include <numeric>
+#include <limits>
+#include <algorithm>
 
 namespace moordyn {
 
+class Waves;
+
 /** @class TimeScheme Time.hpp
  * @brief Time scheme abstraction
  *
@@ -63,6 +69,11 @@ class TimeScheme : public io::IO
 	 */
 	inline void SetGround(Body* obj) { ground = obj; }
 
+	/** @brief Set the waves kinematics grid
+	 * @param obj The waves, NULL if there are none
+	 */
+	inline void SetWaves(Waves* obj) { waves = obj; }
+
 	/** @brief Add a line
 	 * @param obj The line
 	 * @throw moordyn::invalid_value_error If it has been already registered
@@ -75,6 +86,7 @@ class TimeScheme : public io::IO
 			throw moordyn::invalid_value_error("Repeated object");
 		}
 		lines.push_back(obj);
+		SortLines();
 	}
 
 	/** @brief Remove a line
@@ -93,6 +105,7 @@ class TimeScheme : public io::IO
 		}
 		const unsigned int i = std::distance(lines.begin(), it);
 		lines.erase(it);
+		SortLines();
 		return i;
 	}
 
@@ -214,6 +227,44 @@ class TimeScheme : public io::IO
 	 */
 	inline void UnSetExtWaves() { has_ext_waves = false; }
 
+	/** @brief Set the number of threads used to evaluate the lines
+	 *
+	 * The lines are independent objects, so their states and derivatives can
+	 * be computed in parallel. The rest of entities, which depend on the
+	 * lines, are computed afterwards by the calling thread. The results do
+	 * not depend on the number of threads
+	 * @param n The number of threads. 1 to work in serial (default), 0 to use
+	 * all the available hardware threads
+	 */
+	inline void SetThreads(unsigned int n) { pool.SetThreads(n); }
+
+	/** @brief Get the number of threads used to evaluate the lines
+	 * @return The number of threads
+	 */
+	inline unsigned int GetThreads() const { return pool.GetThreads(); }
+
+	/** @brief Estimate the largest stable time step for a line
+	 * @param obj The line
+	 * @return The line critical time step scaled by the scheme stability
+	 * factor
+	 * @see moordyn::Line::getCriticalTimeStep()
+	 */
+	virtual real GetStableTimeStep(const Line* obj) const
+	{
+		return stab_factor * obj->getCriticalTimeStep();
+	}
+
+	/** @brief Estimate the largest stable time step for a rod
+	 * @param obj The rod
+	 * @return The rod critical time step scaled by the scheme stability
+	 * factor
+	 * @see moordyn::Rod::getCriticalTimeStep()
+	 */
+	virtual real GetStableTimeStep(const Rod* obj) const
+	{
+		return stab_factor * obj->getCriticalTimeStep();
+	}
+
 	/** @brief Get the name of the scheme
 	 * @return The name
 	 */
@@ -224,6 +275,29 @@ class TimeScheme : public io::IO
 	 */
 	inline real GetTime() const { return t; }
 
+	/** @brief Get the registered lines
+	 * @return The lines
+	 */
+	inline const std::vector<Line*>& GetLines() const { return lines; }
+
+	/** @brief Get the registered rods
+	 * @return The rods
+	 */
+	inline const std::vector<Rod*>& GetRods() const { return rods; }
+
+	/** @brief Get the registered bodies
+	 * @return The bodies
+	 */
+	inline const std::vector<Body*>& GetBodies() const { return bodies; }
+
+	/** @brief Get the number of time derivatives evaluations so far
+	 *
+	 * Each connection, rod and body is evaluated at most once on each one,
+	 * see moordyn::Body::getRHSCount()
+	 * @return The number of evaluations
+	 */
+	inline unsigned long GetDerivEvals() const { return n_derivs; }
+
 	/** @brief Set the simulation time
 	 * @param time The time
 	 * @note This method is also calling to TimeScheme::Next()
@@ -253,6 +327,27 @@ class TimeScheme : public io::IO
 	 */
 	virtual void init() = 0;
 
+	/** @brief Find the static equilibrium of the free entities
+	 *
+	 * The equilibrium is written on the current state, with null velocities
+	 * @param tol The tolerance, i.e. the maximum acceptable acceleration of
+	 * the line nodes and the free entities
+	 * @param max_iters The maximum number of Newton iterations
+	 * @return true if the equilibrium has been found, false otherwise
+	 */
+	virtual bool SolveStatics(real tol, unsigned int max_iters) = 0;
+
+	/** @brief Relax the system to the static equilibrium with kinetic damping
+	 *
+	 * The equilibrium is written on the current state, with null velocities
+	 * @param dt The time step
+	 * @param tol The tolerance, i.e. the maximum acceptable acceleration of
+	 * the line nodes and the free entities
+	 * @param t_max The maximum simulation time
+	 * @return true if the equilibrium has been found, false otherwise
+	 */
+	virtual bool RelaxKinetic(real dt, real tol, real t_max) = 0;
+
 	/** @brief Run a time step
 	 *
 	 * This function is the one that must be specialized on each time scheme,
@@ -268,9 +363,12 @@ class TimeScheme : public io::IO
 	 */
 	TimeScheme(moordyn::Log* log)
 	  : io::IO(log)
+	  , waves(NULL)
 	  , has_ext_waves(false)
 	  , name("None")
 	  , t(0.0)
+	  , stab_factor(0.5)
+	  , n_derivs(0)
 	{
 	}
 
@@ -289,6 +387,16 @@ class TimeScheme : public io::IO
 	/// The bodies
 	std::vector<Body*> bodies;
 
+	/// The waves kinematics grid
+	Waves* waves;
+
+	/** @brief Freeze the waves kinematics grid at the current time
+	 *
+	 * The grid is queried by every single line and rod node, as well as by
+	 * the connections
+	 */
+	void UpdateWaves();
+
 	/// External waves
 	bool has_ext_waves;
 	/// time corresponding to the wave kinematics data
@@ -305,6 +413,35 @@ class TimeScheme : public io::IO
 	real t;
 	/// The local time, within the outer time step
 	real t_local;
+
+	/// The fraction of the objects critical time step that the scheme can
+	/// stably take, measured on lightly damped lines
+	real stab_factor;
+
+	/// Number of time derivatives evaluations, for debugging purposes
+	unsigned long n_derivs;
+
+	/// The threads pool to evaluate the lines
+	ThreadPool pool;
+	/// The lines indexes, sorted from the largest to the smallest one
+	std::vector<unsigned int> lines_order;
+
+  private:
+	/** @brief Sort the lines by their number of nodes
+	 *
+	 * The threads pool takes the tasks in order, so the largest lines are
+	 * dispatched first to get a better load balance
+	 */
+	inline void SortLines()
+	{
+		lines_order.resize(lines.size());
+		std::iota(lines_order.begin(), lines_order.end(), 0);
+		std::stable_sort(lines_order.begin(),
+		                 lines_order.end(),
+		                 [this](unsigned int a, unsigned int b) {
+			                 return lines[a]->getN() > lines[b]->getN();
+		                 });
+	}
 };
 
 /** @class TimeSchemeBase Time.hpp
@@ -330,20 +467,13 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		// Build up the states and states derivatives
-		unsigned int n = obj->getN() - 1;
-		LineState state;
-		state.pos.assign(n, vec::Zero());
-		state.vel.assign(n, vec::Zero());
-		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].lines.push_back(state);
-		}
-		DLineStateDt dstate;
-		dstate.vel.assign(n, vec::Zero());
-		dstate.acc.assign(n, vec::Zero());
-		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].lines.push_back(dstate);
-		}
+		// Build up the states and states derivatives. The quasi-static lines
+		// have no states
+		const unsigned int n = obj->isQuasiStatic() ? 0 : obj->getN() - 1;
+		for (unsigned int i = 0; i < r.size(); i++)
+			r[i].AddLine(n);
+		for (unsigned int i = 0; i < rd.size(); i++)
+			rd[i].AddLine(n);
 	}
 
 	/** @brief Remove a line
@@ -360,10 +490,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].lines.erase(r[i].lines.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].lines.erase(rd[i].lines.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemoveLine(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemoveLine(i);
 		return i;
 	}
 
@@ -379,18 +509,10 @@ class TimeSchemeBase : public TimeScheme
 			throw;
 		}
 		// Build up the states and states derivatives
-		ConnState state;
-		state.pos = vec::Zero();
-		state.vel = vec::Zero();
-		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].conns.push_back(state);
-		}
-		DConnStateDt dstate;
-		dstate.vel = vec::Zero();
-		dstate.acc = vec::Zero();
-		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].conns.push_back(dstate);
-		}
+		for (unsigned int i = 0; i < r.size(); i++)
+			r[i].AddConnection();
+		for (unsigned int i = 0; i < rd.size(); i++)
+			rd[i].AddConnection();
 	}
 
 	/** @brief Remove a connection
@@ -407,10 +529,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].conns.erase(r[i].conns.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].conns.erase(rd[i].conns.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemoveConnection(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemoveConnection(i);
 		return i;
 	}
 
@@ -426,18 +548,10 @@ class TimeSchemeBase : public TimeScheme
 			throw;
 		}
 		// Build up the states and states derivatives
-		RodState state;
-		state.pos = vec6::Zero();
-		state.vel = vec6::Zero();
-		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].rods.push_back(state);
-		}
-		DRodStateDt dstate;
-		dstate.vel = vec6::Zero();
-		dstate.acc = vec6::Zero();
-		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].rods.push_back(dstate);
-		}
+		for (unsigned int i = 0; i < r.size(); i++)
+			r[i].AddRod();
+		for (unsigned int i = 0; i < rd.size(); i++)
+			rd[i].AddRod();
 	}
 
 	/** @brief Remove a rod
@@ -454,10 +568,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].rods.erase(r[i].rods.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].rods.erase(rd[i].rods.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemoveRod(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemoveRod(i);
 		return i;
 	}
 
@@ -473,18 +587,10 @@ class TimeSchemeBase : public TimeScheme
 			throw;
 		}
 		// Build up the states and states derivatives
-		BodyState state;
-		state.pos = vec6::Zero();
-		state.vel = vec6::Zero();
-		for (unsigned int i = 0; i < r.size(); i++) {
-			r[i].bodies.push_back(state);
-		}
-		DBodyStateDt dstate;
-		dstate.vel = vec6::Zero();
-		dstate.acc = vec6::Zero();
-		for (unsigned int i = 0; i < rd.size(); i++) {
-			rd[i].bodies.push_back(dstate);
-		}
+		for (unsigned int i = 0; i < r.size(); i++)
+			r[i].AddBody();
+		for (unsigned int i = 0; i < rd.size(); i++)
+			rd[i].AddBody();
 	}
 
 	/** @brief Remove a body
@@ -501,10 +607,10 @@ class TimeSchemeBase : public TimeScheme
 		} catch (...) {
 			throw;
 		}
-		for (unsigned int i = 0; i < r.size(); i++)
-			r[i].bodies.erase(r[i].bodies.begin() + i);
-		for (unsigned int i = 0; i < rd.size(); i++)
-			rd[i].bodies.erase(rd[i].bodies.begin() + i);
+		for (unsigned int j = 0; j < r.size(); j++)
+			r[j].RemoveBody(i);
+		for (unsigned int j = 0; j < rd.size(); j++)
+			rd[j].RemoveBody(i);
 		return i;
 	}
 
@@ -521,30 +627,313 @@ class TimeSchemeBase : public TimeScheme
 		for (unsigned int i = 0; i < bodies.size(); i++) {
 			if (bodies[i]->type != Body::FREE)
 				continue;
-			std::tie(r[0].bodies[i].pos, r[0].bodies[i].vel) =
-			    bodies[i]->initialize();
+			auto state = r[0].body(i);
+			std::tie(state.pos, state.vel) = bodies[i]->initialize();
 		}
 
 		for (unsigned int i = 0; i < rods.size(); i++) {
 			if (rods[i]->type != Rod::FREE)
 				continue;
-			std::tie(r[0].rods[i].pos, r[0].rods[i].vel) =
-			    rods[i]->initialize();
+			auto state = r[0].rod(i);
+			std::tie(state.pos, state.vel) = rods[i]->initialize();
 		}
 
 		for (unsigned int i = 0; i < conns.size(); i++) {
 			if (conns[i]->type != Connection::FREE)
 				continue;
-			std::tie(r[0].conns[i].pos, r[0].conns[i].vel) =
-			    conns[i]->initialize();
+			auto state = r[0].conn(i);
+			std::tie(state.pos, state.vel) = conns[i]->initialize();
 		}
 
 		for (unsigned int i = 0; i < lines.size(); i++) {
-			std::tie(r[0].lines[i].pos, r[0].lines[i].vel) =
-			    lines[i]->initialize();
+			auto state = r[0].line(i);
+			std::tie(state.pos, state.vel) = lines[i]->initialize();
 		}
 	}
 
+	/** @brief Find the static equilibrium of the free entities
+	 *
+	 * A nested Newton method is applied. For a given position of the free
+	 * connections, rods and bodies, each line is independently equilibrated
+	 * with moordyn::Line::solveStatics(). Then the Newton iterations drive
+	 * the accelerations of the free entities to zero, computing their
+	 * Jacobian with finite differences. The Newton matrix is regularized
+	 * while the steps are rejected by a backtracking line search
+	 *
+	 * The lines are condensed out, so the Jacobian couples every free entity
+	 * with the rest. It is a dense matrix, which takes one evaluation of the
+	 * whole system per degree of freedom, and a O(n^3) factorization. Thus
+	 * the systems with more than 256 free degrees of freedom are not solved,
+	 * and the caller shall fall back to the dynamic relaxation
+	 *
+	 * The equilibrium is written on the current state, with null velocities
+	 * @param tol The tolerance, i.e. the maximum acceptable acceleration of
+	 * the line nodes and the free entities
+	 * @param max_iters The maximum number of Newton iterations
+	 * @return true if the equilibrium has been found, false otherwise
+	 */
+	virtual bool SolveStatics(real tol, unsigned int max_iters)
+	{
+		Next();
+		ResetVelocities();
+
+		// The accelerations of the free entities, where rods and bodies have
+		// 6 components. However, the position of the pinned rods and the
+		// orientation of the zero length ones are not actually free, so they
+		// are left out of the Newton system
+		unsigned int m = 0;
+		std::vector<unsigned int> dofs;
+		auto add_dofs = [&](unsigned int first, unsigned int count) {
+			for (unsigned int j = first; j < first + count; j++)
+				dofs.push_back(m + j);
+		};
+		for (auto obj : conns) {
+			if (obj->type != Connection::FREE)
+				continue;
+			add_dofs(0, 3);
+			m += 3;
+		}
+		for (auto obj : rods) {
+			if (obj->type == Rod::FREE)
+				add_dofs(0, obj->getN() ? 6 : 3);
+			else if ((obj->type == Rod::PINNED) || (obj->type == Rod::CPLDPIN))
+				add_dofs(3, 3);
+			else
+				continue;
+			m += 6;
+		}
+		for (auto obj : bodies) {
+			if (obj->type != Body::FREE)
+				continue;
+			add_dofs(0, 6);
+			m += 6;
+		}
+		const unsigned int n = dofs.size();
+		if (n > 256) {
+			LOGWRN << "The static solver is not meant for " << n
+			       << " degrees of freedom" << endl;
+			return false;
+		}
+
+		// The lines are equilibrated way beyond the tolerance, so the finite
+		// differences are not polluted by their remaining residual
+		const real line_tol = 1.0e-3 * tol;
+		auto solve_line = [this, line_tol, max_iters](unsigned int j) {
+			const unsigned int i = lines_order[j];
+			// Slack lines starting from a straight profile may take a few
+			// hundreds of pseudo-transient iterations to settle down
+			lines[i]->solveStatics(line_tol, 100 * max_iters);
+			auto state = r[0].line(i);
+			for (unsigned int k = 0; k < state.pos.cols(); k++)
+				state.pos.col(k) = lines[i]->getNodePos(k + 1);
+		};
+		// Compute the accelerations of the free entities, returning the
+		// largest one, considering also the line nodes
+		auto residual = [&](vecN& res) -> real {
+			Update(0.0, 0);
+			pool.Run(lines.size(), solve_line);
+			CalcStateDeriv(0);
+			real err = 0.0;
+			for (unsigned int i = 0; i < lines.size(); i++) {
+				const auto acc = rd[0].line(i).acc;
+				if (acc.cols())
+					err = (std::max)(err, acc.colwise().norm().maxCoeff());
+			}
+			unsigned int k = 0;
+			for (unsigned int i = 0; i < conns.size(); i++) {
+				if (conns[i]->type != Connection::FREE)
+					continue;
+				res.segment(k, 3) = rd[0].conn(i).acc;
+				k += 3;
+			}
+			for (unsigned int i = 0; i < rods.size(); i++) {
+				if ((rods[i]->type != Rod::PINNED) &&
+				    (rods[i]->type != Rod::CPLDPIN) &&
+				    (rods[i]->type != Rod::FREE))
+					continue;
+				res.segment(k, 6) = rd[0].rod(i).acc;
+				k += 6;
+			}
+			for (unsigned int i = 0; i < bodies.size(); i++) {
+				if (bodies[i]->type != Body::FREE)
+					continue;
+				res.segment(k, 6) = rd[0].body(i).acc;
+				k += 6;
+			}
+			if (m)
+				err = (std::max)(err, res.template lpNorm<Eigen::Infinity>());
+			return err;
+		};
+		// Displace the free entities. The rods are rotated, so their direction
+		// is kept as an unit vector
+		auto move = [&](const vecN& dx) {
+			unsigned int k = 0;
+			for (unsigned int i = 0; i < conns.size(); i++) {
+				if (conns[i]->type != Connection::FREE)
+					continue;
+				r[0].conn(i).pos += dx.segment(k, 3);
+				k += 3;
+			}
+			for (unsigned int i = 0; i < rods.size(); i++) {
+				if ((rods[i]->type != Rod::PINNED) &&
+				    (rods[i]->type != Rod::CPLDPIN) &&
+				    (rods[i]->type != Rod::FREE))
+					continue;
+				auto pos = r[0].rod(i).pos;
+				pos.head(3) += dx.segment(k, 3);
+				const vec q = pos.tail(3);
+				const vec dq = vec(dx.segment(k + 3, 3)).cross(q);
+				pos.tail(3) = (q + dq).normalized();
+				k += 6;
+			}
+			for (unsigned int i = 0; i < bodies.size(); i++) {
+				if (bodies[i]->type != Body::FREE)
+					continue;
+				r[0].body(i).pos += dx.segment(k, 6);
+				k += 6;
+			}
+		};
+
+		vecN res(m), res_new(m), dx(m), step(n);
+		matN jac(n, n);
+		// The initial state is restored on failure
+		const MoorDynState r_ini = r[0];
+		MoorDynState r0 = r[0];
+		real err;
+		try {
+			err = residual(res);
+			real merit = res(dofs).squaredNorm();
+			// The finite differences step, in meters and radians
+			const real h = 1.0e-4;
+			// The regularization, i.e. the inverse of the squared pseudo time
+			// step, which is letting the solver progress while the Jacobian
+			// is singular, e.g. while the lines are slack
+			real mu = 1.0;
+			bool update_jac = true;
+			for (unsigned int iter = 0; (iter < max_iters) && (err > tol) && n;
+			     iter++) {
+				r0 = r[0];
+				if (update_jac) {
+					for (unsigned int j = 0; j < n; j++) {
+						dx.setZero();
+						dx(dofs[j]) = h;
+						move(dx);
+						residual(res_new);
+						jac.col(j) = (res_new(dofs) - res(dofs)) / h;
+						r[0] = r0;
+					}
+				}
+				step = (mu * matN::Identity(n, n) - jac)
+				           .colPivHouseholderQr()
+				           .solve(res(dofs));
+				dx.setZero();
+				dx(dofs) = step;
+
+				real alpha = 1.0;
+				update_jac = false;
+				while (alpha >= 1.0 / 64.0) {
+					move(alpha * dx);
+					const real err_new = residual(res_new);
+					const real merit_new = res_new(dofs).squaredNorm();
+					if (merit_new < (1.0 - 1.0e-4 * alpha) * merit) {
+						err = err_new;
+						merit = merit_new;
+						res = res_new;
+						update_jac = true;
+						break;
+					}
+					r[0] = r0;
+					alpha *= 0.5;
+				}
+				if (!update_jac) {
+					// Take a more conservative step on the next iteration
+					mu *= 10.0;
+					LOGDBG << "Static solver iteration " << iter
+					       << " rejected" << endl;
+					continue;
+				}
+				mu = (std::max)(0.1 * mu, 1.0e-6);
+				LOGDBG << "Static solver iteration " << iter
+				       << ", residual = " << err << endl;
+			}
+			// The entities may still hold a rejected trial state
+			Update(0.0, 0);
+		} catch (...) {
+			r[0] = r_ini;
+			throw;
+		}
+
+		return err <= tol;
+	}
+
+	/** @brief Relax the system to the static equilibrium with kinetic damping
+	 *
+	 * The system is integrated in time with fictitious lines masses, which
+	 * make the time step the largest stable one for every line. The total
+	 * kinetic energy is tracked, and all the velocities are set to zero each
+	 * time it peaks. The convergence is checked at those peaks, computing
+	 * the accelerations of the system at rest with the actual masses
+	 *
+	 * The equilibrium is written on the current state, with null velocities
+	 * @param dt The time step
+	 * @param tol The tolerance, i.e. the maximum acceptable acceleration of
+	 * the line nodes and the free entities
+	 * @param t_max The maximum simulation time
+	 * @return true if the equilibrium has been found, false otherwise
+	 */
+	virtual bool RelaxKinetic(real dt, real tol, real t_max)
+	{
+		auto set_masses = [this](real dt_c) {
+			for (auto obj : lines)
+				obj->setFictitiousMass(dt_c);
+		};
+		// The largest acceleration of the system at rest
+		auto residual = [&]() -> real {
+			ResetVelocities();
+			set_masses(0.0);
+			Update(0.0, 0);
+			CalcStateDeriv(0);
+			set_masses(dt / stab_factor);
+			return MaxAcceleration(0);
+		};
+
+		Next();
+		real err;
+		const real t0 = this->t;
+		unsigned int n_peaks = 0;
+		try {
+			err = residual();
+			real ke0 = 0.0;
+			while ((err > tol) && (this->t - t0 < t_max)) {
+				Next();
+				real h = dt;
+				Step(h);
+				const real ke = KineticEnergy();
+				if (ke >= ke0) {
+					ke0 = ke;
+					continue;
+				}
+				// The kinetic energy peaked on the previous time step
+				ke0 = 0.0;
+				err = residual();
+				n_peaks++;
+				LOGDBG << "Kinetic damping peak " << n_peaks << " at t = "
+				       << this->t - t0 << " s, residual = " << err << endl;
+			}
+		} catch (...) {
+			set_masses(0.0);
+			throw;
+		}
+		set_masses(0.0);
+		ResetVelocities();
+		Update(0.0, 0);
+
+		LOGMSG << "Kinetic damping stopped after " << this->t - t0 << " s and "
+		       << n_peaks << " kinetic energy peaks, residual = " << err
+		       << endl;
+		return err <= tol;
+	}
+
 	/** @brief Run a time step
 	 *
 	 * This function is the one that must be specialized on each time scheme,
@@ -580,56 +969,12 @@ class TimeSchemeBase : public TimeScheme
 		// number of lines, rods and so on. That information is already
 		// collected from the definition file
 		for (unsigned int substep = 0; substep < NSTATE; substep++) {
-			for (unsigned int i = 0; i < bodies.size(); i++) {
-				subdata = io::IO::Serialize(r[substep].bodies[i].pos);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(r[substep].bodies[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
-			for (unsigned int i = 0; i < rods.size(); i++) {
-				subdata = io::IO::Serialize(r[substep].rods[i].pos);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(r[substep].rods[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
-			for (unsigned int i = 0; i < conns.size(); i++) {
-				subdata = io::IO::Serialize(r[substep].conns[i].pos);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(r[substep].conns[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
-			for (unsigned int i = 0; i < lines.size(); i++) {
-				subdata = io::IO::Serialize(r[substep].lines[i].pos);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(r[substep].lines[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
+			subdata = io::IO::Serialize(r[substep].data);
+			data.insert(data.end(), subdata.begin(), subdata.end());
 		}
 		for (unsigned int substep = 0; substep < NDERIV; substep++) {
-			for (unsigned int i = 0; i < bodies.size(); i++) {
-				subdata = io::IO::Serialize(rd[substep].bodies[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(rd[substep].bodies[i].acc);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
-			for (unsigned int i = 0; i < rods.size(); i++) {
-				subdata = io::IO::Serialize(rd[substep].rods[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(rd[substep].rods[i].acc);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
-			for (unsigned int i = 0; i < conns.size(); i++) {
-				subdata = io::IO::Serialize(rd[substep].conns[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(rd[substep].conns[i].acc);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
-			for (unsigned int i = 0; i < lines.size(); i++) {
-				subdata = io::IO::Serialize(rd[substep].lines[i].vel);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-				subdata = io::IO::Serialize(rd[substep].lines[i].acc);
-				data.insert(data.end(), subdata.begin(), subdata.end());
-			}
+			subdata = io::IO::Serialize(rd[substep].data);
+			data.insert(data.end(), subdata.begin(), subdata.end());
 		}
 
 		return data;
@@ -660,39 +1005,19 @@ class TimeSchemeBase : public TimeScheme
 		// Along the same line, we did not save information about the number of
 		// lines, rods and so on
 		for (unsigned int substep = 0; substep < NSTATE; substep++) {
-			for (unsigned int i = 0; i < bodies.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, r[substep].bodies[i].pos);
-				ptr = io::IO::Deserialize(ptr, r[substep].bodies[i].vel);
-			}
-			for (unsigned int i = 0; i < rods.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, r[substep].rods[i].pos);
-				ptr = io::IO::Deserialize(ptr, r[substep].rods[i].vel);
-			}
-			for (unsigned int i = 0; i < conns.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, r[substep].conns[i].pos);
-				ptr = io::IO::Deserialize(ptr, r[substep].conns[i].vel);
-			}
-			for (unsigned int i = 0; i < lines.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, r[substep].lines[i].pos);
-				ptr = io::IO::Deserialize(ptr, r[substep].lines[i].vel);
+			const auto n = r[substep].data.size();
+			ptr = io::IO::Deserialize(ptr, r[substep].data);
+			if (r[substep].data.size() != n) {
+				LOGERR << "The saved state does not match the system" << endl;
+				throw moordyn::invalid_value_error("Invalid state size");
 			}
 		}
 		for (unsigned int substep = 0; substep < NDERIV; substep++) {
-			for (unsigned int i = 0; i < bodies.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, rd[substep].bodies[i].vel);
-				ptr = io::IO::Deserialize(ptr, rd[substep].bodies[i].acc);
-			}
-			for (unsigned int i = 0; i < rods.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, rd[substep].rods[i].vel);
-				ptr = io::IO::Deserialize(ptr, rd[substep].rods[i].acc);
-			}
-			for (unsigned int i = 0; i < conns.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, rd[substep].conns[i].vel);
-				ptr = io::IO::Deserialize(ptr, rd[substep].conns[i].acc);
-			}
-			for (unsigned int i = 0; i < lines.size(); i++) {
-				ptr = io::IO::Deserialize(ptr, rd[substep].lines[i].vel);
-				ptr = io::IO::Deserialize(ptr, rd[substep].lines[i].acc);
+			const auto n = rd[substep].data.size();
+			ptr = io::IO::Deserialize(ptr, rd[substep].data);
+			if (rd[substep].data.size() != n) {
+				LOGERR << "The saved state does not match the system" << endl;
+				throw moordyn::invalid_value_error("Invalid state size");
 			}
 		}
 
@@ -719,6 +1044,7 @@ class TimeSchemeBase : public TimeScheme
 	void Update(real t_local, unsigned int substep = 0)
 	{
 		ground->updateFairlead(this->t);
+		UpdateWaves();
 
 		t_local += this->t_local;
 		for (auto obj : bodies) {
@@ -747,26 +1073,24 @@ class TimeSchemeBase : public TimeScheme
 			// (U_1 and U_2)
 			const real dt = this->t - t_w;
 			const unsigned int n = u_w.size();
-			std::vector<vec> u_extrap;
-			u_extrap.reserve(n);
+			// NOTE: The memory is just allocated the first time
+			u_extrap.resize(n);
 			for (unsigned int i = 0; i < n; i++)
-				u_extrap.push_back(u_w[i] + ud_w[i] * dt);
+				u_extrap[i] = u_w[i] + ud_w[i] * dt;
 
 			// distribute to the appropriate objects
 			unsigned int i = 0;
 			for (auto line : lines) {
-				const unsigned int n_line = line->getN() + 1;
-				line->setNodeWaveKin(vector_slice(u_extrap, i, n_line),
-				                     vector_slice(ud_w, i, n_line));
-				i += n_line;
+				line->setNodeWaveKin(u_extrap, ud_w, i);
+				i += line->getN() + 1;
 			}
 		}
 
 		for (unsigned int i = 0; i < bodies.size(); i++) {
 			if (bodies[i]->type != Body::FREE)
 				continue;
-			bodies[i]->setState(r[substep].bodies[i].pos,
-			                    r[substep].bodies[i].vel);
+			const auto state = r[substep].body(i);
+			bodies[i]->setState(state.pos, state.vel);
 		}
 
 		for (unsigned int i = 0; i < rods.size(); i++) {
@@ -774,71 +1098,193 @@ class TimeSchemeBase : public TimeScheme
 			    (rods[i]->type != Rod::CPLDPIN) && (rods[i]->type != Rod::FREE))
 				continue;
 			rods[i]->setTime(this->t);
-			rods[i]->setState(r[substep].rods[i].pos, r[substep].rods[i].vel);
+			const auto state = r[substep].rod(i);
+			rods[i]->setState(state.pos, state.vel);
 		}
 
 		for (unsigned int i = 0; i < conns.size(); i++) {
 			if (conns[i]->type != Connection::FREE)
 				continue;
-			conns[i]->setState(r[substep].conns[i].pos,
-			                   r[substep].conns[i].vel);
+			const auto state = r[substep].conn(i);
+			conns[i]->setState(state.pos, state.vel);
 		}
 
-		for (unsigned int i = 0; i < lines.size(); i++) {
+		auto set_line = [this, substep](unsigned int j) {
+			const unsigned int i = lines_order[j];
 			lines[i]->setTime(this->t);
-			lines[i]->setState(r[substep].lines[i].pos,
-			                   r[substep].lines[i].vel);
-		}
+			const auto state = r[substep].line(i);
+			lines[i]->setState(state.pos, state.vel);
+		};
+		pool.Run(lines.size(), set_line);
 	}
 
-	/** @brief Compute the time derivatives and store them
-	 * @param substep The index within moordyn::TimeSchemeBase::rd where the
-	 * info will be saved
+	/** @brief Set all the velocities on the first state to zero
 	 */
-	void CalcStateDeriv(unsigned int substep = 0)
+	void ResetVelocities()
 	{
+		for (unsigned int i = 0; i < lines.size(); i++)
+			r[0].line(i).vel.setZero();
+		for (unsigned int i = 0; i < conns.size(); i++)
+			r[0].conn(i).vel.setZero();
+		for (unsigned int i = 0; i < rods.size(); i++)
+			r[0].rod(i).vel.setZero();
+		for (unsigned int i = 0; i < bodies.size(); i++)
+			r[0].body(i).vel.setZero();
+	}
+
+	/** @brief Compute the kinetic energy of the first state
+	 *
+	 * The mass matrices computed on the last call to CalcStateDeriv() are
+	 * considered
+	 * @return The kinetic energy of the line nodes and the free entities
+	 */
+	real KineticEnergy()
+	{
+		real ke = 0.0;
 		for (unsigned int i = 0; i < lines.size(); i++) {
-			std::tie(rd[substep].lines[i].vel, rd[substep].lines[i].acc) =
-			    lines[i]->getStateDeriv();
+			const auto vel = r[0].line(i).vel;
+			for (unsigned int k = 0; k < vel.cols(); k++) {
+				const vec v = vel.col(k);
+				ke += v.dot(lines[i]->getNodeMass(k + 1) * v);
+			}
 		}
-
 		for (unsigned int i = 0; i < conns.size(); i++) {
 			if (conns[i]->type != Connection::FREE)
 				continue;
-			std::tie(rd[substep].conns[i].vel, rd[substep].conns[i].acc) =
-			    conns[i]->getStateDeriv();
+			mat M;
+			conns[i]->getM(M);
+			const vec v = r[0].conn(i).vel;
+			ke += v.dot(M * v);
 		}
-
 		for (unsigned int i = 0; i < rods.size(); i++) {
 			if ((rods[i]->type != Rod::PINNED) &&
 			    (rods[i]->type != Rod::CPLDPIN) && (rods[i]->type != Rod::FREE))
 				continue;
-			std::tie(rd[substep].rods[i].vel, rd[substep].rods[i].acc) =
-			    rods[i]->getStateDeriv();
+			const vec6 v = r[0].rod(i).vel;
+			ke += v.dot(rods[i]->getM() * v);
 		}
-
 		for (unsigned int i = 0; i < bodies.size(); i++) {
 			if (bodies[i]->type != Body::FREE)
 				continue;
-			std::tie(rd[substep].bodies[i].vel, rd[substep].bodies[i].acc) =
-			    bodies[i]->getStateDeriv();
+			const vec6 v = r[0].body(i).vel;
+			ke += v.dot(bodies[i]->getM() * v);
 		}
+		return 0.5 * ke;
+	}
 
-		for (auto obj : conns) {
-			if (obj->type != Connection::COUPLED)
+	/** @brief Get the largest acceleration of the line nodes and the free
+	 * entities
+	 * @param substep The index within moordyn::TimeSchemeBase::rd where the
+	 * derivatives are stored
+	 * @return The largest acceleration
+	 */
+	real MaxAcceleration(unsigned int substep = 0)
+	{
+		real acc = 0.0;
+		for (unsigned int i = 0; i < lines.size(); i++) {
+			const auto a = rd[substep].line(i).acc;
+			if (a.cols())
+				acc = (std::max)(acc, a.colwise().norm().maxCoeff());
+		}
+		for (unsigned int i = 0; i < conns.size(); i++) {
+			if (conns[i]->type != Connection::FREE)
 				continue;
-			obj->doRHS();
+			const auto a = rd[substep].conn(i).acc;
+			acc = (std::max)(acc, a.template lpNorm<Eigen::Infinity>());
 		}
-		for (auto obj : rods) {
-			if ((obj->type != Rod::COUPLED) && (obj->type != Rod::CPLDPIN))
+		for (unsigned int i = 0; i < rods.size(); i++) {
+			if ((rods[i]->type != Rod::PINNED) &&
+			    (rods[i]->type != Rod::CPLDPIN) && (rods[i]->type != Rod::FREE))
 				continue;
-			obj->doRHS();
+			const auto a = rd[substep].rod(i).acc;
+			acc = (std::max)(acc, a.template lpNorm<Eigen::Infinity>());
 		}
-		for (auto obj : bodies) {
-			if (obj->type != Body::COUPLED)
+		for (unsigned int i = 0; i < bodies.size(); i++) {
+			if (bodies[i]->type != Body::FREE)
 				continue;
-			obj->doRHS();
+			const auto a = rd[substep].body(i).acc;
+			acc = (std::max)(acc, a.template lpNorm<Eigen::Infinity>());
 		}
+		return acc;
+	}
+
+	/** @brief Compute the time derivatives and store them
+	 * @param substep The index within moordyn::TimeSchemeBase::rd where the
+	 * info will be saved
+	 */
+	void CalcStateDeriv(unsigned int substep = 0)
+	{
+		// The connections, rods and bodies forces and masses are computed
+		// just once, no matter how many other objects depend on them
+		for (auto obj : conns)
+			obj->beginRHS();
+		for (auto obj : rods)
+			obj->beginRHS();
+		for (auto obj : bodies)
+			obj->beginRHS();
+		auto end_rhs = [this]() {
+			for (auto obj : conns)
+				obj->endRHS();
+			for (auto obj : rods)
+				obj->endRHS();
+			for (auto obj : bodies)
+				obj->endRHS();
+		};
+		n_derivs++;
+
+		try {
+			// The lines only depend on their own state, and on the ends
+			// already set on Update(), so they can be evaluated in parallel
+			auto line_deriv = [this, substep](unsigned int j) {
+				const unsigned int i = lines_order[j];
+				auto drdt = rd[substep].line(i);
+				lines[i]->getStateDeriv(drdt);
+			};
+			pool.Run(lines.size(), line_deriv);
+
+			for (unsigned int i = 0; i < conns.size(); i++) {
+				if (conns[i]->type != Connection::FREE)
+					continue;
+				auto drdt = rd[substep].conn(i);
+				conns[i]->getStateDeriv(drdt);
+			}
+
+			for (unsigned int i = 0; i < rods.size(); i++) {
+				if ((rods[i]->type != Rod::PINNED) &&
+				    (rods[i]->type != Rod::CPLDPIN) &&
+				    (rods[i]->type != Rod::FREE))
+					continue;
+				auto drdt = rd[substep].rod(i);
+				rods[i]->getStateDeriv(drdt);
+			}
+
+			for (unsigned int i = 0; i < bodies.size(); i++) {
+				if (bodies[i]->type != Body::FREE)
+					continue;
+				auto drdt = rd[substep].body(i);
+				bodies[i]->getStateDeriv(drdt);
+			}
+
+			for (auto obj : conns) {
+				if (obj->type != Connection::COUPLED)
+					continue;
+				obj->doRHS();
+			}
+			for (auto obj : rods) {
+				if ((obj->type != Rod::COUPLED) && (obj->type != Rod::CPLDPIN))
+					continue;
+				obj->doRHS();
+			}
+			for (auto obj : bodies) {
+				if (obj->type != Body::COUPLED)
+					continue;
+				obj->doRHS();
+			}
+		} catch (...) {
+			end_rhs();
+			throw;
+		}
+		end_rhs();
 
 		// call ground body to update all the fixed things
 		ground->setDependentStates(); // NOTE: (not likely needed)
@@ -849,6 +1295,10 @@ class TimeSchemeBase : public TimeScheme
 
 	/// The list of state derivatives
 	std::array<DMoorDynStateDt, NDERIV> rd;
+
+  private:
+	/// The extrapolated external wave velocities, see Update()
+	std::vector<vec> u_extrap;
 };
 
 /** @class EulerScheme Time.hpp
@@ -1064,9 +1514,349 @@ class ImplicitEulerScheme : public TimeSchemeBase<2, 1>
 	real _dt_factor;
 };
 
+/** @class RK45Scheme Time.hpp
+ * @brief Adaptive 5th order Dormand-Prince Runge-Kutta time scheme
+ *
+ * Along with the 5th order solution, an embedded 4th order one is computed,
+ * so the local error can be estimated. The time step is then adapted to keep
+ * such error below the tolerances, rejecting and repeating the steps which
+ * exceed them.
+ *
+ * The time step passed to RK45Scheme::Step() is the maximum allowed one. The
+ * time actually integrated is returned in the same variable, so the caller
+ * shall keep stepping until the target time is reached
+ */
+class RK45Scheme : public TimeSchemeBase<3, 7>
+{
+  public:
+	/** @brief Costructor
+	 * @param log Logging handler
+	 */
+	RK45Scheme(moordyn::Log* log);
+
+	/// @brief Destructor
+	~RK45Scheme();
+
+	/** @brief Run a time step
+	 *
+	 * This function is the one that must be specialized on each time scheme
+	 * @param dt Maximum time step. On return, the time step actually taken
+	 */
+	virtual void Step(real& dt);
+
+	/** @brief Set the error tolerances
+	 *
+	 * The step is accepted if the root mean square of the local errors,
+	 * scaled by \f$atol + rtol \vert y \vert\f$, is not bigger than 1
+	 * @param atol Absolute tolerance
+	 * @param rtol Relative tolerance
+	 * @throw moordyn::invalid_value_error If any tolerance is not positive
+	 */
+	void SetTolerances(real atol, real rtol);
+
+	/** @brief Get the absolute tolerance
+	 * @return The absolute tolerance
+	 */
+	inline real GetAbsTolerance() const { return _atol; }
+
+	/** @brief Get the relative tolerance
+	 * @return The relative tolerance
+	 */
+	inline real GetRelTolerance() const { return _rtol; }
+
+	/** @brief Set the minimum time step
+	 *
+	 * If the tolerances cannot be met with this time step, the step is
+	 * accepted anyway, and a warning is reported
+	 * @param dt The minimum time step
+	 * @throw moordyn::invalid_value_error If @p dt is negative
+	 */
+	void SetMinTimeStep(real dt);
+
+	/** @brief Get the number of accepted time steps
+	 * @return The number of accepted time steps
+	 */
+	inline unsigned long GetAcceptedSteps() const { return n_accepted; }
+
+	/** @brief Get the number of rejected time steps
+	 * @return The number of rejected time steps
+	 */
+	inline unsigned long GetRejectedSteps() const { return n_rejected; }
+
+	/** @brief Produce the packed data to be saved
+	 *
+	 * The produced data can be used afterwards to restore the saved information
+	 * afterwards calling Deserialize(void).
+	 * @return The packed data
+	 */
+	virtual std::vector<uint64_t> Serialize(void)
+	{
+		std::vector<uint64_t> data = TimeSchemeBase::Serialize();
+		// We append the time step to be tried next
+		data.push_back(io::IO::Serialize(dt_next));
+
+		return data;
+	}
+
+	/** @brief Unpack the data to restore the Serialized information
+	 *
+	 * This is the function that each inherited class must implement, and should
+	 * be the inverse of Serialize(void)
+	 * @param data The packed data
+	 * @return A pointer to the end of the file, for debugging purposes
+	 */
+	virtual uint64_t* Deserialize(const uint64_t* data)
+	{
+		uint64_t* ptr = TimeSchemeBase::Deserialize(data);
+		ptr = io::IO::Deserialize(ptr, dt_next);
+		fsal = false;
+
+		return ptr;
+	}
+
+  private:
+	/// Absolute tolerance
+	real _atol;
+	/// Relative tolerance
+	real _rtol;
+	/// Minimum time step
+	real _dt_min;
+	/// The time step to try next, 0 if it is not known yet
+	real dt_next;
+	/// Whether the last derivative is valid as the first one of the next step
+	bool fsal;
+	/// Number of accepted steps
+	unsigned long n_accepted;
+	/// Number of rejected steps
+	unsigned long n_rejected;
+	/// Smallest accepted time step
+	real dt_min_used;
+	/// Largest accepted time step
+	real dt_max_used;
+
+	/** @brief Estimate the local error
+	 *
+	 * The 5th order solution shall be already stored in r[2]. r[1] is
+	 * overwritten with the local error
+	 * @param dt The time step
+	 * @return The scaled root mean square error
+	 */
+	real Error(real dt);
+};
+
+/** @class MultiRateScheme Time.hpp
+ * @brief Multi-rate 2nd order time scheme, subcycling the lines
+ *
+ * The connections, rods and bodies are integrated with a Heun scheme, using
+ * the outer time step. Meanwhile, each line is integrated on its own with a
+ * 2nd order Runge-Kutta scheme, subdividing the outer time step in as many
+ * substeps as required to respect its own stability limit, which is
+ * estimated from its critical time step (see
+ * moordyn::Line::getCriticalTimeStep()).
+ *
+ * Along the substeps, the line end points kinematics are linearly
+ * interpolated between the ones at the beginning of the outer time step and
+ * the ones predicted at its end, with a 2nd order Taylor expansion. The
+ * waves kinematics are instead evaluated at the substeps times. Thus the
+ * time step shall be chosen to resolve the connections, rods and bodies
+ * dynamics, while the stiff lines are taken care of by the scheme itself
+ */
+class MultiRateScheme : public TimeSchemeBase<3, 2>
+{
+  public:
+	/** @brief Costructor
+	 * @param log Logging handler
+	 * @param cfl The fraction of the critical time step taken as the lines
+	 * time step
+	 */
+	MultiRateScheme(moordyn::Log* log, real cfl = 0.5);
+
+	/// @brief Destructor
+	~MultiRateScheme() {}
+
+	/** @brief Run a time step
+	 *
+	 * This function is the one that must be specialized on each time scheme
+	 * @param dt Time step
+	 */
+	virtual void Step(real& dt);
+
+	/** @brief Get the number of substeps taken by a line on the last step
+	 * @param i The line index
+	 * @return The number of substeps, 0 if no step has been taken yet
+	 */
+	inline unsigned int GetSubsteps(unsigned int i) const
+	{
+		return (i < substeps.size()) ? substeps[i] : 0;
+	}
+
+	/** @brief Estimate the largest stable time step for a line
+	 *
+	 * The lines are subcycled, so the estimation does not apply to them. The
+	 * outer time step is then limited by the rest of entities, see
+	 * moordyn::TimeScheme::GetStableTimeStep(const Rod*)
+	 * @return Infinity
+	 */
+	virtual real GetStableTimeStep(const Line*) const
+	{
+		LOGDBG << "The lines are subcycled by the " << name << " scheme, "
+		       << "so they are not limiting the time step" << endl;
+		return std::numeric_limits<real>::infinity();
+	}
+
+	using TimeScheme::GetStableTimeStep;
+
+  protected:
+	/// The fraction of the critical time step used as the lines time step
+	real _cfl;
+	/// The end points position and velocity of each line at the beginning
+	/// of the time step, sorted as A position, A velocity, B position and
+	/// B velocity
+	std::vector<std::array<vec, 4>> ends0;
+	/// The end points position and velocity of each line at the end of the
+	/// time step
+	std::vector<std::array<vec, 4>> ends1;
+
+	/** @brief Get the largest time step a line can stably take
+	 * @param i The line index
+	 * @return The line time step
+	 */
+	virtual real LineTimeStep(unsigned int i) const
+	{
+		return _cfl * lines[i]->getCriticalTimeStep();
+	}
+
+	/** @brief Integrate a line along a substep
+	 *
+	 * The line state at the beginning of the substep is stored in r[1], where
+	 * the new state shall be written. The line is already set on such state
+	 * and time, so the waves are evaluated at the beginning of the substep,
+	 * and its derivative is already computed in rd[0]. The rest of
+	 * moordyn::TimeSchemeBase::r and moordyn::TimeSchemeBase::rd line chunks
+	 * can be used as scratch space
+	 * @param i The line index
+	 * @param s The time elapsed since the beginning of the outer time step
+	 * @param h The substep
+	 * @param dt The outer time step
+	 */
+	virtual void LineSubstep(unsigned int i, real s, real h, real dt);
+
+	/** @brief Set a line at an intermediate time of the outer time step
+	 * @param i The line index
+	 * @param s The time elapsed since the beginning of the outer time step
+	 * @param dt The outer time step
+	 * @param state The line state
+	 */
+	void SetLine(unsigned int i, real s, real dt, const LineState& state);
+
+  private:
+	/// The number of substeps of each line
+	std::vector<unsigned int> substeps;
+
+	/** @brief Store the lines end points kinematics
+	 * @param ends Where the kinematics shall be stored
+	 */
+	void StoreEnds(std::vector<std::array<vec, 4>>& ends);
+
+	/** @brief Integrate a line along the outer time step
+	 *
+	 * The initial state is taken from r[0], and the final one is stored in
+	 * r[1]. The derivative at the beginning of the time step shall be already
+	 * computed in rd[0]
+	 * @param i The line index
+	 * @param dt The outer time step
+	 */
+	void Subcycle(unsigned int i, real dt);
+};
+
+/** @class IMEXScheme Time.hpp
+ * @brief Implicit-explicit 2nd order time scheme
+ *
+ * The lines axial stiffness is usually what limits the time step, rather
+ * than the dynamics of interest. This scheme treats the segments tension and
+ * internal damping implicitly, while the rest of forces, like the drag, the
+ * waves or the seabed contact, are kept explicit.
+ *
+ * On each line, the axial forces are linearized around the state at the
+ * beginning of the step, and the motion is integrated with the average
+ * acceleration Newmark method, which is unconditionally stable and 2nd order
+ * accurate. The resulting problem is block tridiagonal, so it is solved in
+ * O(N) operations. The rest of entities are integrated as in
+ * moordyn::MultiRateScheme, and the lines are still subcycled if bending or
+ * seabed contact require it
+ */
+class IMEXScheme : public MultiRateScheme
+{
+  public:
+	/** @brief Costructor
+	 * @param log Logging handler
+	 * @param cfl The fraction of the explicit critical time step taken as
+	 * the lines time step
+	 */
+	IMEXScheme(moordyn::Log* log, real cfl = 0.5);
+
+	/// @brief Destructor
+	~IMEXScheme() {}
+
+	/** @brief Run a time step
+	 *
+	 * This function is the one that must be specialized on each time scheme
+	 * @param dt Time step
+	 */
+	virtual void Step(real& dt);
+
+  protected:
+	/** @brief Get the largest time step a line can stably take
+	 *
+	 * The axial stiffness is not limiting the time step
+	 * @param i The line index
+	 * @return The line time step
+	 */
+	virtual real LineTimeStep(unsigned int i) const
+	{
+		return _cfl * lines[i]->getCriticalTimeStep(false);
+	}
+
+	/** @brief Integrate a line along a substep
+	 *
+	 * The derivative at the beginning of the substep, with the waves at that
+	 * time, is already computed by
+	 * moordyn::MultiRateScheme::Subcycle(). Thus, the time elapsed since the
+	 * beginning of the outer time step is not required
+	 * @param i The line index
+	 * @param h The substep
+	 * @param dt The outer time step
+	 */
+	virtual void LineSubstep(unsigned int i, real, real h, real dt);
+
+  private:
+	/** @brief Work arrays of each line
+	 */
+	typedef struct _LineWork
+	{
+		/// The segments stiffness matrices
+		std::vector<mat> K;
+		/// The segments damping matrices
+		std::vector<mat> C;
+		/// The system diagonal blocks
+		std::vector<mat> D;
+		/// The system upper diagonal blocks
+		std::vector<mat> U;
+		/// The nodes displacement predicted with the current acceleration
+		vec3N u;
+		/// The nodes velocity change predicted with the current acceleration
+		vec3N w;
+		/// The right hand side, and the acceleration change afterwards
+		vec3N b;
+	} LineWork;
+
+	/// The work arrays
+	std::vector<LineWork> work;
+};
+
 /** @brief Create a time scheme
  * @param name The time scheme name, one of the following:
- * "Euler", "Heun", "RK2", "RK4", "AB3", "AB4"
+ * "Euler", "Heun", "RK2", "RK4", "AB3", "AB4", "RK45", "MultiRate", "IMEX"
  * @param log The log handler
  * @return The time scheme
  * @throw moordyn::invalid_value_error If there is not a time scheme named after
@@ -30,13 +30,34 @@
 
 #include "Waves.hpp"
 #include "Waves.h"
+#include "ThreadPool.hpp"
 #include "kiss_fftr.h"
+#include <chrono>
+#include <numeric>
+#include <iomanip>
+#include <new>
+#include <time.h>
+
+#ifdef WIN32
+#include <process.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #if defined WIN32 && defined max
 // We must avoid max messes up with std::numeric_limits<>::max()
 #undef max
 #endif
 
+#ifndef MOORDYN_MAJOR_VERSION
+#define MOORDYN_MAJOR_VERSION 0
+#endif
+#ifndef MOORDYN_MINOR_VERSION
+#define MOORDYN_MINOR_VERSION 0
+#endif
+
 using namespace std;
 
 namespace moordyn {
@@ -76,21 +97,160 @@ gridAxisCoords(Waves::coordtypes coordtype, vector<string>& entries)
 	return coordarray;
 }
 
+/** @brief CPU time consumed by the calling thread
+ * @return The time in seconds. If the platform has not per-thread CPU clocks,
+ * the wall clock time is returned instead
+ */
+real
+threadTime()
+{
+#ifdef CLOCK_THREAD_CPUTIME_ID
+	struct timespec ts;
+	if (!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+		return ts.tv_sec + 1.e-9 * ts.tv_nsec;
+#endif
+	const auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration<real>(now).count();
+}
+
+/// Version of the waves grid cache files layout
+#define WAVES_CACHE_VERSION 2
+/// Alignment of the waves grid data on the cache files
+#define WAVES_CACHE_ALIGN 64
+
+/** @brief Header of the waves grid cache files
+ *
+ * The header is followed by the grid coordinates, and then by the
+ * kinematics storage, aligned to WAVES_CACHE_ALIGN bytes. Everything is
+ * written with the native layout, so the files are not portable
+ */
+typedef struct
+{
+	/// "MDWAVES"
+	char magic[8];
+	/// WAVES_CACHE_VERSION
+	uint32_t version;
+	/// 0x01020304, to detect files from machines with other endianness
+	uint32_t endianness;
+	/// Hash of the inputs, see moordyn::Waves::cacheKey()
+	uint64_t key;
+	/// Size of the floating point numbers, see moordyn::real
+	uint32_t real_size;
+	/// Storage precision, see moordyn::waves_precision
+	uint32_t prec;
+	/// Number of grid points along each direction and time steps
+	uint32_t nx, ny, nz, nt;
+	/// Time step of the grid
+	real dtWave;
+	/// Grid spacing along each direction, 0 if it is not equispaced
+	real dpx, dpy, dpz;
+	/// Offset of the kinematics storage, in bytes
+	uint64_t offset;
+	/// Size of the kinematics storage, in bytes
+	uint64_t bytes;
+} waves_cache_header;
+
+/** @brief 64-bit FNV-1a hash
+ * @param data The data to hash
+ * @param n The number of bytes
+ * @param h The hash of the former data, if any
+ * @return The hash
+ */
+uint64_t
+fnv1a(const void* data, size_t n, uint64_t h = 14695981039346656037ULL)
+{
+	const uint8_t* d = (const uint8_t*)data;
+	for (size_t i = 0; i < n; i++) {
+		h ^= d[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+/** @brief Map a whole file in memory, read-only and shared
+ * @param filepath The file path
+ * @param size The file size
+ * @return The mapped memory, NULL if the file cannot be mapped
+ */
+void*
+mapFile(const std::string& filepath, size_t& size)
+{
+#ifdef WIN32
+	HANDLE f = CreateFileA(filepath.c_str(),
+	                       GENERIC_READ,
+	                       FILE_SHARE_READ,
+	                       NULL,
+	                       OPEN_EXISTING,
+	                       FILE_ATTRIBUTE_NORMAL,
+	                       NULL);
+	if (f == INVALID_HANDLE_VALUE)
+		return NULL;
+	LARGE_INTEGER fsize;
+	if (!GetFileSizeEx(f, &fsize) || !fsize.QuadPart) {
+		CloseHandle(f);
+		return NULL;
+	}
+	HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(f);
+	if (!m)
+		return NULL;
+	// The view keeps the mapping alive
+	void* addr = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(m);
+	size = fsize.QuadPart;
+	return addr;
+#else
+	const int fd = open(filepath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	struct stat st;
+	if (fstat(fd, &st) || !st.st_size) {
+		close(fd);
+		return NULL;
+	}
+	void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (addr == MAP_FAILED)
+		return NULL;
+	size = st.st_size;
+	return addr;
+#endif
+}
+
+/** @brief Unmap a file mapped with mapFile()
+ * @param addr The mapped memory
+ * @param size The file size
+ */
+void
+unmapFile(void* addr, size_t size)
+{
+#ifdef WIN32
+	UnmapViewOfFile(addr);
+#else
+	munmap(addr, size);
+#endif
+}
+
 /** @brief Carry out the inverse Fourier transform
  * @param cfg KISS FFT instance
  * @param nFFT Numer of fourier components
  * @param cx_w_in KISS FFT frequency-domain data
  * @param cx_t_out KISS FFT time-domain output
+ * @param cx_tmp KISS FFT scratch buffer, with nFFT / 2 components
  * @param inputs Input FFT values
  * @param outputs Output time-domain values
+ * @param stride Distance between consecutive time-domain values in
+ * \p outputs
  */
 void
 doIFFT(kiss_fftr_cfg cfg,
        unsigned int nFFT,
        kiss_fft_cpx* cx_w_in,
        kiss_fft_scalar* cx_t_out,
+       kiss_fft_cpx* cx_tmp,
        const moordyn::complex* inputs,
-       std::vector<real>& outputs)
+       real* outputs,
+       unsigned int stride)
 {
 	unsigned int nw = nFFT / 2 + 1;
 
@@ -101,12 +261,12 @@ doIFFT(kiss_fftr_cfg cfg,
 		cx_w_in[i].i = std::imag(inputs[i]);
 	}
 
-	kiss_fftri(cfg, cx_w_in, cx_t_out);
+	kiss_fftri_buf(cfg, cx_w_in, cx_t_out, cx_tmp);
 
 	// copy out the IFFT data to the time series
 	for (unsigned int i = 0; i < nFFT; i++) {
 		// NOTE: is dividing by nFFT correct? (prevously was nw)
-		outputs[i] = cx_t_out[i] / (real)nFFT;
+		outputs[i * stride] = cx_t_out[i] / (real)nFFT;
 	}
 
 	return;
@@ -114,16 +274,37 @@ doIFFT(kiss_fftr_cfg cfg,
 
 Waves::Waves(moordyn::Log* log)
   : LogUser(log)
+  , kin(NULL, KIN_NFIELDS, 0)
+  , kin_prec(WAVES_PREC_REAL)
+  , kin_f(NULL, KIN_NFIELDS, 0)
+  , kin_q(NULL, KIN_NFIELDS, 0)
+  , kin_scale(NULL, KIN_NFIELDS, 0)
+  , kin_map(NULL)
+  , kin_map_size(0)
+  , grid_fit(false)
+  , wave_t(0.0)
+  , stream(false)
+  , stream_hop(0)
+  , stream_last(0)
+  , stream_first(0)
   , _t_integrator(NULL)
 {
 }
 
 // function to clear any remaining data allocations in Waves
-Waves::~Waves() {}
+Waves::~Waves()
+{
+	releaseKin();
+}
 
 void
 Waves::makeGrid(const char* filepath)
 {
+	if (grid_fit) {
+		allocateKinematicsArrays();
+		return;
+	}
+
 	LOGMSG << "Reading waves coordinates grid from '" << filepath << "'..."
 	       << endl;
 
@@ -154,6 +335,9 @@ Waves::makeGrid(const char* filepath)
 	entries = moordyn::str::split(lines[4]);
 	px = gridAxisCoords(coordtype, entries);
 	nx = px.size();
+	dpx = 0.0;
+	if ((coordtype == GRID_LATTICE) && (nx > 1))
+		dpx = (px.back() - px.front()) / (nx - 1);
 	if (!nx) {
 		LOGERR << "Invalid entry for the grid x values in file '" << filepath
 		       << "'" << endl;
@@ -165,6 +349,9 @@ Waves::makeGrid(const char* filepath)
 	entries = moordyn::str::split(lines[6]);
 	py = gridAxisCoords(coordtype, entries);
 	ny = py.size();
+	dpy = 0.0;
+	if ((coordtype == GRID_LATTICE) && (ny > 1))
+		dpy = (py.back() - py.front()) / (ny - 1);
 	if (!ny) {
 		LOGERR << "Invalid entry for the grid y values in file '" << filepath
 		       << "'" << endl;
@@ -176,6 +363,9 @@ Waves::makeGrid(const char* filepath)
 	entries = moordyn::str::split(lines[8]);
 	pz = gridAxisCoords(coordtype, entries);
 	nz = pz.size();
+	dpz = 0.0;
+	if ((coordtype == GRID_LATTICE) && (nz > 1))
+		dpz = (pz.back() - pz.front()) / (nz - 1);
 	if (!nz) {
 		LOGERR << "Invalid entry for the grid z values in file '" << filepath
 		       << "'" << endl;
@@ -194,6 +384,70 @@ Waves::makeGrid(const char* filepath)
 	}
 }
 
+void
+Waves::fitGrid(const EnvCond* env)
+{
+	// Bounding box of the nodes
+	vec rmin = vec::Constant(std::numeric_limits<real>::max());
+	vec rmax = vec::Constant(std::numeric_limits<real>::lowest());
+	auto fit = [&](const vec& r) {
+		rmin = rmin.cwiseMin(r);
+		rmax = rmax.cwiseMax(r);
+	};
+	for (auto obj : _t_integrator->GetLines())
+		for (unsigned int i = 0; i <= obj->getN(); i++)
+			fit(obj->getNodePos(i));
+	for (auto obj : _t_integrator->GetRods())
+		for (unsigned int i = 0; i <= obj->getN(); i++)
+			fit(obj->getNodePos(i));
+	for (auto obj : _t_integrator->GetBodies())
+		fit(obj->getPosition());
+	if ((rmin.array() > rmax.array()).any()) {
+		LOGERR << "There are no nodes to fit the waves grid to" << endl;
+		throw moordyn::invalid_value_error("No nodes");
+	}
+	const real margin = std::max(env->WaveGridMargin, 0.0);
+	rmin.array() -= margin;
+	rmax.array() += margin;
+
+	// Equispaced horizontal lattice
+	const real dx = env->WaveGridDx > 0.0 ? env->WaveGridDx : 5.0;
+	auto lattice = [dx](real a, real b, std::vector<real>& p, real& dp) {
+		const unsigned int n = std::max(2, (int)ceil((b - a) / dx) + 1);
+		dp = (b - a) / (n - 1);
+		p.resize(n);
+		for (unsigned int i = 0; i < n; i++)
+			p[i] = a + i * dp;
+		return n;
+	};
+	nx = lattice(rmin[0], rmax[0], px, dpx);
+	ny = lattice(rmin[1], rmax[1], py, dpy);
+
+	// The waves kinematics decay with the depth, so the depths are
+	// quadratically stretched from the free surface downwards. There is no
+	// wave stretching, so the grid stops at the mean free surface
+	nz = env->WaveGridNz;
+	if (nz < 2) {
+		LOGWRN << "At least 2 depths are required on the fitted waves grid"
+		       << endl;
+		nz = 2;
+	}
+	const real zmin = std::min(std::max(rmin[2], -env->WtrDpth), real(0.0));
+	pz.resize(nz);
+	for (unsigned int i = 0; i < nz; i++) {
+		const real s = 1.0 - (real)i / (nz - 1);
+		pz[i] = zmin * s * s;
+	}
+	pz.back() = 0.0; // Instead of -0.0
+	dpz = 0.0;
+
+	LOGMSG << "Waves grid fitted to the mooring: x = [" << px.front() << ", "
+	       << px.back() << "] m (" << nx << " points), y = [" << py.front()
+	       << ", " << py.back() << "] m (" << ny << " points), z = ["
+	       << pz.front() << ", " << pz.back() << "] m (" << nz << " points)"
+	       << endl;
+}
+
 void
 Waves::allocateKinematicsArrays()
 {
@@ -206,16 +460,282 @@ Waves::allocateKinematicsArrays()
 		throw moordyn::invalid_value_error("Uninitialized values");
 	}
 
-	zeta = init3DArray(nx, ny, nt);
-	PDyn = init4DArray(nx, ny, nz, nt);
-	ux = init4DArray(nx, ny, nz, nt);
-	uy = init4DArray(nx, ny, nz, nt);
-	uz = init4DArray(nx, ny, nz, nt);
-	ax = init4DArray(nx, ny, nz, nt);
-	ay = init4DArray(nx, ny, nz, nt);
-	az = init4DArray(nx, ny, nz, nt);
+	const size_t np = nx * ny * nz;
+	const size_t full = kinBytes(WAVES_PREC_REAL, np, nt);
+	const size_t bytes = kinBytes(kin_prec, np, nt);
+
+	releaseKin();
+	try {
+		kin_mem.assign(bytes, 0);
+	} catch (std::bad_alloc&) {
+		LOGERR << "Failure allocating " << bytes
+		       << " bytes for the waves data grid" << endl;
+		throw moordyn::mem_error("Insufficient memory");
+	}
+	bindKin(kin_mem.data());
+
+	LOGMSG << "Allocated " << bytes << " bytes for the waves data grid";
+	if (bytes < full)
+		LOGMSG << ", saving " << full - bytes << " bytes ("
+		       << 100.0 * (full - bytes) / full << "%)";
+	LOGMSG << endl;
+}
+
+size_t
+Waves::kinBytes(waves_precision prec, size_t np, size_t nt)
+{
+	const size_t n = np * nt;
+	if (prec == WAVES_PREC_FLOAT)
+		return KIN_NFIELDS * n * sizeof(float);
+	if (prec == WAVES_PREC_FIXED16)
+		return KIN_NFIELDS * (n * sizeof(int16_t) + np * sizeof(float));
+	return KIN_NFIELDS * n * sizeof(real);
+}
+
+void
+Waves::bindKin(uint8_t* data)
+{
+	// Eigen::Map cannot be reassigned, but it can be built again in place
+	new (&kin) kinmap<real>(NULL, KIN_NFIELDS, 0);
+	new (&kin_f) kinmap<float>(NULL, KIN_NFIELDS, 0);
+	new (&kin_q) kinmap<int16_t>(NULL, KIN_NFIELDS, 0);
+	new (&kin_scale) kinmap<float>(NULL, KIN_NFIELDS, 0);
+	if (!data)
+		return;
+
+	const size_t np = nx * ny * nz;
+	const size_t n = np * nt;
+	if (kin_prec == WAVES_PREC_FLOAT)
+		new (&kin_f) kinmap<float>((float*)data, KIN_NFIELDS, n);
+	else if (kin_prec == WAVES_PREC_FIXED16) {
+		new (&kin_q) kinmap<int16_t>((int16_t*)data, KIN_NFIELDS, n);
+		float* scale = (float*)(data + KIN_NFIELDS * n * sizeof(int16_t));
+		new (&kin_scale) kinmap<float>(scale, KIN_NFIELDS, np);
+	} else
+		new (&kin) kinmap<real>((real*)data, KIN_NFIELDS, n);
+}
+
+void
+Waves::releaseKin()
+{
+	// The background synthesis may be still writing on the grid
+	if (stream_job.valid())
+		stream_job.wait();
+	bindKin(NULL);
+	std::vector<uint8_t>().swap(kin_mem);
+	if (kin_map)
+		unmapFile(kin_map, kin_map_size);
+	kin_map = NULL;
+	kin_map_size = 0;
+}
+
+uint64_t
+Waves::cacheKey(const EnvCond* env, const char* folder) const
+{
+	const uint32_t version[3] = { WAVES_CACHE_VERSION,
+		                          MOORDYN_MAJOR_VERSION,
+		                          MOORDYN_MINOR_VERSION };
+	const uint32_t opts[3] = { (uint32_t)sizeof(real),
+		                       (uint32_t)env->WaveKin,
+		                       (uint32_t)env->WavePrec };
+	const double params[4] = { env->dtWave, env->g, env->rho_w, env->WtrDpth };
+	uint64_t h = fnv1a(version, sizeof(version));
+	h = fnv1a(opts, sizeof(opts), h);
+	h = fnv1a(params, sizeof(params), h);
+
+	// Just the files which might be read are considered. The missing ones
+	// are hashed as well, with an impossible size. The currents are not
+	// stored in the grid, see ::cur_z
+	const char* files[3] = { "wave_frequencies.txt",
+		                     "wave_elevation.txt",
+		                     "water_grid.txt" };
+	for (auto name : files) {
+		h = fnv1a(name, strlen(name), h);
+		ifstream f((string)folder + "/" + name, ios::in | ios::binary);
+		if (!f.is_open()) {
+			const uint64_t missing = std::numeric_limits<uint64_t>::max();
+			h = fnv1a(&missing, sizeof(missing), h);
+			continue;
+		}
+		stringstream data;
+		data << f.rdbuf();
+		const string content = data.str();
+		const uint64_t size = content.size();
+		h = fnv1a(&size, sizeof(size), h);
+		h = fnv1a(content.data(), content.size(), h);
+	}
+	// The fitted grid is not read from water_grid.txt
+	if (grid_fit) {
+		for (auto p : { &px, &py, &pz }) {
+			const uint64_t size = p->size();
+			h = fnv1a(&size, sizeof(size), h);
+			h = fnv1a(p->data(), p->size() * sizeof(real), h);
+		}
+	}
+	return h;
+}
+
+bool
+Waves::loadCache(const std::string& filepath, uint64_t key)
+{
+	size_t size;
+	void* addr = mapFile(filepath, size);
+	if (!addr)
+		return false;
+	const waves_cache_header* h = (const waves_cache_header*)addr;
+	const char* reason = NULL;
+	size_t ncoords = 0, np = 0;
+	if (size < sizeof(waves_cache_header))
+		reason = "truncated file";
+	else if (strncmp(h->magic, "MDWAVES", 8) ||
+	         (h->version != WAVES_CACHE_VERSION) ||
+	         (h->endianness != 0x01020304) || (h->real_size != sizeof(real)) ||
+	         (h->prec > WAVES_PREC_FIXED16))
+		reason = "incompatible format";
+	else if (h->key != key)
+		reason = "generated from other inputs";
+	else {
+		ncoords = (size_t)h->nx + h->ny + h->nz;
+		np = (size_t)h->nx * h->ny * h->nz;
+		const size_t coords =
+		    sizeof(waves_cache_header) + ncoords * sizeof(real);
+		const size_t bytes = kinBytes((waves_precision)h->prec, np, h->nt);
+		if (!np || !h->nt || (h->offset < coords) || (h->bytes != bytes) ||
+		    (h->offset + h->bytes != size))
+			reason = "truncated file";
+	}
+	if (reason) {
+		LOGWRN << "Discarding the waves grid cache '" << filepath << "': "
+		       << reason << endl;
+		unmapFile(addr, size);
+		return false;
+	}
+
+	releaseKin();
+	nx = h->nx;
+	ny = h->ny;
+	nz = h->nz;
+	nt = h->nt;
+	dtWave = h->dtWave;
+	dpx = h->dpx;
+	dpy = h->dpy;
+	dpz = h->dpz;
+	const real* p = (const real*)(h + 1);
+	px.assign(p, p + nx);
+	py.assign(p + nx, p + nx + ny);
+	pz.assign(p + nx + ny, p + ncoords);
+	kin_prec = (waves_precision)h->prec;
+	kin_map = addr;
+	kin_map_size = size;
+	bindKin((uint8_t*)addr + h->offset);
+
+	LOGMSG << "Wave grid of " << np << " points x " << nt
+	       << " time steps mapped from the cache '" << filepath << "'"
+	       << endl;
+	return true;
+}
+
+bool
+Waves::saveCache(const std::string& filepath, uint64_t key) const
+{
+	waves_cache_header h;
+	memset(&h, 0, sizeof(waves_cache_header));
+	strncpy(h.magic, "MDWAVES", 8);
+	h.version = WAVES_CACHE_VERSION;
+	h.endianness = 0x01020304;
+	h.key = key;
+	h.real_size = sizeof(real);
+	h.prec = kin_prec;
+	h.nx = nx;
+	h.ny = ny;
+	h.nz = nz;
+	h.nt = nt;
+	h.dtWave = dtWave;
+	h.dpx = dpx;
+	h.dpy = dpy;
+	h.dpz = dpz;
+	const size_t coords =
+	    sizeof(waves_cache_header) + (nx + ny + nz) * sizeof(real);
+	h.offset = (coords + WAVES_CACHE_ALIGN - 1) / WAVES_CACHE_ALIGN *
+	           WAVES_CACHE_ALIGN;
+	h.bytes = kin_mem.size();
+	const std::vector<char> padding(h.offset - coords, 0);
+
+	// Each process writes its own temporal file, so the concurrent ones
+	// never see an incomplete cache
+#ifdef WIN32
+	const string tmppath = filepath + "." + to_string(_getpid()) + ".tmp";
+#else
+	const string tmppath = filepath + "." + to_string(getpid()) + ".tmp";
+#endif
+	ofstream f(tmppath, ios::out | ios::binary);
+	if (f.is_open()) {
+		f.write((const char*)&h, sizeof(waves_cache_header));
+		f.write((const char*)px.data(), nx * sizeof(real));
+		f.write((const char*)py.data(), ny * sizeof(real));
+		f.write((const char*)pz.data(), nz * sizeof(real));
+		f.write(padding.data(), padding.size());
+		f.write((const char*)kin_mem.data(), kin_mem.size());
+		f.close();
+	}
+	if (!f || std::rename(tmppath.c_str(), filepath.c_str())) {
+		std::remove(tmppath.c_str());
+		LOGWRN << "The waves grid cache '" << filepath
+		       << "' cannot be written" << endl;
+		return false;
+	}
+
+	LOGMSG << "Wave grid cached in '" << filepath << "'" << endl;
+	return true;
+}
 
-	LOGDBG << "Allocated the waves data grid";
+void
+Waves::loadSeries(unsigned int ix,
+                  unsigned int iy,
+                  unsigned int iz,
+                  kinseries& s) const
+{
+	const unsigned int p = gridIndex(ix, iy, iz, 0);
+	s.resize(KIN_NFIELDS, nt);
+	for (unsigned int it = 0; it < nt; it++)
+		s.col(it) = kinCol(p, it);
+}
+
+void
+Waves::storeSeries(unsigned int ix,
+                   unsigned int iy,
+                   unsigned int iz,
+                   const kinseries& s)
+{
+	const unsigned int np = nx * ny * nz;
+	const unsigned int p = gridIndex(ix, iy, iz, 0);
+	if (kin_prec == WAVES_PREC_FLOAT) {
+		for (unsigned int it = 0; it < nt; it++)
+			kin_f.col(it * np + p) = s.col(it).cast<float>();
+	} else if (kin_prec == WAVES_PREC_FIXED16) {
+		// Each field is mapped to [-32767, 32767], so the quantization error
+		// is relative to the largest magnitude at this point
+		const real qmax = std::numeric_limits<int16_t>::max();
+		const Eigen::Matrix<real, KIN_NFIELDS, 1> amax =
+		    s.cwiseAbs().rowwise().maxCoeff();
+		Eigen::Matrix<real, KIN_NFIELDS, 1> iscale;
+		for (unsigned int f = 0; f < KIN_NFIELDS; f++) {
+			kin_scale(f, p) = amax[f] / qmax;
+			iscale[f] = amax[f] > 0.0 ? 1.0 / kin_scale(f, p) : 0.0;
+		}
+		for (unsigned int it = 0; it < nt; it++) {
+			kin_q.col(it * np + p) = s.col(it)
+			                             .cwiseProduct(iscale)
+			                             .array()
+			                             .round()
+			                             .cwiseMax(-qmax)
+			                             .cwiseMin(qmax)
+			                             .cast<int16_t>();
+		}
+	} else {
+		for (unsigned int it = 0; it < nt; it++)
+			kin.col(it * np + p) = s.col(it);
+	}
 }
 
 void
@@ -232,6 +752,25 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 	nx = 0;
 	ny = 0;
 	nz = 0;
+	nt = 0;
+	dpx = 0.0;
+	dpy = 0.0;
+	dpz = 0.0;
+	kin_prec = env->WavePrec;
+	releaseKin();
+	spectral = false;
+	stream = false;
+	depth = env->WtrDpth;
+	kin_t = std::numeric_limits<real>::quiet_NaN();
+	kin_it = 0;
+	kin_ft = 0.0;
+	slab.resize(KIN_NFIELDS, 0);
+	cur_z.clear();
+	cur_nt = 0;
+	cur_dt = 0.0;
+	cur_u.resize(3, 0);
+	cur_t = std::numeric_limits<real>::quiet_NaN();
+	cur_slab.resize(3, 0);
 
 	// ======================== check compatibility of wave and current settings
 	// =====================
@@ -290,12 +829,18 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 			       << "set from inputted velocity, acceleration, and wave "
 			          "elevation grid data (TBD)"
 			       << endl;
+		else if (env->WaveKin == moordyn::WAVES_SPECTRAL)
+			LOGDBG << "Waves only: option 7 - "
+			       << "set from inputted wave elevation time series, "
+			       << "spectral components summed on the nodes" << endl;
 		else {
-			LOGDBG << "Invald wave kinematics input settings (must be 0-6)"
+			LOGDBG << "Invald wave kinematics input settings (must be 0-7)"
 			       << endl;
 			throw moordyn::invalid_value_error("Invalid settings");
 		}
-	} else if (is_waves_grid(env->WaveKin) && is_currents_grid(env->Current)) {
+	} else if ((is_waves_grid(env->WaveKin) ||
+	            (env->WaveKin == moordyn::WAVES_SPECTRAL)) &&
+	           is_currents_grid(env->Current)) {
 		LOGDBG << "Waves and currents: options " << env->WaveKin << " & "
 		       << env->Current << endl;
 	} else if (is_waves_node(env->WaveKin) && is_currents_node(env->Current)) {
@@ -309,8 +854,38 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 
 	// NOTE: nodal settings should use storeWaterKin in objects
 
+	bool streamed = env->WaveWindow > 0.0;
+	if (streamed && (env->WaveKin != moordyn::WAVES_GRID)) {
+		LOGWRN << "WaveWindow is only considered with WaveKin = "
+		       << moordyn::WAVES_GRID << endl;
+		streamed = false;
+	}
+
+	// The grid can be fitted to the mooring instead of reading it
+	grid_fit = false;
+	if (env->WaveGridFit && is_waves_grid(env->WaveKin)) {
+		fitGrid(env);
+		grid_fit = true;
+	}
+
+	// A former run may have already computed the same grid. The spectral
+	// waves are not worth caching, and the streamed ones are never complete
+	string cachepath;
+	uint64_t cachekey = 0;
+	bool cached = false;
+	if (env->WaveCache && !streamed && is_waves_grid(env->WaveKin)) {
+		cachekey = cacheKey(env, folder);
+		stringstream name;
+		name << folder << "/wave_grid_" << hex << setw(16) << setfill('0')
+		     << cachekey << ".cache";
+		cachepath = name.str();
+		cached = loadCache(cachepath, cachekey);
+	}
+
 	// now go through each applicable WaveKin option
-	if (env->WaveKin == moordyn::WAVES_FFT_GRID) {
+	if (cached) {
+		// The grid is already there
+	} else if (env->WaveKin == moordyn::WAVES_FFT_GRID) {
 		const string WaveFilename = (string)folder + "/wave_frequencies.txt";
 		LOGMSG << "Reading waves FFT from '" << WaveFilename << "'..." << endl;
 
@@ -381,13 +956,15 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 		interp(wavefreqs, waveelevs, freqs, zetaC0);
 
 		// calculate wave kinematics throughout the grid
+		nt = 2 * (nw - 1);
 		try {
 			makeGrid(((string)folder + "/water_grid.txt").c_str());
 			fillWaveGrid(zetaC0.data(), nw, dw, env->g, env->WtrDpth);
 		} catch (...) {
 			throw;
 		}
-	} else if (env->WaveKin == moordyn::WAVES_GRID) {
+	} else if ((env->WaveKin == moordyn::WAVES_GRID) ||
+	           (env->WaveKin == moordyn::WAVES_SPECTRAL)) {
 		// load wave elevation time series from file (similar to what's done in
 		// GenerateWaveExtnFile.py, and was previously in misc2.cpp)
 		const string WaveFilename = (string)folder + "/wave_elevation.txt";
@@ -504,12 +1081,22 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 			if (i * dw > 0.5 * 2 * pi)
 				zetaC0[i] = 0.0;
 
-		// calculate wave kinematics throughout the grid
+		// calculate wave kinematics throughout the grid, or just keep the
+		// spectral components
 		try {
-			// make a grid for wave kinematics based on settings in
-			// water_grid.txt
-			makeGrid(((string)folder + "/water_grid.txt").c_str());
-			fillWaveGrid(zetaC0, nw, dw, env->g, env->WtrDpth);
+			if (env->WaveKin == moordyn::WAVES_SPECTRAL) {
+				makeSpectrum(zetaC0, nw, nFFT, env->WtrDpth);
+			} else if (streamed) {
+				setupStream(waveElev,
+				            env->WaveWindow,
+				            env->WtrDpth,
+				            ((string)folder + "/water_grid.txt").c_str());
+			} else {
+				// make a grid for wave kinematics based on settings in
+				// water_grid.txt
+				makeGrid(((string)folder + "/water_grid.txt").c_str());
+				fillWaveGrid(zetaC0, nw, dw, env->g, env->WtrDpth);
+			}
 		} catch (...) {
 			throw;
 		}
@@ -521,7 +1108,7 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 		free(zetaC0);
 	}
 
-	// Now add in current velocities (add to unsteady wave kinematics)
+	// Now read the currents profile, added to the waves on each query
 	if (env->Current == CURRENTS_STEADY_GRID) {
 		const string CurrentsFilename = (string)folder + "/current_profile.txt";
 		LOGMSG << "Reading currents profile from '" << CurrentsFilename
@@ -574,60 +1161,18 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 		}
 		LOGMSG << "'" << CurrentsFilename << "' parsed" << endl;
 
-		// NOTE: check data
-
-		// interpolate and add data to wave kinematics grid
-
-		if (nx * ny * nz == 0) {
-			// A grid hasn't been set up yet, make it based on the read-in z
-			// values
-			nx = 1;
-			px.assign(nx, 0.0);
-			ny = 1;
-			py.assign(ny, 0.0);
-			nz = UProfileZ.size();
-			pz.assign(nz, 0.0);
-			for (unsigned int i = 0; i < nz; i++)
-				pz[i] = UProfileZ[i];
-
-			// set 1 time step to indicate steady data
-			nt = 1;
-			dtWave = 1.0; // arbitrary entry
-
-			try {
-				allocateKinematicsArrays();
-			} catch (...) {
-				throw;
-			}
-
-			// fill in output arrays
-			for (unsigned int i = 0; i < nz; i++) {
-				ux[0][0][i][0] = UProfileUx[i];
-				uy[0][0][i][0] = UProfileUy[i];
-				uz[0][0][i][0] = UProfileUz[i];
-			}
-		} else {
-			real fz;
-			unsigned izi = 1;
-			for (unsigned int iz = 0; iz < nz; iz++) {
-				izi = interp_factor(UProfileZ, izi, pz[iz], fz);
-				for (unsigned int ix = 0; ix < nx; ix++) {
-					for (unsigned int iy = 0; iy < ny; iy++) {
-						for (unsigned int it = 0; it < nt; it++) {
-							ux[ix][iy][iz][it] +=
-							    UProfileUx[izi] * fz +
-							    UProfileUx[izi - 1] * (1. - fz);
-							uy[ix][iy][iz][it] +=
-							    UProfileUy[izi] * fz +
-							    UProfileUy[izi - 1] * (1. - fz);
-							uz[ix][iy][iz][it] +=
-							    UProfileUz[izi] * fz +
-							    UProfileUz[izi - 1] * (1. - fz);
-						}
-					}
-				}
-			}
+		// The profile only depends on the depth, so it is kept apart from
+		// the waves grid, with a single time step
+		cur_z = UProfileZ;
+		cur_nt = 1;
+		cur_dt = 1.0; // arbitrary entry
+		cur_u.resize(3, cur_z.size());
+		for (unsigned int i = 0; i < cur_z.size(); i++) {
+			cur_u(0, i) = UProfileUx[i];
+			cur_u(1, i) = UProfileUy[i];
+			cur_u(2, i) = UProfileUz[i];
 		}
+		makeProfileIndex();
 	} else if (env->Current == CURRENTS_DYNAMIC_GRID) {
 		const string CurrentsFilename =
 		    (string)folder + "/current_profile_dynamic.txt";
@@ -701,94 +1246,47 @@ Waves::setup(EnvCond* env, TimeScheme* t, const char* folder)
 		}
 		LOGMSG << "'" << CurrentsFilename << "' parsed" << endl;
 
-		// check data
-		if ((nx * ny * nz != 0) && !nt) {
-			LOGERR << "At least one time step of current data read from '"
-			       << CurrentsFilename << "', but nt = 0" << endl;
-			throw moordyn::invalid_value_error("No time data");
-		}
-
-		// interpolate and add data to wave kinematics grid
-		if (nx * ny * nz == 0) {
-			// A grid hasn't been set up yet, make it based on the read-in z
-			// values
-			nx = 1;
-			px.assign(nx, 0.0);
-			ny = 1;
-			py.assign(ny, 0.0);
-			nz = UProfileZ.size();
-			pz.assign(nz, 0.0);
-			for (unsigned int i = 0; i < nz; i++)
-				pz[i] = UProfileZ[i];
-
-			// set the time step size to be the smallest interval in the
-			// inputted times
-			dtWave = std::numeric_limits<real>::max();
-			for (unsigned int i = 1; i < ntin; i++)
-				if (UProfileT[i] - UProfileT[i - 1] < dtWave)
-					dtWave = UProfileT[i] - UProfileT[i - 1];
-			nt = floor(UProfileT[ntin - 1] / dtWave) + 1;
-
-			try {
-				allocateKinematicsArrays();
-			} catch (...) {
-				throw;
-			}
-
-			// fill in output arrays
-			real ft;
-			unsigned iti = 1;
-			for (unsigned int iz = 0; iz < nz; iz++) {
-				for (unsigned int it = 0; it < nt; it++) {
-					// need to set iti, otherwise it will lock to final t after
-					// one pass through initially the upper index we check
-					// should always be one timestep ahead of it
-					iti = it + 1;
-					iti = interp_factor(UProfileT, iti, it * dtWave, ft);
-					ux[0][0][iz][it] = UProfileUx[iz][iti] * ft +
-					                   UProfileUx[iz][iti - 1] * (1. - ft);
-					uy[0][0][iz][it] = UProfileUy[iz][iti] * ft +
-					                   UProfileUy[iz][iti - 1] * (1. - ft);
-					uz[0][0][iz][it] = UProfileUz[iz][iti] * ft +
-					                   UProfileUz[iz][iti - 1] * (1. - ft);
-					// TODO: approximate fluid accelerations using finite
-					//       differences
-					ax[0][0][iz][it] = 0.0;
-					ay[0][0][iz][it] = 0.0;
-					az[0][0][iz][it] = 0.0;
-				}
-			}
-		} else // otherwise interpolate read in data and add to existing grid
-		       // (dtWave, px, etc are already set in the grid)
-		{
-			real fz;
-			unsigned izi = 1;
-			for (unsigned int iz = 0; iz < nz; iz++) {
-				izi = interp_factor(UProfileZ, izi, pz[iz], fz);
-				real ft;
-				unsigned iti = 1;
-				for (unsigned int it = 0; it < nt; it++) {
-					iti = it + 1; // Set initial iti
-					iti = interp_factor(UProfileT, iti, it * dtWave, ft);
-					for (unsigned int ix = 0; ix < nx; ix++) {
-						for (unsigned int iy = 0; iy < ny; iy++) {
-							ux[ix][iy][iz][it] +=
-							    interp2(UProfileUx, izi, iti, fz, ft);
-							uy[ix][iy][iz][it] +=
-							    interp2(UProfileUy, izi, iti, fz, ft);
-							uz[ix][iy][iz][it] +=
-							    interp2(UProfileUz, izi, iti, fz, ft);
-							// TODO: approximate fluid accelerations using
-							//       finite differences
-							ax[0][0][iz][it] = 0.0;
-							ay[0][0][iz][it] = 0.0;
-							az[0][0][iz][it] = 0.0;
-						}
-					}
-				}
+		// The profile only depends on the depth and the time, so it is kept
+		// apart from the waves grid. The time step size is the smallest
+		// interval in the inputted times
+		cur_z = UProfileZ;
+		cur_dt = std::numeric_limits<real>::max();
+		for (unsigned int i = 1; i < ntin; i++)
+			if (UProfileT[i] - UProfileT[i - 1] < cur_dt)
+				cur_dt = UProfileT[i] - UProfileT[i - 1];
+		cur_nt = floor(UProfileT[ntin - 1] / cur_dt) + 1;
+		cur_u.resize(3, cur_nt * nzin);
+
+		real ft;
+		unsigned iti = 1;
+		for (unsigned int iz = 0; iz < nzin; iz++) {
+			for (unsigned int it = 0; it < cur_nt; it++) {
+				// need to set iti, otherwise it will lock to final t after
+				// one pass through initially the upper index we check
+				// should always be one timestep ahead of it
+				iti = it + 1;
+				iti = interp_factor(UProfileT, iti, it * cur_dt, ft);
+				const unsigned int i = it * nzin + iz;
+				cur_u(0, i) = UProfileUx[iz][iti] * ft +
+				              UProfileUx[iz][iti - 1] * (1. - ft);
+				cur_u(1, i) = UProfileUy[iz][iti] * ft +
+				              UProfileUy[iz][iti - 1] * (1. - ft);
+				cur_u(2, i) = UProfileUz[iz][iti] * ft +
+				              UProfileUz[iz][iti - 1] * (1. - ft);
+				// TODO: approximate fluid accelerations using finite
+				//       differences
 			}
 		}
+		makeProfileIndex();
 	}
+
+	// Once cached, the grid is mapped back, so the physical memory is shared
+	// with the other processes
+	if (!cached && !cachepath.empty() && hasGrid() &&
+	    saveCache(cachepath, cachekey))
+		loadCache(cachepath, cachekey);
+
+	setTime(_t_integrator->GetTime(), 0);
 }
 
 void
@@ -800,116 +1298,691 @@ Waves::getWaveKin(real x,
                   moordyn::real& zeta_out,
                   moordyn::real& PDyn_out)
 {
-	real fx, fy, fz;
+	ivec cell = ivec::Ones();
+	pointKin(x, y, z, wave_t, cell, U_out, Ud_out, zeta_out, PDyn_out);
+}
+
+void
+Waves::getWaveKin(const vec3N& r,
+                  vec3N& U_out,
+                  vec3N& Ud_out,
+                  vecN& zeta_out,
+                  vecN& PDyn_out,
+                  std::vector<ivec>& cells)
+{
+	getWaveKin(r, U_out, Ud_out, zeta_out, PDyn_out, cells, wave_t);
+}
+
+void
+Waves::getWaveKin(const vec3N& r,
+                  vec3N& U_out,
+                  vec3N& Ud_out,
+                  vecN& zeta_out,
+                  vecN& PDyn_out,
+                  std::vector<ivec>& cells,
+                  real t) const
+{
+	if (stream && hasGrid() && (t != kin_t)) {
+		// The oldest block in memory might be overwritten by the background
+		// synthesis, see streamTo()
+		long b0, b1, c0, c1;
+		streamBlocks(t, b0, b1);
+		streamBlocks(kin_t, c0, c1);
+		if ((b0 + (long)STREAM_BLOCKS - 2 < c1) || (b1 > c1)) {
+			LOGERR << "The streamed waves grid cannot be queried at t = "
+			       << t << " s while it is set at t = " << kin_t << " s"
+			       << endl;
+			throw moordyn::invalid_value_error("Invalid time");
+		}
+	}
+
+	const unsigned int n = r.cols();
+	if (cells.size() != n)
+		cells.assign(n, ivec::Ones());
+
+	vec u, ud;
+	for (unsigned int i = 0; i < n; i++) {
+		pointKin(r(0, i),
+		         r(1, i),
+		         r(2, i),
+		         t,
+		         cells[i],
+		         u,
+		         ud,
+		         zeta_out[i],
+		         PDyn_out[i]);
+		U_out.col(i) = u;
+		Ud_out.col(i) = ud;
+	}
+}
+
+void
+Waves::getWaveKin(const std::vector<vec>& r,
+                  std::vector<vec>& U_out,
+                  std::vector<vec>& Ud_out,
+                  std::vector<real>& zeta_out,
+                  std::vector<real>& PDyn_out,
+                  std::vector<ivec>& cells)
+{
+	const unsigned int n = r.size();
+	if (cells.size() != n)
+		cells.assign(n, ivec::Ones());
+
+	for (unsigned int i = 0; i < n; i++) {
+		pointKin(r[i][0],
+		         r[i][1],
+		         r[i][2],
+		         wave_t,
+		         cells[i],
+		         U_out[i],
+		         Ud_out[i],
+		         zeta_out[i],
+		         PDyn_out[i]);
+	}
+}
 
-	auto ix = interp_factor(px, x, fx);
-	auto iy = interp_factor(py, y, fy);
-	auto iz = interp_factor(pz, z, fz);
+unsigned int
+Waves::axisFactor(const std::vector<real>& p,
+                  real dp,
+                  unsigned int i0,
+                  real x,
+                  real& f)
+{
+	const unsigned int n = p.size();
+	if (n == 1) {
+		f = 0.0;
+		return 0;
+	}
+	if (dp > 0.0) {
+		if (x <= p.front()) {
+			f = 0.0;
+			return 1;
+		}
+		if (x >= p.back()) {
+			f = 1.0;
+			return n - 1;
+		}
+		unsigned int i = (unsigned int)floor((x - p.front()) / dp) + 1;
+		if (i > n - 1)
+			i = n - 1;
+		f = (x - p[i - 1]) / (p[i] - p[i - 1]);
+		f = std::max(real(0.0), std::min(real(1.0), f));
+		return i;
+	}
+	// interp_factor() only searches forward
+	if (i0 > n - 1)
+		i0 = n - 1;
+	while (i0 > 1 && x < p[i0 - 1])
+		i0--;
+	return interp_factor(p, i0, x, f);
+}
 
+unsigned int
+Waves::timeFactor(real t, real& ft) const
+{
+	return timeFactor(t, dtWave, nt, ft);
+}
+
+unsigned int
+Waves::timeFactor(real t, real dt, unsigned int n, real& ft)
+{
 	unsigned int it = 0;
-	real ft = 0.0;
-	if (nt > 1) {
-		real quot = _t_integrator->GetTime() / dtWave;
+	ft = 0.0;
+	if (n > 1) {
+		real quot = t / dt;
 		it = floor(quot);
 		ft = quot - it;
 		it++; // We use the upper bound
-		while (it > nt - 1)
-			it -= nt;
+		while (it > n - 1)
+			it -= n;
+	}
+	return it;
+}
+
+void
+Waves::makeProfileIndex()
+{
+	const unsigned int n = cur_z.size();
+	for (unsigned int i = 1; i < n; i++) {
+		if (cur_z[i] < cur_z[i - 1]) {
+			LOGERR << "Ascending depths are expected on the currents profile"
+			       << endl;
+			throw moordyn::invalid_value_error("Invalid depths");
+		}
 	}
 
-	zeta_out = interp3(zeta, ix, iy, it, fx, fy, ft);
+	cur_zbin.clear();
+	cur_dzbin = 0.0;
+	if (n < 2)
+		return;
+	// A few bins per profile point, so the profile points sharing a bin are
+	// just a few even if they are not equispaced
+	const unsigned int nbins = 4 * (n - 1);
+	cur_dzbin = (cur_z.back() - cur_z.front()) / nbins;
+	cur_zbin.resize(nbins);
+	unsigned int i = 1;
+	for (unsigned int b = 0; b < nbins; b++) {
+		const real z = cur_z.front() + b * cur_dzbin;
+		while ((i < n - 1) && (cur_z[i] < z))
+			i++;
+		cur_zbin[b] = i;
+	}
 
-	U_out[0] = interp4(ux, ix, iy, iz, it, fx, fy, fz, ft);
-	U_out[1] = interp4(uy, ix, iy, iz, it, fx, fy, fz, ft);
-	U_out[2] = interp4(uz, ix, iy, iz, it, fx, fy, fz, ft);
+	LOGMSG << "Currents profile of " << n << " depths x " << cur_nt
+	       << " time steps" << endl;
+}
 
-	Ud_out[0] = interp4(ax, ix, iy, iz, it, fx, fy, fz, ft);
-	Ud_out[1] = interp4(ay, ix, iy, iz, it, fx, fy, fz, ft);
-	Ud_out[2] = interp4(az, ix, iy, iz, it, fx, fy, fz, ft);
+unsigned int
+Waves::profileFactor(real z, real& f) const
+{
+	const unsigned int n = cur_z.size();
+	if (n == 1) {
+		f = 0.0;
+		return 0;
+	}
+	if (z <= cur_z.front()) {
+		f = 0.0;
+		return 1;
+	}
+	if (z >= cur_z.back()) {
+		f = 1.0;
+		return n - 1;
+	}
+	unsigned int b = (unsigned int)((z - cur_z.front()) / cur_dzbin);
+	if (b > cur_zbin.size() - 1)
+		b = cur_zbin.size() - 1;
+	// The bin might be wrong because of the round off errors
+	unsigned int i = cur_zbin[b];
+	while ((i > 1) && (z <= cur_z[i - 1]))
+		i--;
+	while (z > cur_z[i])
+		i++;
+	f = (z - cur_z[i - 1]) / (cur_z[i] - cur_z[i - 1]);
+	return i;
+}
 
-	PDyn_out = interp4(PDyn, ix, iy, iz, it, fx, fy, fz, ft);
+void
+Waves::pointKin(real x,
+                real y,
+                real z,
+                real t,
+                ivec& cell,
+                vec& U_out,
+                vec& Ud_out,
+                real& zeta_out,
+                real& PDyn_out) const
+{
+	Eigen::Matrix<real, KIN_NFIELDS, 1> k;
+	if (hasGrid()) {
+		real fx, fy, fz;
+		cell[0] = axisFactor(px, dpx, cell[0], x, fx);
+		cell[1] = axisFactor(py, dpy, cell[1], y, fy);
+		cell[2] = axisFactor(pz, dpz, cell[2], z, fz);
+		if (t != kin_t) {
+			real ft;
+			const unsigned int it = timeFactor(t, ft);
+			k = interpKin(cell[0], cell[1], cell[2], it, fx, fy, fz, ft);
+		} else if (slab.cols())
+			k = interpSlab(cell[0], cell[1], cell[2], fx, fy, fz);
+		else
+			k = interpKin(
+			    cell[0], cell[1], cell[2], kin_it, fx, fy, fz, kin_ft);
+	} else
+		k.setZero();
+
+	zeta_out = k[KIN_ZETA];
+	PDyn_out = k[KIN_PDYN];
+	U_out = k.segment<3>(KIN_UX);
+	Ud_out = k.segment<3>(KIN_AX);
+
+	if (spectral)
+		spectralKin(x, y, z, t - spec_t, U_out, Ud_out, zeta_out, PDyn_out);
+
+	if (!cur_z.empty()) {
+		// The currents profile is interpolated in time on setTime(), unless
+		// it is queried at another time
+		real fz;
+		const unsigned int iz = profileFactor(z, fz);
+		const unsigned int k[2] = { iz > 0 ? iz - 1 : 0, iz };
+		const real wk[2] = { 1.0 - fz, fz };
+		const unsigned int n = cur_z.size();
+		real ft = 0.0;
+		unsigned int it = 0, it0 = 0;
+		if (t != cur_t) {
+			it = timeFactor(t, cur_dt, cur_nt, ft);
+			it0 = it > 0 ? it - 1 : cur_nt - 1;
+		}
+		vec u = vec::Zero();
+		for (unsigned int e = 0; e < 2; e++) {
+			if (wk[e] == 0.0)
+				continue;
+			if (t == cur_t)
+				u.noalias() += wk[e] * cur_slab.col(k[e]);
+			else
+				u.noalias() +=
+				    wk[e] * ((1.0 - ft) * cur_u.col(it0 * n + k[e]) +
+				             ft * cur_u.col(it * n + k[e]));
+		}
+		U_out += u;
+	}
 }
 
 void
-Waves::fillWaveGrid(const moordyn::complex* zetaC0,
+Waves::spectralKin(real x,
+                   real y,
+                   real z,
+                   real dt,
+                   vec& U_out,
+                   vec& Ud_out,
+                   real& zeta_out,
+                   real& PDyn_out) const
+{
+	typedef Eigen::Array<real, SPEC_BLOCK, 1> block;
+
+	// There is no wave stretching, so above the mean free surface the
+	// kinematics at z = 0 are taken
+	z = std::max(std::min(z, real(0.0)), -depth);
+
+	real zeta = spec_zeta0, pdyn = spec_zeta0;
+	vec u = vec::Zero(), ud = vec::Zero();
+	for (unsigned int i = 0; i < spec_ar.size(); i += SPEC_BLOCK) {
+		const block k = spec_k.segment<SPEC_BLOCK>(i);
+		const block w = spec_w.segment<SPEC_BLOCK>(i);
+		const block cb = spec_cb.segment<SPEC_BLOCK>(i);
+		const block sb = spec_sb.segment<SPEC_BLOCK>(i);
+		block c = spec_c.segment<SPEC_BLOCK>(i);
+		block s = spec_s.segment<SPEC_BLOCK>(i);
+		if (dt != 0.0) {
+			// exp(i w (t + dt)) = exp(i w t) exp(i w dt)
+			const block c0 = c;
+			const block cdt = (w * dt).cos();
+			const block sdt = (w * dt).sin();
+			c = c0 * cdt - s * sdt;
+			s = s * cdt + c0 * sdt;
+		}
+
+		// exp(i (w t - k l))
+		const block kl = k * (x * cb + y * sb);
+		const block ckl = kl.cos();
+		const block skl = kl.sin();
+		const block cth = c * ckl + s * skl;
+		const block sth = s * ckl - c * skl;
+		const block ar = spec_ar.segment<SPEC_BLOCK>(i);
+		const block ai = spec_ai.segment<SPEC_BLOCK>(i);
+		const block re = ar * cth - ai * sth;
+		const block im = ar * sth + ai * cth;
+
+		// Depth attenuation, written so it cannot overflow:
+		//     SINH( k*( z + h ) )/SINH( k*h )
+		//     COSH( k*( z + h ) )/SINH( k*h )
+		//     COSH( k*( z + h ) )/COSH( k*h )
+		const block ea = (k * z).exp();
+		const block eb = (-k * (z + 2.0 * depth)).exp();
+		const block ss = (ea - eb) * spec_d1.segment<SPEC_BLOCK>(i);
+		const block cs = (ea + eb) * spec_d1.segment<SPEC_BLOCK>(i);
+		const block cc = (ea + eb) * spec_d2.segment<SPEC_BLOCK>(i);
+
+		zeta += re.sum();
+		pdyn += (cc * re).sum();
+		const block wr = w * cs * re;
+		const block wi = w * w * cs * im;
+		u[0] += (wr * cb).sum();
+		u[1] += (wr * sb).sum();
+		u[2] -= (w * ss * im).sum();
+		ud[0] -= (wi * cb).sum();
+		ud[1] -= (wi * sb).sum();
+		ud[2] -= (w * w * ss * re).sum();
+	}
+
+	zeta_out += zeta;
+	PDyn_out += rho_w * g * pdyn;
+	U_out += u;
+	Ud_out += ud;
+}
+
+void
+Waves::makeSpectrum(const moordyn::complex* zetaC0,
                     unsigned int nw,
-                    real dw,
-                    real g,
+                    unsigned int nFFT,
                     real h)
 {
 	// NOTE: should enable wave spreading at some point!
-	real beta = 0.0; // WaveDir_in;
+	const real beta = 0.0; // WaveDir_in;
+	const real dw = 2.0 * pi / (nFFT * dtWave);
+
+	// The null frequency is just a mean elevation, while the filtered out
+	// frequencies and the FFT round off noise are not worth summing
+	spec_zeta0 = std::real(zetaC0[0]) / nFFT;
+	real amax = 0.0;
+	for (unsigned int i = 1; i < nw; i++)
+		amax = (std::max)(amax, std::abs(zetaC0[i]));
+	vector<unsigned int> ids;
+	for (unsigned int i = 1; i < nw; i++) {
+		if (std::abs(zetaC0[i]) > 1.0e-10 * amax)
+			ids.push_back(i);
+	}
+	const unsigned int nc = ids.size();
+	const unsigned int n = (nc + SPEC_BLOCK - 1) / SPEC_BLOCK * SPEC_BLOCK;
+
+	spec_ar.setZero(n);
+	spec_ai.setZero(n);
+	spec_w.setZero(n);
+	spec_k.setZero(n);
+	spec_cb.setZero(n);
+	spec_sb.setZero(n);
+	spec_d1.setZero(n);
+	spec_d2.setZero(n);
+	for (unsigned int j = 0; j < nc; j++) {
+		const unsigned int i = ids[j];
+		// The real iFFT takes each component twice, except the Nyquist one
+		const real f = (2 * i == nFFT) ? 1.0 : 2.0;
+		const moordyn::complex c = f * zetaC0[i] / (real)nFFT;
+		spec_ar[j] = std::real(c);
+		spec_ai[j] = std::imag(c);
+		spec_w[j] = i * dw;
+		spec_k[j] = WaveNumber(spec_w[j], g, h);
+		spec_cb[j] = cos(beta);
+		spec_sb[j] = sin(beta);
+		const real e2 = exp(-2.0 * spec_k[j] * h);
+		spec_d1[j] = 1.0 / (1.0 - e2);
+		spec_d2[j] = 1.0 / (1.0 + e2);
+	}
 
-	// initialize some frequency-domain wave calc vectors
-	vector<real> w(nw, 0.);
-	vector<real> k(nw, 0.);
-	auto data_size = nw * sizeof(moordyn::complex);
-	// Fourier transform of wave elevation
-	moordyn::complex* zetaC = (moordyn::complex*)malloc(data_size);
-	// Fourier transform of dynamic pressure
-	moordyn::complex* PDynC = (moordyn::complex*)malloc(data_size);
-	// Fourier transform of wave velocities
-	moordyn::complex* UCx = (moordyn::complex*)malloc(data_size);
-	moordyn::complex* UCy = (moordyn::complex*)malloc(data_size);
-	moordyn::complex* UCz = (moordyn::complex*)malloc(data_size);
-	// Fourier transform of wave accelerations
-	moordyn::complex* UdCx = (moordyn::complex*)malloc(data_size);
-	moordyn::complex* UdCy = (moordyn::complex*)malloc(data_size);
-	moordyn::complex* UdCz = (moordyn::complex*)malloc(data_size);
-	if (!zetaC || !PDynC || !UCx || !UCy || !UCz || !UdCx || !UdCy || !UdCz) {
-		LOGERR << "Failure allocating " << 8 * data_size
-		       << "bytes for the FFT data" << endl;
-		throw moordyn::mem_error("Insufficient memory");
+	spec_t = std::numeric_limits<real>::quiet_NaN();
+	spec_c.setOnes(n);
+	spec_s.setZero(n);
+	spec_dt = 0.0;
+	spec_cdt.setOnes(n);
+	spec_sdt.setZero(n);
+	spec_nrot = 0;
+	spectral = true;
+
+	if (!nc) {
+		LOGWRN << "No wave spectral components were found" << endl;
+		return;
 	}
+	LOGMSG << nc << " wave spectral components, from " << ids.front() * dw
+	       << " rad/s to " << ids.back() * dw << " rad/s" << endl;
+}
 
-	// The number of wave time steps to be calculated
-	nt = 2 * (nw - 1);
+Eigen::Matrix<real, 8, 1>
+Waves::interpKin(unsigned int ix,
+                 unsigned int iy,
+                 unsigned int iz,
+                 unsigned int it,
+                 real fx,
+                 real fy,
+                 real fz,
+                 real ft) const
+{
+	const unsigned int i[2] = { ix > 0 ? ix - 1 : 0, ix };
+	const unsigned int j[2] = { iy > 0 ? iy - 1 : 0, iy };
+	const unsigned int k[2] = { iz > 0 ? iz - 1 : 0, iz };
+	// The time series is periodic, so the lower bound wraps around
+	const unsigned int w[2] = { it > 0 ? it - 1 : nt - 1, it };
+	const real wi[2] = { 1.0 - fx, fx };
+	const real wj[2] = { 1.0 - fy, fy };
+	const real wk[2] = { 1.0 - fz, fz };
+	const real ww[2] = { 1.0 - ft, ft };
+
+	Eigen::Matrix<real, KIN_NFIELDS, 1> c;
+	c.setZero();
+	for (unsigned int a = 0; a < 2; a++) {
+		for (unsigned int b = 0; b < 2; b++) {
+			for (unsigned int d = 0; d < 2; d++) {
+				for (unsigned int e = 0; e < 2; e++) {
+					const real f = ww[a] * wi[b] * wj[d] * wk[e];
+					if (f == 0.0)
+						continue;
+					const auto p = gridIndex(i[b], j[d], k[e], 0);
+					c.noalias() += f * kinCol(p, w[a]);
+				}
+			}
+		}
+	}
+	return c;
+}
+
+Eigen::Matrix<real, 8, 1>
+Waves::interpSlab(unsigned int ix,
+                  unsigned int iy,
+                  unsigned int iz,
+                  real fx,
+                  real fy,
+                  real fz) const
+{
+	const unsigned int i[2] = { ix > 0 ? ix - 1 : 0, ix };
+	const unsigned int j[2] = { iy > 0 ? iy - 1 : 0, iy };
+	const unsigned int k[2] = { iz > 0 ? iz - 1 : 0, iz };
+	const real wi[2] = { 1.0 - fx, fx };
+	const real wj[2] = { 1.0 - fy, fy };
+	const real wk[2] = { 1.0 - fz, fz };
+
+	Eigen::Matrix<real, KIN_NFIELDS, 1> c;
+	c.setZero();
+	for (unsigned int b = 0; b < 2; b++) {
+		for (unsigned int d = 0; d < 2; d++) {
+			for (unsigned int e = 0; e < 2; e++) {
+				const real f = wi[b] * wj[d] * wk[e];
+				if (f == 0.0)
+					continue;
+				c.noalias() += f * slab.col(gridIndex(i[b], j[d], k[e], 0));
+			}
+		}
+	}
+	return c;
+}
+
+void
+Waves::setTime(real t, unsigned int n)
+{
+	wave_t = t;
+	if (spectral && (t != spec_t)) {
+		// The phases are rotated incrementally, but computed from scratch
+		// every now and then to bound the round-off drift
+		const real dt = t - spec_t;
+		if (!(dt > 0.0) || (spec_nrot >= SPEC_RESYNC)) {
+			spec_c = (spec_w * t).cos();
+			spec_s = (spec_w * t).sin();
+			spec_nrot = 0;
+		} else {
+			if (dt != spec_dt) {
+				spec_cdt = (spec_w * dt).cos();
+				spec_sdt = (spec_w * dt).sin();
+				spec_dt = dt;
+			}
+			const arrayN c = spec_c;
+			spec_c = c * spec_cdt - spec_s * spec_sdt;
+			spec_s = spec_s * spec_cdt + c * spec_sdt;
+			spec_nrot++;
+		}
+		spec_t = t;
+	}
+
+	if (!cur_z.empty() && (t != cur_t)) {
+		// Just a few depths, so it is always worth interpolating in time
+		const unsigned int n = cur_z.size();
+		real ft;
+		const unsigned int it = timeFactor(t, cur_dt, cur_nt, ft);
+		const unsigned int it0 = it > 0 ? it - 1 : cur_nt - 1;
+		cur_slab.noalias() = (1.0 - ft) * cur_u.middleCols(it0 * n, n) +
+		                     ft * cur_u.middleCols(it * n, n);
+		cur_t = t;
+	}
+
+	if (!hasGrid())
+		return;
+	const unsigned int np = nx * ny * nz;
+	// Building the slab costs as much as interpolating in time 2 corners per
+	// grid point, while querying the 4-D grid takes 16 corners per point
+	const bool worth = 4 * n >= np;
+	if ((t == kin_t) && (slab.cols() || !worth))
+		return;
+
+	if (stream && (t != kin_t))
+		streamTo(t);
+	kin_t = t;
+	kin_it = timeFactor(t, kin_ft);
+	if (!worth) {
+		slab.resize(KIN_NFIELDS, 0);
+		return;
+	}
+	// The lower bound wraps around, as in interpKin()
+	const unsigned int it0 = kin_it > 0 ? kin_it - 1 : nt - 1;
+	const real f0 = 1.0 - kin_ft, f1 = kin_ft;
+	if (kin_prec == WAVES_PREC_FLOAT) {
+		slab.noalias() = f0 * kin_f.middleCols(it0 * np, np).cast<real>() +
+		                 f1 * kin_f.middleCols(kin_it * np, np).cast<real>();
+	} else if (kin_prec == WAVES_PREC_FIXED16) {
+		// The scale factors do not change along time
+		slab.noalias() =
+		    (f0 * kin_q.middleCols(it0 * np, np).cast<real>() +
+		     f1 * kin_q.middleCols(kin_it * np, np).cast<real>())
+		        .cwiseProduct(kin_scale.cast<real>());
+	} else {
+		slab.noalias() = f0 * kin.middleCols(it0 * np, np) +
+		                 f1 * kin.middleCols(kin_it * np, np);
+	}
+}
+
+void
+Waves::makeSynthesis(unsigned int nw,
+                     real dw,
+                     real g,
+                     real h,
+                     synthesis& s) const
+{
+	s.nw = nw;
+	s.w.assign(nw, 0.0);
+	s.k.assign(nw, 0.0);
 
 	// single-sided spectrum for real fft
 	for (unsigned int i = 0; i < nw; i++)
-		w[i] = (real)i * dw;
-
-	LOGMSG << "Wave frequencies from " << w[0] << " rad/s to " << w[nw - 1]
-	       << " rad/s in increments of " << dw << " rad/s" << endl;
+		s.w[i] = (real)i * dw;
 
 	LOGDBG << "Wave numbers in rad/m are ";
 	for (unsigned int I = 0; I < nw; I++) {
-		k[I] = WaveNumber(w[I], g, h);
-		LOGDBG << k[I] << ", ";
+		s.k[I] = WaveNumber(s.w[I], g, h);
+		LOGDBG << s.k[I] << ", ";
 	}
 	LOGDBG << endl;
 
-	LOGDBG << "   nt = " << nt << ", h = " << h << endl;
+	// The depth attenuation factors are the same on every (x, y) point, so
+	// they are computed just once for each z coordinate
+	//     SINH( k*( z + h ) )/SINH( k*h )
+	//     COSH( k*( z + h ) )/SINH( k*h )
+	//     COSH( k*( z + h ) )/COSH( k*h )
+	s.SINHNumOvrSIHNDen.assign(nz * nw, 0.0);
+	s.COSHNumOvrSIHNDen.assign(nz * nw, 0.0);
+	s.COSHNumOvrCOSHDen.assign(nz * nw, 0.0);
+	const vector<real>& k = s.k;
+	for (unsigned int iz = 0; iz < nz; iz++) {
+		real z = pz[iz];
+		for (unsigned int I = 0; I < nw; I++) {
+			const unsigned int j = iz * nw + I;
+			if (k[I] == 0.0) {
+				// The shallow water formulation is ill-conditioned;
+				// thus, the known value of unity is returned. The velocity
+				// factor is multiplied by a null frequency anyway
+				s.SINHNumOvrSIHNDen[j] = 1.0;
+				s.COSHNumOvrSIHNDen[j] = 99999.0;
+				s.COSHNumOvrCOSHDen[j] = 1.0;
+			} else if (k[I] * h > 89.4) {
+				// The shallow water formulation will trigger a floating
+				// point overflow error; however, for
+				// h > 14.23 * wavelength (since k = 2 * Pi /
+				// wavelength) we can use the numerically-stable deep
+				// water formulation instead.
+				s.SINHNumOvrSIHNDen[j] = exp(k[I] * z);
+				s.COSHNumOvrSIHNDen[j] = exp(k[I] * z);
+				s.COSHNumOvrCOSHDen[j] =
+				    exp(k[I] * z) + exp(-k[I] * (z + 2.0 * h));
+			} else if (-k[I] * h > 89.4) {
+				// @mth: added negative k case
+				// NOTE: CHECK CORRECTNESS
+				s.SINHNumOvrSIHNDen[j] = -exp(-k[I] * z);
+				s.COSHNumOvrSIHNDen[j] = -exp(-k[I] * z);
+				s.COSHNumOvrCOSHDen[j] =
+				    -exp(-k[I] * z) + exp(-k[I] * (z + 2.0 * h));
+			} else {
+				// shallow water formulation
+				s.SINHNumOvrSIHNDen[j] =
+				    sinh(k[I] * (z + h)) / sinh(k[I] * h);
+				s.COSHNumOvrSIHNDen[j] =
+				    cosh(k[I] * (z + h)) / sinh(k[I] * h);
+				s.COSHNumOvrCOSHDen[j] =
+				    cosh(k[I] * (z + h)) / cosh(k[I] * h);
+			}
+		}
+	}
+}
 
-	// precalculates wave kinematics for a given set of node points for a series
-	// of time steps
-	LOGDBG << "Making wave Kinematics (iFFT)..." << endl;
+void
+Waves::synthGrid(const synthesis& s,
+                 const moordyn::complex* zetaC0,
+                 std::function<void(unsigned int,
+                                    unsigned int,
+                                    unsigned int,
+                                    const kinseries&)> sink,
+                 real& wall,
+                 real& work) const
+{
+	// NOTE: should enable wave spreading at some point!
+	real beta = 0.0; // WaveDir_in;
+
+	const unsigned int nw = s.nw;
+	const vector<real>& w = s.w;
+	const vector<real>& k = s.k;
 
 	// start the FFT stuff using kiss_fft
-	unsigned int nFFT = nt;
+	unsigned int nFFT = 2 * (nw - 1);
 	const int is_inverse_fft = 1;
 
-	// allocate memory for kiss_fftr
+	// allocate memory for kiss_fftr. The plan is shared by all the threads,
+	// which are using their own scratch buffers instead of the plan one
 	kiss_fftr_cfg cfg = kiss_fftr_alloc(nFFT, is_inverse_fft, NULL, NULL);
-
-	// allocate input and output arrays for kiss_fftr  (note that
-	// kiss_fft_scalar is set to double)
-	kiss_fft_cpx* cx_w_in = (kiss_fft_cpx*)malloc(nw * sizeof(kiss_fft_cpx));
-	kiss_fft_scalar* cx_t_out =
-	    (kiss_fft_scalar*)malloc(nFFT * sizeof(kiss_fft_scalar));
-	if (!cx_w_in || !cx_t_out) {
-		LOGERR << "Failure allocating "
-		       << nw * sizeof(kiss_fft_cpx) + nFFT * sizeof(kiss_fft_scalar)
-		       << "bytes for the iFFT" << endl;
+	if (!cfg) {
+		LOGERR << "Failure allocating the iFFT plan" << endl;
 		throw moordyn::mem_error("Insufficient memory");
 	}
 
-	// calculating wave kinematics for each grid point
+	// calculating wave kinematics for each grid point. The grid points are
+	// evenly split among the threads, since all of them take the same work
+	const unsigned int np = nx * ny * nz;
+	ThreadPool pool(_t_integrator ? _t_integrator->GetThreads() : 1);
+	const unsigned int nchunks = std::min(pool.GetThreads(), np);
+	vector<real> chunk_time(nchunks, 0.0);
+	auto fill_chunk = [&](unsigned int chunk) {
+		const real t0 = threadTime();
+
+		// Thread scratch buffers
+		// Fourier transform of wave elevation, dynamic pressure, wave
+		// velocities and wave accelerations
+		vector<moordyn::complex> fieldsC(KIN_NFIELDS * nw);
+		moordyn::complex* zetaC = fieldsC.data() + KIN_ZETA * nw;
+		moordyn::complex* PDynC = fieldsC.data() + KIN_PDYN * nw;
+		moordyn::complex* UCx = fieldsC.data() + KIN_UX * nw;
+		moordyn::complex* UCy = fieldsC.data() + KIN_UY * nw;
+		moordyn::complex* UCz = fieldsC.data() + KIN_UZ * nw;
+		moordyn::complex* UdCx = fieldsC.data() + KIN_AX * nw;
+		moordyn::complex* UdCy = fieldsC.data() + KIN_AY * nw;
+		moordyn::complex* UdCz = fieldsC.data() + KIN_AZ * nw;
+		// iFFT input, output and scratch
+		vector<kiss_fft_cpx> cx_w_in(nw);
+		vector<kiss_fft_scalar> cx_t_out(nFFT);
+		vector<kiss_fft_cpx> cx_tmp(nFFT / 2);
+		// time series of the grid point, on the solver precision
+		kinseries series(KIN_NFIELDS, nFFT);
+
+		const unsigned int p0 = chunk * np / nchunks;
+		const unsigned int p1 = (chunk + 1) * np / nchunks;
+		for (unsigned int p = p0; p < p1; p++) {
+			const unsigned int iz = p % nz;
+			const unsigned int iy = (p / nz) % ny;
+			const unsigned int ix = p / (nz * ny);
+			const real x = px[ix];
+			const real y = py[iy];
 
-	for (unsigned int ix = 0; ix < nx; ix++) {
-		real x = px[ix];
-		for (unsigned int iy = 0; iy < ny; iy++) {
-			real y = py[iy];
 			// wave elevation
 			// handle all (not just positive-frequency half?) of spectrum?
 			for (unsigned int I = 0; I < nw; I++) {
@@ -919,107 +1992,262 @@ Waves::fillWaveGrid(const moordyn::complex* zetaC0,
 				zetaC[I] = zetaC0[I] * exp(-i1 * (k[I] * l));
 			}
 
-			// IFFT the wave elevation spectrum
-			doIFFT(cfg, nFFT, cx_w_in, cx_t_out, zetaC, zeta[ix][iy]);
-
 			// wave velocities and accelerations
-			for (unsigned int iz = 0; iz < nz; iz++) {
-				real z = pz[iz];
-
-				// Loop through the positive frequency components (including
-				// zero) of the Fourier transforms
-				for (unsigned int I = 0; I < nw; I++) {
-					// Calculate
-					//     SINH( k*( z + h ) )/SINH( k*h )
-					//     COSH( k*( z + h ) )/SINH( k*h )
-					//     COSH( k*( z + h ) )/COSH( k*h )
-					real SINHNumOvrSIHNDen;
-					real COSHNumOvrSIHNDen;
-					real COSHNumOvrCOSHDen;
-
-					if (k[I] == 0.0) {
-						// The shallow water formulation is ill-conditioned;
-						// thus, the known value of unity is returned.
-						SINHNumOvrSIHNDen = 1.0;
-						COSHNumOvrSIHNDen = 99999.0;
-						COSHNumOvrCOSHDen = 99999.0;
-					} else if (k[I] * h > 89.4) {
-						// The shallow water formulation will trigger a floating
-						// point overflow error; however, for
-						// h > 14.23 * wavelength (since k = 2 * Pi /
-						// wavelength) we can use the numerically-stable deep
-						// water formulation instead.
-						SINHNumOvrSIHNDen = exp(k[I] * z);
-						COSHNumOvrSIHNDen = exp(k[I] * z);
-						COSHNumOvrCOSHDen =
-						    exp(k[I] * z) + exp(-k[I] * (z + 2.0 * h));
-					} else if (-k[I] * h > 89.4) {
-						// @mth: added negative k case
-						// NOTE: CHECK CORRECTNESS
-						SINHNumOvrSIHNDen = -exp(-k[I] * z);
-						COSHNumOvrSIHNDen = -exp(-k[I] * z);
-						COSHNumOvrCOSHDen =
-						    -exp(-k[I] * z) + exp(-k[I] * (z + 2.0 * h));
-					} else {
-						// shallow water formulation
-						SINHNumOvrSIHNDen =
-						    sinh(k[I] * (z + h)) / sinh(k[I] * h);
-						COSHNumOvrSIHNDen =
-						    cosh(k[I] * (z + h)) / sinh(k[I] * h);
-						COSHNumOvrCOSHDen =
-						    cosh(k[I] * (z + h)) / cosh(k[I] * h);
-					}
-
-					// Fourier transform of dynamic pressure
-					PDynC[I] = rho_w * g * zetaC[I] * COSHNumOvrCOSHDen;
-
-					// Fourier transform of wave velocities
-					// (note: need to multiply by abs(w) to avoid inverting
-					//  negative half of spectrum) <<< ???
-					UCx[I] = w[I] * zetaC[I] * COSHNumOvrSIHNDen * cos(beta);
-					UCy[I] = w[I] * zetaC[I] * COSHNumOvrSIHNDen * sin(beta);
-					UCz[I] = i1 * w[I] * zetaC[I] * SINHNumOvrSIHNDen;
-
-					// Fourier transform of wave accelerations
-					// NOTE: should confirm correct signs of +/- halves of
-					// spectrum here
-					UdCx[I] = i1 * w[I] * UCx[I];
-					UdCy[I] = i1 * w[I] * UCy[I];
-					UdCz[I] = i1 * w[I] * UCz[I];
-				}
+			// Loop through the positive frequency components (including
+			// zero) of the Fourier transforms
+			for (unsigned int I = 0; I < nw; I++) {
+				const unsigned int j = iz * nw + I;
+
+				// Fourier transform of dynamic pressure
+				PDynC[I] = rho_w * g * zetaC[I] * s.COSHNumOvrCOSHDen[j];
+
+				// Fourier transform of wave velocities
+				// (note: need to multiply by abs(w) to avoid inverting
+				//  negative half of spectrum) <<< ???
+				UCx[I] = w[I] * zetaC[I] * s.COSHNumOvrSIHNDen[j] * cos(beta);
+				UCy[I] = w[I] * zetaC[I] * s.COSHNumOvrSIHNDen[j] * sin(beta);
+				UCz[I] = i1 * w[I] * zetaC[I] * s.SINHNumOvrSIHNDen[j];
+
+				// Fourier transform of wave accelerations
+				// NOTE: should confirm correct signs of +/- halves of
+				// spectrum here
+				UdCx[I] = i1 * w[I] * UCx[I];
+				UdCy[I] = i1 * w[I] * UCy[I];
+				UdCz[I] = i1 * w[I] * UCz[I];
+			}
 
-				// NOTE: could handle negative-frequency half of spectrum with
-				// for (int I=nw/2+1; I<nw; I++) <<<
-
-				// IFFT the dynamic pressure
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, PDynC, PDyn[ix][iy][iz]);
-				// IFFT the wave velocities
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UCx, ux[ix][iy][iz]);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UCy, uy[ix][iy][iz]);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UCz, uz[ix][iy][iz]);
-				// IFFT the wave accelerations
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UdCx, ax[ix][iy][iz]);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UdCy, ay[ix][iy][iz]);
-				doIFFT(cfg, nFFT, cx_w_in, cx_t_out, UdCz, az[ix][iy][iz]);
-
-				// NOTE: wave stretching stuff would maybe go here?? <<<
+			// NOTE: could handle negative-frequency half of spectrum with
+			// for (int I=nw/2+1; I<nw; I++) <<<
+
+			// IFFT the wave elevation, the dynamic pressure, the wave
+			// velocities and the wave accelerations
+			for (unsigned int f = 0; f < KIN_NFIELDS; f++) {
+				doIFFT(cfg,
+				       nFFT,
+				       cx_w_in.data(),
+				       cx_t_out.data(),
+				       cx_tmp.data(),
+				       fieldsC.data() + f * nw,
+				       series.data() + f,
+				       KIN_NFIELDS);
 			}
+			sink(ix, iy, iz, series);
+
+			// NOTE: wave stretching stuff would maybe go here?? <<<
 		}
+
+		chunk_time[chunk] = threadTime() - t0;
+	};
+
+	const auto t0 = std::chrono::steady_clock::now();
+	try {
+		pool.Run(nchunks, fill_chunk);
+	} catch (std::bad_alloc&) {
+		free(cfg);
+		LOGERR << "Failure allocating the iFFT buffers" << endl;
+		throw moordyn::mem_error("Insufficient memory");
+	} catch (...) {
+		free(cfg);
+		throw;
 	}
+	const auto t1 = std::chrono::steady_clock::now();
+	free(cfg);
+
+	wall = std::chrono::duration<real>(t1 - t0).count();
+	work = std::accumulate(chunk_time.begin(), chunk_time.end(), real(0.0));
+}
 
-	free(cx_w_in);
-	free(cx_t_out);
+void
+Waves::fillWaveGrid(const moordyn::complex* zetaC0,
+                    unsigned int nw,
+                    real dw,
+                    real g,
+                    real h)
+{
+	// The number of wave time steps to be calculated
+	nt = 2 * (nw - 1);
+
+	LOGMSG << "Wave frequencies from " << 0.0 << " rad/s to "
+	       << (nw - 1) * dw << " rad/s in increments of " << dw << " rad/s"
+	       << endl;
+	synthesis s;
+	makeSynthesis(nw, dw, g, h, s);
+
+	LOGDBG << "   nt = " << nt << ", h = " << h << endl;
+
+	// precalculates wave kinematics for a given set of node points for a series
+	// of time steps
+	LOGDBG << "Making wave Kinematics (iFFT)..." << endl;
+
+	real wall, work;
+	synthGrid(
+	    s,
+	    zetaC0,
+	    [this](unsigned int ix,
+	           unsigned int iy,
+	           unsigned int iz,
+	           const kinseries& series) { storeSeries(ix, iy, iz, series); },
+	    wall,
+	    work);
+
+	const unsigned int np = nx * ny * nz;
+	const unsigned int nchunks =
+	    std::min(_t_integrator ? _t_integrator->GetThreads() : 1, np);
+	LOGMSG << "Wave grid of " << np << " points x " << nt
+	       << " time steps computed in " << wall << " s with " << nchunks
+	       << " threads (x" << (wall > 0.0 ? work / wall : 1.0)
+	       << " speedup over the " << work << " s of serial work)" << endl;
+}
+
+void
+Waves::setupStream(const std::vector<real>& zeta,
+                   real window,
+                   real h,
+                   const char* filepath)
+{
+	stream = true;
+	stream_zeta = zeta;
+	stream_hop = (std::max)(1, (int)round(0.5 * window / dtWave));
+	const unsigned int nfft = 4 * stream_hop;
+	const unsigned int nw = nfft / 2 + 1;
+	const real dw = 2.0 * pi / (nfft * dtWave);
+
+	// Just the blocks being used are kept in memory
+	nt = STREAM_BLOCKS * stream_hop;
+	if (kin_prec == WAVES_PREC_FIXED16) {
+		LOGWRN << "The streamed waves grid cannot be stored in fixed point, "
+		       << "using single precision instead" << endl;
+		kin_prec = WAVES_PREC_FLOAT;
+	}
+	makeGrid(filepath);
+	makeSynthesis(nw, dw, g, h, stream_synth);
+	const unsigned int np = nx * ny * nz;
+	try {
+		stream_acc.setZero(KIN_NFIELDS, STREAM_BLOCKS * stream_hop * np);
+	} catch (std::bad_alloc&) {
+		LOGERR << "Failure allocating "
+		       << KIN_NFIELDS * nt * np * sizeof(real)
+		       << " bytes for the waves streaming windows" << endl;
+		throw moordyn::mem_error("Insufficient memory");
+	}
+	stream_first = std::numeric_limits<long>::max();
+	stream_last = stream_first;
+
+	LOGMSG << "Wave grid of " << np << " points streamed in windows of "
+	       << 2 * stream_hop << " time steps, keeping " << nt
+	       << " time steps in memory (plus the overlap-add ones) instead of "
+	       << zeta.size() << endl;
+}
+
+void
+Waves::streamWindow()
+{
+	const long H = stream_hop;
+	const long nb = STREAM_BLOCKS;
+	const unsigned int nfft = 4 * H;
+	const unsigned int nw = nfft / 2 + 1;
+	const unsigned int np = nx * ny * nz;
+	const long n = stream_zeta.size();
+	const long k = stream_last + 2;
+
+	// Hann window, which adds up to one when overlapped half of its length.
+	// It is placed at the middle of the FFT buffer, so the kinematics can
+	// spread on the zero padding at both sides without wrapping around
+	vector<kiss_fft_scalar> zeta(nfft, 0.0);
+	for (long m = 0; m < 2 * H; m++) {
+		// The wave elevation time series is periodic
+		const long j = ((k * H + m) % n + n) % n;
+		const real hann = sin(pi * m / (2 * H));
+		zeta[H + m] = hann * hann * stream_zeta[j];
+	}
+	kiss_fftr_cfg cfg = kiss_fftr_alloc(nfft, 0, NULL, NULL);
+	if (!cfg) {
+		LOGERR << "Failure allocating the FFT plan" << endl;
+		throw moordyn::mem_error("Insufficient memory");
+	}
+	vector<kiss_fft_cpx> zetaF(nw);
+	kiss_fftr(cfg, zeta.data(), zetaF.data());
 	free(cfg);
-	free(zetaC);
-	free(PDynC);
-	free(UCx);
-	free(UCy);
-	free(UCz);
-	free(UdCx);
-	free(UdCy);
-	free(UdCz);
-
-	LOGDBG << "Done!" << endl;
+	// cut frequencies above 0.5 Hz, as in the whole time series grid
+	vector<moordyn::complex> zetaC0(nw, 0.0);
+	for (unsigned int I = 0; I < nw; I++)
+		if (stream_synth.w[I] <= 0.5 * 2 * pi)
+			zetaC0[I] = (real)zetaF[I].r + i1 * (real)zetaF[I].i;
+
+	// The window spans 4 blocks, from k - 1 to k + 2. The accumulated blocks
+	// are stored on the same slots than the finished ones
+	real wall, work;
+	synthGrid(
+	    stream_synth,
+	    zetaC0.data(),
+	    [&](unsigned int ix,
+	        unsigned int iy,
+	        unsigned int iz,
+	        const kinseries& series) {
+		    const unsigned int p = gridIndex(ix, iy, iz, 0);
+		    for (long m = 0; m < 4 * H; m++) {
+			    const long slot = ((k - 1 + m / H) % nb + nb) % nb;
+			    stream_acc.col((slot * H + m % H) * np + p) += series.col(m);
+		    }
+	    },
+	    wall,
+	    work);
+
+	// So the first block is done
+	const long b = k - 1;
+	const long slot = (b % nb + nb) % nb;
+	auto block = stream_acc.middleCols(slot * H * np, H * np);
+	if (kin_prec == WAVES_PREC_FLOAT)
+		kin_f.middleCols(slot * H * np, H * np) = block.cast<float>();
+	else
+		kin.middleCols(slot * H * np, H * np) = block;
+	block.setZero();
+	stream_last = b;
+
+	LOGDBG << "Wave window " << k << " computed in " << wall << " s" << endl;
+}
+
+void
+Waves::streamRestart(long b)
+{
+	stream_acc.setZero();
+	// The blocks before b are missing some windows
+	stream_first = b;
+	stream_last = b - STREAM_BLOCKS;
+	for (unsigned int i = 0; i < STREAM_BLOCKS; i++)
+		streamWindow();
+}
+
+void
+Waves::streamBlocks(real t, long& b0, long& b1) const
+{
+	// Blocks of the time steps used to interpolate, see timeFactor()
+	const long H = stream_hop;
+	const long j = (long)floor(t / dtWave) + 1;
+	b0 = (j - 1 >= 0) ? (j - 1) / H : -((H - j) / H);
+	b1 = (j >= 0) ? j / H : -((H - 1 - j) / H);
+}
+
+void
+Waves::streamTo(real t)
+{
+	if (stream_job.valid())
+		stream_job.get();
+
+	const long nb = STREAM_BLOCKS;
+	long b0, b1;
+	streamBlocks(t, b0, b1);
+	if ((b0 < stream_first) || (b0 + nb <= stream_last) ||
+	    (b1 > stream_last + nb))
+		streamRestart(b0);
+	while (stream_last < b1)
+		streamWindow();
+
+	// Prepare the next block in background while the current ones are used
+	if (stream_last == b1)
+		stream_job = std::async(std::launch::async, [this]() {
+			streamWindow();
+		});
 }
 
 } // ::moordyn
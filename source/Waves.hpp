@@ -37,6 +37,9 @@
 #include "Misc.hpp"
 #include "Log.hpp"
 #include "Time.hpp"
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <vector>
 
 namespace moordyn {
@@ -70,6 +73,8 @@ class Waves : public LogUser
 	 *   - Defining the list of coordinates
 	 *   - Defining the boundaries and the number of equispaced points
 	 *
+	 * If the grid has been fitted to the mooring, see fitGrid(), the file is
+	 * not read, and just the memory is allocated
 	 * @param filepath The definition file path
 	 * @throws moordyn::input_file_error If the input file cannot be read, or if
 	 * the fileis ill-formatted
@@ -78,6 +83,18 @@ class Waves : public LogUser
 	 */
 	void makeGrid(const char* filepath = "Mooring/water_grid.txt");
 
+	/** @brief Fit the grid to the mooring footprint
+	 *
+	 * The horizontal lattice spans the bounding box of the lines and rods
+	 * nodes, and the bodies, plus a margin. The depths are concentrated near
+	 * the free surface, where the waves kinematics change faster. The memory
+	 * is not allocated, makeGrid() shall be called afterwards
+	 * @param env The enviromental options
+	 * @throws moordyn::invalid_value_error If there are no nodes to fit the
+	 * grid to
+	 */
+	void fitGrid(const EnvCond* env);
+
 	/** @brief Allocate the needed memory for the kinematics storage
 	 * @param filepath The definition file path. If NULL or "" isprovided, then
 	 * "Mooring/water_grid.txt" is considered
@@ -86,6 +103,56 @@ class Waves : public LogUser
 	 */
 	void allocateKinematicsArrays();
 
+	/** @brief Size of the kinematics storage
+	 *
+	 * The storage is a single memory block, with the grid data of the given
+	 * precision. On WAVES_PREC_FIXED16 the scale factors come afterwards
+	 * @param prec The storage precision
+	 * @param np The number of grid points
+	 * @param nt The number of time steps
+	 * @return The number of bytes
+	 */
+	static size_t kinBytes(waves_precision prec, size_t np, size_t nt);
+
+	/** @brief Point the kinematics storage to a memory block
+	 * @param data The memory block, see kinBytes(). NULL to point to nothing
+	 */
+	void bindKin(uint8_t* data);
+
+	/** @brief Release the kinematics storage, either allocated or mapped
+	 */
+	void releaseKin();
+
+	/** @brief Hash of all the inputs the waves grid depends on
+	 *
+	 * The fitted grid, see fitGrid(), shall be already computed
+	 * @param env The enviromental options
+	 * @param folder The root folder where the wave data can be found
+	 * @return The hash
+	 */
+	uint64_t cacheKey(const EnvCond* env, const char* folder) const;
+
+	/** @brief Map the kinematics grid from a cache file
+	 *
+	 * The file is mapped read-only and shared, so several processes using the
+	 * same cache share the physical memory
+	 * @param filepath The cache file path
+	 * @param key The inputs hash, see cacheKey()
+	 * @return true if the grid has been mapped, false if there is no
+	 * valid cache file
+	 */
+	bool loadCache(const std::string& filepath, uint64_t key);
+
+	/** @brief Write the kinematics grid into a cache file
+	 *
+	 * The file is written in a temporal file which replaces the cache file
+	 * afterwards, so the concurrent processes never find incomplete files
+	 * @param filepath The cache file path
+	 * @param key The inputs hash, see cacheKey()
+	 * @return true if the cache has been written, false otherwise
+	 */
+	bool saveCache(const std::string& filepath, uint64_t key) const;
+
 	/** @brief instantiator that takes discrete wave elevation fft data only
 	 * (MORE RECENT)
 	 * @param zetaC0 Amplitude of each frequency component
@@ -101,6 +168,42 @@ class Waves : public LogUser
 	                  real g,
 	                  real h);
 
+	/** @brief Keep the spectral components of the waves
+	 *
+	 * Used if WaveKin = WAVES_SPECTRAL, instead of filling a grid
+	 * @param zetaC0 Amplitude of each frequency component, as returned by
+	 * the real FFT of the wave elevation time series
+	 * @param nw Number of wave components
+	 * @param nFFT Number of samples of the wave elevation time series
+	 * @param h Water depth
+	 */
+	void makeSpectrum(const moordyn::complex* zetaC0,
+	                  unsigned int nw,
+	                  unsigned int nFFT,
+	                  real h);
+
+	/** @brief Add the spectral components contribution at a point
+	 *
+	 * The phases set on setTime() are rotated by \p dt, so the time of the
+	 * query can be other than the one set on setTime()
+	 * @param x The point x coordinate
+	 * @param y The point y coordinate
+	 * @param z The point z coordinate
+	 * @param dt The query time minus the one set on setTime()
+	 * @param U_out The velocity to add to
+	 * @param Ud_out The acceleration to add to
+	 * @param zeta_out The wave height to add to
+	 * @param PDyn_out The dynamic pressure to add to
+	 */
+	void spectralKin(real x,
+	                 real y,
+	                 real z,
+	                 real dt,
+	                 vec& U_out,
+	                 vec& Ud_out,
+	                 real& zeta_out,
+	                 real& PDyn_out) const;
+
 	/** @brief Make a 2-D data grid
 	 * @param nx Number of components in the first dimension
 	 * @param ny Number of components in the second dimension
@@ -111,38 +214,295 @@ class Waves : public LogUser
 		return std::vector<std::vector<real>>(nx, std::vector<real>(ny, 0.0));
 	}
 
-	/** @brief Make a 3-D data grid
-	 * @param nx Number of components in the first dimension
-	 * @param ny Number of components in the second dimension
-	 * @param nz Number of components in the third dimension
+	/** @brief One-dimensional interpolation factor on a grid axis
+	 *
+	 * On equispaced axes the cell is computed straight away. Otherwise the
+	 * cell is looked for starting from \p i0, which can be moved backwards
+	 * @param p The axis coordinates
+	 * @param dp The axis spacing if the points are equispaced, 0 otherwise
+	 * @param i0 The upper bound index found on a previous query, used as a
+	 * search hint
+	 * @param x The evaluation point
+	 * @param f The interpolation factor
+	 * @return The index of the upper bound
+	 * @see interp_factor
+	 */
+	static unsigned int axisFactor(const std::vector<real>& p,
+	                               real dp,
+	                               unsigned int i0,
+	                               real x,
+	                               real& f);
+
+	/** @brief Time interpolation factor
+	 * @param t The simulation time
+	 * @param ft The interpolation factor
+	 * @return The index of the upper bound
+	 */
+	unsigned int timeFactor(real t, real& ft) const;
+
+	/** @brief Time interpolation factor on a periodic time series
+	 * @param t The simulation time
+	 * @param dt The time step of the time series
+	 * @param n The number of time steps of the time series
+	 * @param ft The interpolation factor
+	 * @return The index of the upper bound
+	 */
+	static unsigned int timeFactor(real t,
+	                               real dt,
+	                               unsigned int n,
+	                               real& ft);
+
+	/** @brief Build the uniform index of the currents profile depths
+	 *
+	 * The profile depths are split in bins of the same size, each one
+	 * pointing to the first depth at or above it, see profileFactor()
 	 */
-	static inline std::vector<std::vector<std::vector<real>>>
-	init3DArray(unsigned int nx, unsigned int ny, unsigned int nz)
+	void makeProfileIndex();
+
+	/** @brief Depth interpolation factor on the currents profile
+	 *
+	 * The uniform index built by makeProfileIndex() is used, so the lookup
+	 * costs O(1). The result is the one of interp_factor()
+	 * @param z The evaluation depth
+	 * @param f The interpolation factor
+	 * @return The index of the upper bound
+	 */
+	unsigned int profileFactor(real z, real& f) const;
+
+	/** @brief Get the kinematics at a point
+	 *
+	 * The data prepared on setTime() is used if \p t is the time set there.
+	 * Otherwise everything is interpolated in time on the fly, which is
+	 * slower but does not modify the object, so it can be called from
+	 * several threads at once
+	 * @param x The point x coordinate
+	 * @param y The point y coordinate
+	 * @param z The point z coordinate
+	 * @param t The simulation time
+	 * @param cell The upper bound grid indexes found on a previous query,
+	 * used as search hint. It is updated with the new indexes
+	 * @param U_out The output velocity
+	 * @param Ud_out The output acceleration
+	 * @param zeta_out The output wave height
+	 * @param PDyn_out The output dynamic pressure
+	 */
+	void pointKin(real x,
+	              real y,
+	              real z,
+	              real t,
+	              ivec& cell,
+	              vec& U_out,
+	              vec& Ud_out,
+	              real& zeta_out,
+	              real& PDyn_out) const;
+
+	/** @brief Linear index of a grid point on the kinematics storage
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param it The time index
+	 * @return The column of ::kin where the point data is stored
+	 */
+	inline unsigned int gridIndex(unsigned int ix,
+	                              unsigned int iy,
+	                              unsigned int iz,
+	                              unsigned int it) const
 	{
-		return std::vector<std::vector<std::vector<real>>>(
-		    nx, std::vector<std::vector<real>>(ny, std::vector<real>(nz, 0.0)));
+		return ((it * nx + ix) * ny + iy) * nz + iz;
 	}
 
-	/** @brief Make a 4-D data grid
-	 * @param nx Number of components in the first dimension
-	 * @param ny Number of components in the second dimension
-	 * @param nz Number of components in the third dimension
-	 * @param nw Number of components in the third dimension
-	 */
-	static inline std::vector<std::vector<std::vector<std::vector<real>>>>
-	init4DArray(unsigned int nx,
-	            unsigned int ny,
-	            unsigned int nz,
-	            unsigned int nw)
+	/// Time series of all the fields at a grid point [field,t]
+	typedef Eigen::Matrix<real, 8, Eigen::Dynamic> kinseries;
+
+	/** @brief Get the time series of all the fields at a grid point
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param s The time series, resized to ::nt time steps
+	 */
+	void loadSeries(unsigned int ix,
+	                unsigned int iy,
+	                unsigned int iz,
+	                kinseries& s) const;
+
+	/** @brief Set the time series of all the fields at a grid point
+	 *
+	 * The time series is converted to the storage precision, see ::kin_prec.
+	 * Different grid points can be concurrently set
+	 * @param ix The x index
+	 * @param iy The y index
+	 * @param iz The z index
+	 * @param s The time series, with ::nt time steps
+	 */
+	void storeSeries(unsigned int ix,
+	                 unsigned int iy,
+	                 unsigned int iz,
+	                 const kinseries& s);
+
+	/// Frequency domain data to synthesize the grid time series
+	struct synthesis
+	{
+		/// Number of frequency components
+		unsigned int nw;
+		/// Circular frequencies
+		std::vector<real> w;
+		/// Wave numbers
+		std::vector<real> k;
+		/// SINH(k*(z+h))/SINH(k*h) for each z coordinate and frequency
+		std::vector<real> SINHNumOvrSIHNDen;
+		/// COSH(k*(z+h))/SINH(k*h) for each z coordinate and frequency
+		std::vector<real> COSHNumOvrSIHNDen;
+		/// COSH(k*(z+h))/COSH(k*h) for each z coordinate and frequency
+		std::vector<real> COSHNumOvrCOSHDen;
+	};
+
+	/** @brief Compute the frequency domain data to synthesize the grid
+	 * @param nw Number of wave components
+	 * @param dw The difference in frequency between consequtive modes
+	 * @param g Gravity accelerations
+	 * @param h Water depth
+	 * @param s The synthesis data
+	 */
+	void makeSynthesis(unsigned int nw,
+	                   real dw,
+	                   real g,
+	                   real h,
+	                   synthesis& s) const;
+
+	/** @brief Compute the time series of every grid point by iFFT
+	 *
+	 * The grid points are split among the time scheme threads
+	 * @param s The synthesis data, see makeSynthesis()
+	 * @param zetaC0 Amplitude of each frequency component
+	 * @param sink Function receiving the time series of each grid point,
+	 * with 2 * (nw - 1) time steps. It is concurrently called for different
+	 * points
+	 * @param wall The elapsed time
+	 * @param work The accumulated time of all the threads
+	 * @throws moordyn::mem_error If there were roblems allocating memory
+	 */
+	void synthGrid(const synthesis& s,
+	               const moordyn::complex* zetaC0,
+	               std::function<void(unsigned int,
+	                                  unsigned int,
+	                                  unsigned int,
+	                                  const kinseries&)> sink,
+	               real& wall,
+	               real& work) const;
+
+	/** @brief Setup the streamed wave kinematics grid
+	 *
+	 * Instead of the whole time series, just ::STREAM_BLOCKS blocks of half
+	 * a window are kept in memory, see streamWindow()
+	 * @param zeta The wave elevation time series, sampled at ::dtWave
+	 * @param window The synthesis window length
+	 * @param h Water depth
+	 * @param filepath The grid definition file path, see makeGrid()
+	 * @throws moordyn::mem_error If there were roblems allocating memory
+	 */
+	void setupStream(const std::vector<real>& zeta,
+	                 real window,
+	                 real h,
+	                 const char* filepath);
+
+	/** @brief Synthesize the next window of the streamed grid
+	 *
+	 * The windows are Hann weighted and overlap half of their length, so
+	 * they are overlap-added block by block. The window starting on the
+	 * block ::stream_last + 2 is synthesized, completing the block
+	 * ::stream_last + 1, which is moved to the grid
+	 * @throws moordyn::mem_error If there were roblems allocating memory
+	 */
+	void streamWindow();
+
+	/** @brief Synthesize the streamed grid from scratch
+	 * @param b The first block to become available
+	 */
+	void streamRestart(long b);
+
+	/** @brief Get the streamed grid blocks used to interpolate at a time
+	 * @param t The simulation time
+	 * @param b0 The block of the lower bound time step
+	 * @param b1 The block of the upper bound time step
+	 */
+	void streamBlocks(real t, long& b0, long& b1) const;
+
+	/** @brief Make the streamed grid blocks required at a time available
+	 *
+	 * Afterwards the next window is synthesized on the background
+	 * @param t The simulation time
+	 */
+	void streamTo(real t);
+
+	/** @brief Whether there is a kinematics grid, whatever its precision
+	 * @return true if the grid has been allocated, false otherwise
+	 */
+	inline bool hasGrid() const
 	{
-		return std::vector<std::vector<std::vector<std::vector<real>>>>(
-		    nx,
-		    std::vector<std::vector<std::vector<real>>>(
-		        ny,
-		        std::vector<std::vector<real>>(nz,
-		                                       std::vector<real>(nw, 0.0))));
+		return kin.cols() || kin_f.cols() || kin_q.cols();
 	}
 
+	/** @brief Get all the fields of a grid point on the solver precision
+	 * @param p The grid point index, i.e. gridIndex() at the time 0
+	 * @param it The time index
+	 * @return The stored fields
+	 */
+	inline Eigen::Matrix<real, 8, 1> kinCol(unsigned int p,
+	                                        unsigned int it) const
+	{
+		const unsigned int n = it * nx * ny * nz + p;
+		switch (kin_prec) {
+			case WAVES_PREC_FLOAT:
+				return kin_f.col(n).cast<real>();
+			case WAVES_PREC_FIXED16:
+				return kin_q.col(n).cast<real>().cwiseProduct(
+				    kin_scale.col(p).cast<real>());
+			default:
+				return kin.col(n);
+		}
+	}
+
+	/** @brief Quadrilinear interpolation of all the kinematic fields at once
+	 *
+	 * The 16 corners of the space-time stencil are fetched as whole columns
+	 * of the grid, so all the fields are interpolated on the same pass
+	 * @param ix The upper bound index in the x direction
+	 * @param iy The upper bound index in the y direction
+	 * @param iz The upper bound index in the z direction
+	 * @param it The upper bound index in time
+	 * @param fx The linear interplation factor in the x direction
+	 * @param fy The linear interplation factor in the y direction
+	 * @param fz The linear interplation factor in the z direction
+	 * @param ft The linear interplation factor in time
+	 * @return The interpolated fields
+	 * @see interp_factor
+	 */
+	Eigen::Matrix<real, 8, 1> interpKin(unsigned int ix,
+	                                    unsigned int iy,
+	                                    unsigned int iz,
+	                                    unsigned int it,
+	                                    real fx,
+	                                    real fy,
+	                                    real fz,
+	                                    real ft) const;
+
+	/** @brief Trilinear interpolation of all the kinematic fields on ::slab
+	 * @param ix The upper bound index in the x direction
+	 * @param iy The upper bound index in the y direction
+	 * @param iz The upper bound index in the z direction
+	 * @param fx The linear interplation factor in the x direction
+	 * @param fy The linear interplation factor in the y direction
+	 * @param fz The linear interplation factor in the z direction
+	 * @return The interpolated fields
+	 * @see interp_factor
+	 */
+	Eigen::Matrix<real, 8, 1> interpSlab(unsigned int ix,
+	                                     unsigned int iy,
+	                                     unsigned int iz,
+	                                     real fx,
+	                                     real fy,
+	                                     real fz) const;
+
 	/// number of grid points in x direction
 	unsigned int nx;
 	/// number of grid points in y direction
@@ -160,22 +520,177 @@ class Waves : public LogUser
 	std::vector<real> py;
 	/// grid z coordinate arrays
 	std::vector<real> pz;
-	/// wave elevation [x,y,t]
-	vector<vector<vector<real>>> zeta;
-	/// dynamic pressure [x,y,z,t]
-	vector<vector<vector<vector<real>>>> PDyn;
-	/// wave velocity x component [x,y,z,t]
-	vector<vector<vector<vector<real>>>> ux;
-	/// wave velocity y component [x,y,z,t]
-	vector<vector<vector<vector<real>>>> uy;
-	/// wave velocity z component [x,y,z,t]
-	vector<vector<vector<vector<real>>>> uz;
-	/// wave acceleration x component [x,y,z,t]
-	vector<vector<vector<vector<real>>>> ax;
-	/// wave acceleration y component [x,y,z,t]
-	vector<vector<vector<vector<real>>>> ay;
-	/// wave acceleration z component [x,y,z,t]
-	vector<vector<vector<vector<real>>>> az;
+	/// grid x spacing if the points are equispaced, 0 otherwise
+	real dpx;
+	/// grid y spacing if the points are equispaced, 0 otherwise
+	real dpy;
+	/// grid z spacing if the points are equispaced, 0 otherwise
+	real dpz;
+
+	/** @brief Fields stored on each grid point
+	 */
+	typedef enum
+	{
+		/// Wave elevation
+		KIN_ZETA = 0,
+		/// Dynamic pressure
+		KIN_PDYN = 1,
+		/// Wave velocity x component
+		KIN_UX = 2,
+		/// Wave velocity y component
+		KIN_UY = 3,
+		/// Wave velocity z component
+		KIN_UZ = 4,
+		/// Wave acceleration x component
+		KIN_AX = 5,
+		/// Wave acceleration y component
+		KIN_AY = 6,
+		/// Wave acceleration z component
+		KIN_AZ = 7,
+		/// Number of fields
+		KIN_NFIELDS = 8,
+	} kinfields;
+
+	/** @brief View of the wave kinematics storage
+	 *
+	 * The storage is either owned, see ::kin_mem, or mapped from a cache
+	 * file, see ::kin_map
+	 */
+	template<typename T>
+	using kinmap = Eigen::Map<Eigen::Matrix<T, KIN_NFIELDS, Eigen::Dynamic>>;
+
+	/** @brief Wave kinematics [t,x,y,z,field]
+	 *
+	 * Each column holds the ::kinfields of a grid point, so the data required
+	 * to interpolate at a point is fetched at once. The columns are sorted
+	 * by time, then x, y and z, see gridIndex(). The wave elevation is
+	 * repeated on every z point
+	 */
+	kinmap<real> kin;
+	/// Precision of the stored wave kinematics
+	waves_precision kin_prec;
+	/// Wave kinematics if ::kin_prec is WAVES_PREC_FLOAT, see ::kin
+	kinmap<float> kin_f;
+	/** @brief Wave kinematics if ::kin_prec is WAVES_PREC_FIXED16, see ::kin
+	 *
+	 * The values are the fraction of the largest magnitude of each field
+	 * along the time series of each grid point, see ::kin_scale
+	 */
+	kinmap<int16_t> kin_q;
+	/// Scale factor of ::kin_q for each field and grid point [x,y,z,field]
+	kinmap<float> kin_scale;
+	/// Memory holding the wave kinematics, unless they are mapped
+	std::vector<uint8_t> kin_mem;
+	/// Cache file mapped in memory holding the wave kinematics, if any
+	void* kin_map;
+	/// Size of ::kin_map
+	size_t kin_map_size;
+
+	/// Whether the grid is fitted to the mooring, see fitGrid()
+	bool grid_fit;
+
+	/// Time set on the last call to setTime()
+	real wave_t;
+
+	/// Time of the queries, see setTime()
+	real kin_t;
+	/// Upper bound time index at ::kin_t
+	unsigned int kin_it;
+	/// Time interpolation factor at ::kin_t
+	real kin_ft;
+
+	/** @brief Depths of the currents profile
+	 *
+	 * The currents only depend on the depth and the time, so they are not
+	 * stored in the waves grid. Empty if there are no currents
+	 */
+	std::vector<real> cur_z;
+	/// Number of time steps of the currents profile
+	unsigned int cur_nt;
+	/// Time step of the currents profile
+	real cur_dt;
+	/// Currents velocity [t,z]
+	Eigen::Matrix<real, 3, Eigen::Dynamic> cur_u;
+	/// Time at which ::cur_slab is interpolated
+	real cur_t;
+	/// Currents velocity interpolated at ::cur_t [z]
+	Eigen::Matrix<real, 3, Eigen::Dynamic> cur_slab;
+	/// Size of the uniform bins of ::cur_zbin
+	real cur_dzbin;
+	/// First profile depth index at or above each uniform bin
+	std::vector<unsigned int> cur_zbin;
+	/** @brief Wave kinematics interpolated at ::kin_t [x,y,z,field]
+	 *
+	 * Empty if it was not worth building it, see setTime()
+	 */
+	Eigen::Matrix<real, KIN_NFIELDS, Eigen::Dynamic> slab;
+
+	/// Array of spectral components data
+	typedef Eigen::Array<real, Eigen::Dynamic, 1> arrayN;
+	/// Number of spectral components summed at once, see spectralKin()
+	static constexpr unsigned int SPEC_BLOCK = 16;
+	/// Number of incremental phase updates before recomputing them
+	static constexpr unsigned int SPEC_RESYNC = 1024;
+	/// Whether the spectral components are used, see WAVES_SPECTRAL
+	bool spectral;
+	/// Water depth
+	real depth;
+	/// Mean wave elevation, i.e. the null frequency component
+	real spec_zeta0;
+	/** @brief Spectral components complex amplitude, real part
+	 *
+	 * All the spectral components arrays are padded with null components up
+	 * to a multiple of ::SPEC_BLOCK
+	 */
+	arrayN spec_ar;
+	/// Spectral components complex amplitude, imaginary part
+	arrayN spec_ai;
+	/// Spectral components circular frequency
+	arrayN spec_w;
+	/// Spectral components wave number
+	arrayN spec_k;
+	/// Spectral components direction cosine
+	arrayN spec_cb;
+	/// Spectral components direction sine
+	arrayN spec_sb;
+	/// 1 / (1 - exp(-2 k h)) for each spectral component
+	arrayN spec_d1;
+	/// 1 / (1 + exp(-2 k h)) for each spectral component
+	arrayN spec_d2;
+	/// Time at which ::spec_c and ::spec_s are computed
+	real spec_t;
+	/// cos(w t) for each spectral component
+	arrayN spec_c;
+	/// sin(w t) for each spectral component
+	arrayN spec_s;
+	/// Time increment of ::spec_cdt and ::spec_sdt
+	real spec_dt;
+	/// cos(w dt) for each spectral component
+	arrayN spec_cdt;
+	/// sin(w dt) for each spectral component
+	arrayN spec_sdt;
+	/// Number of incremental updates since ::spec_c and ::spec_s were
+	/// computed from scratch
+	unsigned int spec_nrot;
+
+	/// Number of time steps blocks kept on the streamed grid
+	static constexpr unsigned int STREAM_BLOCKS = 4;
+	/// Whether the grid is streamed, see setupStream()
+	bool stream;
+	/// Number of time steps of each streamed block, i.e. half window
+	unsigned int stream_hop;
+	/// Wave elevation time series to stream
+	std::vector<real> stream_zeta;
+	/// Frequency domain data of the streamed windows
+	synthesis stream_synth;
+	/// Overlap-add accumulator of the ::STREAM_BLOCKS incoming blocks
+	kinseries stream_acc;
+	/// Last block moved to the grid
+	long stream_last;
+	/// First block moved to the grid since the last restart
+	long stream_first;
+	/// Background synthesis of the next window
+	std::future<void> stream_job;
 
 	/// gravity acceleration
 	real g;
@@ -226,8 +741,19 @@ class Waves : public LogUser
 	 */
 	void setup(EnvCond* env, TimeScheme* t, const char* folder = "Mooring/");
 
+	/** @brief Set the time of the following queries
+	 *
+	 * The kinematics are frozen at this time until the next call. If there
+	 * are enough points to query, the grid is interpolated in time just
+	 * once, building a 3-D slab. Then every query is just a trilinear
+	 * interpolation in space
+	 * @param t The simulation time
+	 * @param n The number of points expected to be queried at this time
+	 */
+	void setTime(real t, unsigned int n);
+
 	/** @brief Get the velocity, acceleration, wave height and dynamic pressure
-	 * at a specific positon and time
+	 * at a specific positon, at the time set on setTime()
 	 * @param x The point x coordinate
 	 * @param y The point y coordinate
 	 * @param z The point z coordinate
@@ -243,6 +769,71 @@ class Waves : public LogUser
 	                vec& Ud_out,
 	                real& zeta_out,
 	                real& PDyn_out);
+
+	/** @brief Get the kinematics at all the nodes of a line
+	 *
+	 * The time interpolation factor is computed just once. On top of that,
+	 * the grid cell of each node is kept in \p cells, and used as the
+	 * starting point on the following query
+	 * @param r The nodes positions
+	 * @param U_out The output velocities
+	 * @param Ud_out The output accelerations
+	 * @param zeta_out The output wave heights
+	 * @param PDyn_out The output dynamic pressures
+	 * @param cells The grid cells of each node on the previous query. It is
+	 * resized if it does not match the number of nodes
+	 */
+	void getWaveKin(const vec3N& r,
+	                vec3N& U_out,
+	                vec3N& Ud_out,
+	                vecN& zeta_out,
+	                vecN& PDyn_out,
+	                std::vector<ivec>& cells);
+
+	/** @brief Get the kinematics at all the nodes of a line at a time other
+	 * than the one set on setTime()
+	 *
+	 * This is meant for the entities integrated with their own time steps,
+	 * within the last outer time step. Nothing is modified but \p cells,
+	 * so several threads can query at once
+	 * @param r The nodes positions
+	 * @param U_out The output velocities
+	 * @param Ud_out The output accelerations
+	 * @param zeta_out The output wave heights
+	 * @param PDyn_out The output dynamic pressures
+	 * @param cells The grid cells of each node on the previous query. It is
+	 * resized if it does not match the number of nodes
+	 * @param t The simulation time
+	 * @throws moordyn::invalid_value_error If the waves grid is streamed and
+	 * \p t is not within the blocks in memory
+	 * @see getWaveKin(const vec3N&, vec3N&, vec3N&, vecN&, vecN&,
+	 * std::vector<ivec>&)
+	 */
+	void getWaveKin(const vec3N& r,
+	                vec3N& U_out,
+	                vec3N& Ud_out,
+	                vecN& zeta_out,
+	                vecN& PDyn_out,
+	                std::vector<ivec>& cells,
+	                real t) const;
+
+	/** @brief Get the kinematics at all the nodes of a rod
+	 * @param r The nodes positions
+	 * @param U_out The output velocities
+	 * @param Ud_out The output accelerations
+	 * @param zeta_out The output wave heights
+	 * @param PDyn_out The output dynamic pressures
+	 * @param cells The grid cells of each node on the previous query. It is
+	 * resized if it does not match the number of nodes
+	 * @see getWaveKin(const vec3N&, vec3N&, vec3N&, vecN&, vecN&,
+	 * std::vector<ivec>&)
+	 */
+	void getWaveKin(const std::vector<vec>& r,
+	                std::vector<vec>& U_out,
+	                std::vector<vec>& Ud_out,
+	                std::vector<real>& zeta_out,
+	                std::vector<real>& PDyn_out,
+	                std::vector<ivec>& cells);
 };
 
 // other relevant functions being thrown into this file for now (should move to
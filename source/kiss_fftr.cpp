@@ -125,6 +125,15 @@ void
 kiss_fftri(kiss_fftr_cfg st,
            const kiss_fft_cpx* freqdata,
            kiss_fft_scalar* timedata)
+{
+	kiss_fftri_buf(st, freqdata, timedata, st->tmpbuf);
+}
+
+void
+kiss_fftri_buf(kiss_fftr_cfg st,
+               const kiss_fft_cpx* freqdata,
+               kiss_fft_scalar* timedata,
+               kiss_fft_cpx* tmpbuf)
 {
 	/* input buffer timedata is stored row-wise */
 	int k, ncfft;
@@ -136,9 +145,9 @@ kiss_fftri(kiss_fftr_cfg st,
 
 	ncfft = st->substate->nfft;
 
-	st->tmpbuf[0].r = freqdata[0].r + freqdata[ncfft].r;
-	st->tmpbuf[0].i = freqdata[0].r - freqdata[ncfft].r;
-	C_FIXDIV(st->tmpbuf[0], 2);
+	tmpbuf[0].r = freqdata[0].r + freqdata[ncfft].r;
+	tmpbuf[0].i = freqdata[0].r - freqdata[ncfft].r;
+	C_FIXDIV(tmpbuf[0], 2);
 
 	for (k = 1; k <= ncfft / 2; ++k) {
 		kiss_fft_cpx fk, fnkc, fek, fok, tmp;
@@ -151,13 +160,13 @@ kiss_fftri(kiss_fftr_cfg st,
 		C_ADD(fek, fk, fnkc);
 		C_SUB(tmp, fk, fnkc);
 		C_MUL(fok, tmp, st->super_twiddles[k - 1]);
-		C_ADD(st->tmpbuf[k], fek, fok);
-		C_SUB(st->tmpbuf[ncfft - k], fek, fok);
+		C_ADD(tmpbuf[k], fek, fok);
+		C_SUB(tmpbuf[ncfft - k], fek, fok);
 #ifdef USE_SIMD
-		st->tmpbuf[ncfft - k].i *= _mm_set1_ps(-1.0);
+		tmpbuf[ncfft - k].i *= _mm_set1_ps(-1.0);
 #else
-		st->tmpbuf[ncfft - k].i *= -1;
+		tmpbuf[ncfft - k].i *= -1;
 #endif
 	}
-	kiss_fft(st->substate, st->tmpbuf, (kiss_fft_cpx*)timedata);
+	kiss_fft(st->substate, tmpbuf, (kiss_fft_cpx*)timedata);
 }
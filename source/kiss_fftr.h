@@ -52,6 +52,16 @@ extern "C"
 	 output timedata has nfft scalar points
 	*/
 
+	void kiss_fftri_buf(kiss_fftr_cfg cfg,
+	                    const kiss_fft_cpx* freqdata,
+	                    kiss_fft_scalar* timedata,
+	                    kiss_fft_cpx* tmpbuf);
+	/*
+	 same as kiss_fftri, but using the scratch buffer tmpbuf, which has nfft/2
+	 complex points, instead of the one stored in cfg. Thus the same cfg can
+	 be shared among several threads, as far as each one uses its own tmpbuf
+	*/
+
 #define kiss_fftr_free KISS_FFT_FREE
 
 #ifdef __cplusplus
@@ -0,0 +1,376 @@
+/*
+ * Copyright (c) 2022 Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file allocations.cpp
+ * Check that the time integration is not allocating heap memory once the
+ * simulation is running
+ */
+
+// Visual studio still uses this
+#define _USE_MATH_DEFINES
+
+#include "MoorDyn2.h"
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <filesystem>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <cerrno>
+
+namespace fs = std::filesystem;
+
+/// Number of heap allocations carried out so far
+static std::atomic<unsigned long> n_allocs(0);
+
+#ifdef __GLIBC__
+// Eigen allocates its dynamic matrices with malloc, so the C allocation
+// functions are hooked, which is also covering the operator new of libstdc++.
+// The calls from the MoorDyn library are resolved to these ones as well
+extern "C"
+{
+	void* __libc_malloc(std::size_t size);
+	void* __libc_calloc(std::size_t n, std::size_t size);
+	void* __libc_realloc(void* p, std::size_t size);
+	void* __libc_memalign(std::size_t alignment, std::size_t size);
+
+	void* malloc(std::size_t size)
+	{
+		n_allocs++;
+		return __libc_malloc(size);
+	}
+
+	void* calloc(std::size_t n, std::size_t size)
+	{
+		n_allocs++;
+		return __libc_calloc(n, size);
+	}
+
+	void* realloc(void* p, std::size_t size)
+	{
+		n_allocs++;
+		return __libc_realloc(p, size);
+	}
+
+	void* memalign(std::size_t alignment, std::size_t size)
+	{
+		n_allocs++;
+		return __libc_memalign(alignment, size);
+	}
+
+	void* aligned_alloc(std::size_t alignment, std::size_t size)
+	{
+		n_allocs++;
+		return __libc_memalign(alignment, size);
+	}
+
+	int posix_memalign(void** p, std::size_t alignment, std::size_t size)
+	{
+		n_allocs++;
+		*p = __libc_memalign(alignment, size);
+		return *p ? 0 : ENOMEM;
+	}
+}
+#else
+void*
+operator new(std::size_t size)
+{
+	n_allocs++;
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void*
+operator new[](std::size_t size)
+{
+	n_allocs++;
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void
+operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+	std::free(p);
+}
+#endif
+
+static std::vector<std::string> schemes({ "Euler",
+                                          "Heun",
+                                          "RK2",
+                                          "RK4",
+                                          "RK45",
+                                          "MultiRate",
+                                          "IMEX",
+                                          "AB2",
+                                          "AB3",
+                                          "AB4",
+                                          "BEuler2",
+                                          "Midpoint2" });
+
+using namespace std;
+
+std::string
+slurp(std::ifstream& in)
+{
+	std::ostringstream sstr;
+	sstr << in.rdbuf();
+	return sstr.str();
+}
+
+std::string
+ReplaceString(std::string subject,
+              const std::string& search,
+              const std::string& replace)
+{
+	size_t pos = 0;
+	while ((pos = subject.find(search, pos)) != std::string::npos) {
+		subject.replace(pos, search.length(), replace);
+		pos += replace.length();
+	}
+	return subject;
+}
+
+/** @brief Run some time steps, and check that no memory is allocated after
+ * the first one
+ * @param system The mooring system, already initialized
+ * @param x The coupled DOFs positions, NULL if there are not coupled DOFs
+ * @param dx The coupled DOFs velocities, NULL if there are not coupled DOFs
+ * @param f The coupled DOFs forces, NULL if there are not coupled DOFs
+ * @param dt The time step
+ * @return true if the test worked, false otherwise
+ */
+bool
+steady_steps(MoorDyn system, double* x, double* dx, double* f, double dt)
+{
+	int err;
+	double t = 0.0;
+	// The first time step might allocate some memory, e.g. on the streams
+	// buffers
+	err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring step: " << err << endl;
+		return false;
+	}
+
+	const unsigned long n_allocs_0 = n_allocs;
+	for (unsigned int i = 0; i < 10; i++) {
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+	}
+	const unsigned long n = n_allocs - n_allocs_0;
+	if (n) {
+		cerr << n << " heap allocations were carried out while stepping"
+		     << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Check that the time schemes are not allocating memory
+ * @param tscheme The time scheme
+ * @return true if the test worked, false otherwise
+ */
+bool
+time_scheme(std::string tscheme)
+{
+	cout << endl << " => " << tscheme << "..." << endl;
+
+	std::ifstream ifile("Mooring/time_schemes.txt");
+	std::string text = slurp(ifile);
+	ifile.close();
+	text = ReplaceString(text, "@TSCHEME@", tscheme);
+	text = ReplaceString(text, "@DT@", "1.0E-4");
+	std::stringstream filepath;
+	filepath << fs::temp_directory_path().string() << "/allocations_"
+	         << tscheme << ".txt";
+	std::ofstream ofile(filepath.str());
+	ofile << text;
+	ofile.close();
+
+	const unsigned long n_allocs_0 = n_allocs;
+	MoorDyn system = MoorDyn_Create(filepath.str().c_str());
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+	// Make sure that the allocations carried out by the library are tracked
+	if (n_allocs == n_allocs_0) {
+		cerr << "The heap allocations are not tracked" << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	int err = MoorDyn_Init(system, NULL, NULL);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	if (!steady_steps(system, NULL, NULL, NULL, 0.01)) {
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	MoorDyn_Close(system);
+	return true;
+}
+
+/** @brief Check that coupled lines are not allocating memory
+ * @param n_threads The number of threads
+ * @return true if the test worked, false otherwise
+ */
+bool
+coupled_lines(unsigned int n_threads = 1)
+{
+	cout << endl
+	     << " => " << __PRETTY_FUNC_NAME__ << " (" << n_threads
+	     << " threads)..." << endl;
+
+	MoorDyn system = MoorDyn_Create("Mooring/lines.txt");
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	int err = MoorDyn_SetThreads(system, n_threads);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure setting the number of threads: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+	double x[9], dx[9], f[9];
+	for (unsigned int i = 0; i < 3; i++) {
+		// 4 = first fairlead id
+		auto conn = MoorDyn_GetConnection(system, i + 4);
+		err = MoorDyn_GetConnectPos(conn, x + 3 * i);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure retrieving the fairlead " << i + 4
+			     << " position: " << err << endl;
+			MoorDyn_Close(system);
+			return false;
+		}
+	}
+	std::fill(dx, dx + 9, 0.0);
+	err = MoorDyn_Init(system, x, dx);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	if (!steady_steps(system, x, dx, f, 0.05)) {
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	MoorDyn_Close(system);
+	return true;
+}
+
+/** @brief Check that bodies and rods are not allocating memory
+ * @return true if the test worked, false otherwise
+ */
+bool
+bodies_and_rods()
+{
+	cout << endl << " => " << __PRETTY_FUNC_NAME__ << "..." << endl;
+
+	MoorDyn system = MoorDyn_Create("Mooring/BodiesAndRods.dat");
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	int err = MoorDyn_Init(system, NULL, NULL);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	if (!steady_steps(system, NULL, NULL, NULL, 0.05)) {
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	MoorDyn_Close(system);
+	return true;
+}
+
+/** @brief Runs all the test
+ * @return 0 if the tests have ran just fine. The index of the failing test
+ * otherwise
+ */
+int
+main(int, char**)
+{
+	for (auto tscheme : schemes) {
+		if (!time_scheme(tscheme))
+			return 1;
+	}
+	if (!coupled_lines())
+		return 2;
+	if (!bodies_and_rods())
+		return 3;
+	if (!coupled_lines(3))
+		return 4;
+	return 0;
+}
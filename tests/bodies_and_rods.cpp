@@ -33,6 +33,10 @@
  * A simple driver program that will run MoorDyn VERSION 2 without any platform
  * motion. It includes bodies and rods
  */
+#ifndef WIN32
+// Until we check the C++ API in Windows
+#include "MoorDyn2.hpp"
+#endif
 #include "MoorDyn2.h"
 #include <iostream>
 #include <algorithm>
@@ -86,6 +90,51 @@ main(int, char**)
 		}
 	}
 
+#ifndef WIN32
+	// Each object shall have its forces and masses computed once per time
+	// derivatives evaluation, no matter how many others are depending on it
+	moordyn::MoorDyn* md = (moordyn::MoorDyn*)system;
+	const unsigned long n0 = md->GetTimeScheme()->GetDerivEvals();
+	vector<unsigned long> c0, r0, b0;
+	for (auto obj : md->GetConnections())
+		c0.push_back(obj->getRHSCount());
+	for (auto obj : md->GetRods())
+		r0.push_back(obj->getRHSCount());
+	for (auto obj : md->GetBodies())
+		b0.push_back(obj->getRHSCount());
+	double t = nts * dt;
+	err = MoorDyn_Step(system, NULL, NULL, NULL, &t, &dt);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring step " << nts << ": " << err
+		     << endl;
+		MoorDyn_Close(system);
+		return 4;
+	}
+	const unsigned long n = md->GetTimeScheme()->GetDerivEvals() - n0;
+	auto check = [n](unsigned long n_obj, const char* name, unsigned int i) {
+		if (n_obj && (n_obj != n)) {
+			cerr << name << " " << i + 1 << " was evaluated " << n_obj
+			     << " times along " << n << " time derivatives evaluations"
+			     << endl;
+			return false;
+		}
+		return true;
+	};
+	bool ok = n != 0;
+	for (unsigned int i = 0; i < c0.size(); i++)
+		ok &= check(md->GetConnections()[i]->getRHSCount() - c0[i],
+		            "Point",
+		            i);
+	for (unsigned int i = 0; i < r0.size(); i++)
+		ok &= check(md->GetRods()[i]->getRHSCount() - r0[i], "Rod", i);
+	for (unsigned int i = 0; i < b0.size(); i++)
+		ok &= check(md->GetBodies()[i]->getRHSCount() - b0[i], "Body", i);
+	if (!ok) {
+		MoorDyn_Close(system);
+		return 5;
+	}
+#endif
+
 	err = MoorDyn_Close(system);
 	if (err != MOORDYN_SUCCESS) {
 		cerr << "Failure closing Moordyn: " << err << endl;
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2022 Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file line_kernels.cpp
+ * Tests on the lines state derivatives kernels specialized for each set of
+ * features, see moordyn::line_features
+ */
+
+#ifndef WIN32
+// Until we check the C++ API in Windows
+#include "MoorDyn2.hpp"
+#endif
+#include "MoorDyn2.h"
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+#ifdef WIN32
+// Until we check the C++ API in Windows
+bool
+kernels(const char*, unsigned int, const double*)
+{
+	return true;
+}
+
+bool
+uniform_curve()
+{
+	return true;
+}
+#else
+
+/// The features that are not related with the water kinematics
+#define LINE_MATERIAL                                                          \
+	(moordyn::LINE_NONLINEAR_EA | moordyn::LINE_NONLINEAR_C |                  \
+	 moordyn::LINE_BENDING)
+/// The features related with the water kinematics
+#define LINE_WATER (moordyn::LINE_WAVES_EXTERNAL | moordyn::LINE_WAVES_GRID)
+
+/** @brief Check that the specialized kernels produce the same results than
+ * the generic one
+ *
+ * The kernels of nonlinear stiffness, nonlinear damping and bending shall
+ * produce the very same results on lines lacking such features, so every
+ * kernel considering at least the line features is checked
+ * @param line The line
+ * @param n_kernels The number of checked kernels, which is incremented
+ * @return true if the test worked, false otherwise
+ */
+bool
+check_line(moordyn::Line* line, unsigned int& n_kernels)
+{
+	const unsigned int n = line->getN() - 1;
+	const unsigned int features = line->getFeatures();
+	moordyn::vec3N vel0(3, n), acc0(3, n), vel(3, n), acc(3, n);
+	moordyn::DLineStateDt d0(Eigen::Map<moordyn::vec3N>(vel0.data(), 3, n),
+	                         Eigen::Map<moordyn::vec3N>(acc0.data(), 3, n));
+	moordyn::DLineStateDt d(Eigen::Map<moordyn::vec3N>(vel.data(), 3, n),
+	                        Eigen::Map<moordyn::vec3N>(acc.data(), 3, n));
+	line->getStateDeriv(d0, moordyn::LINE_GENERIC);
+	if (!acc0.allFinite() || (acc0.cwiseAbs().maxCoeff() == 0.0)) {
+		cerr << "Line " << line->number << " got invalid accelerations"
+		     << endl;
+		return false;
+	}
+
+	for (unsigned int f = 0; f < moordyn::LINE_GENERIC; f++) {
+		if ((f & LINE_WATER) != (features & LINE_WATER))
+			continue;
+		if ((f & LINE_MATERIAL & features) != (features & LINE_MATERIAL))
+			continue;
+		line->getStateDeriv(d, f);
+		n_kernels++;
+		if ((vel != vel0) || (acc != acc0)) {
+			cerr << "Line " << line->number << " kernel " << f
+			     << " differs from the generic one by "
+			     << (acc - acc0).cwiseAbs().maxCoeff() << endl;
+			return false;
+		}
+	}
+	// The bound kernel
+	line->getStateDeriv(d);
+	if ((vel != vel0) || (acc != acc0)) {
+		cerr << "Line " << line->number << " bound kernel (" << features
+		     << ") differs from the generic one" << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Run a mooring system and check the lines kernels
+ * @param filepath The input file
+ * @param n_dof The number of coupled degrees of freedom
+ * @param x The coupled positions
+ * @return true if the test worked, false otherwise
+ */
+bool
+kernels(const char* filepath, unsigned int n_dof, const double* x)
+{
+	MoorDyn system = MoorDyn_Create(filepath);
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	std::vector<double> xd(n_dof, 0.0), f(n_dof);
+	int err = MoorDyn_Init(system, x, xd.data());
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	// Move the fairleads, so the lines are not at rest
+	std::vector<double> x1(x, x + n_dof);
+	for (unsigned int i = 0; i < n_dof; i += 3) {
+		xd[i] = 1.0;
+		x1[i] += 0.5;
+	}
+	double t = 0.0, dt = 0.5;
+	err = MoorDyn_Step(system, x1.data(), xd.data(), f.data(), &t, &dt);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring step: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	unsigned int n_kernels = 0;
+	for (auto line : ((moordyn::MoorDyn*)system)->GetLines()) {
+		if (!check_line(line, n_kernels)) {
+			MoorDyn_Close(system);
+			return false;
+		}
+	}
+	cout << n_kernels << " kernels checked on '" << filepath << "'" << endl;
+
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Check that moordyn::UniformCurve matches moordyn::interp()
+ *
+ * The table shall not depart from the curve more than the error returned by
+ * moordyn::UniformCurve::resample(), and the end values shall be returned
+ * out of the curve range. interp() returns the end value all along the last
+ * interval of the curve, so the exact linear blend is considered there
+ * @return true if the test worked, false otherwise
+ */
+bool
+uniform_curve()
+{
+	// The nonlinear EA curve of Mooring/poly_ea.txt
+	const vector<moordyn::real> xp = { 0.0, 0.001, 0.005, 0.01, 0.05 };
+	const vector<moordyn::real> yp = { 0.0, 2.0e5, 1.6e6, 3.6e6, 2.0e7 };
+	const unsigned int n_x = xp.size();
+	for (auto n : { 2u, 16u, 1024u }) {
+		moordyn::UniformCurve curve;
+		const moordyn::real err = curve.resample(xp, yp, n);
+		const moordyn::real tol = err + 1e-9 * yp.back();
+		const moordyn::real x0 = xp.front() - 0.01, x1 = xp.back() + 0.01;
+		const unsigned int n_eval = 10000;
+		for (unsigned int i = 0; i <= n_eval; i++) {
+			const moordyn::real x = x0 + i * (x1 - x0) / n_eval;
+			moordyn::real y = moordyn::interp(xp, yp, x);
+			if ((x > xp[n_x - 2]) && (x < xp[n_x - 1])) {
+				const moordyn::real f =
+				    (x - xp[n_x - 2]) / (xp[n_x - 1] - xp[n_x - 2]);
+				y = yp[n_x - 2] + f * (yp[n_x - 1] - yp[n_x - 2]);
+			}
+			if (std::abs(curve(x) - y) > tol) {
+				cerr << "The curve resampled on " << n << " points gives "
+				     << curve(x) << " at x = " << x << " instead of " << y
+				     << " (max. error = " << err << ")" << endl;
+				return false;
+			}
+		}
+		// Clamping out of the curve range
+		if ((curve(x0) != yp.front()) || (curve(x1) != yp.back())) {
+			cerr << "The curve resampled on " << n << " points is not "
+			     << "clamped out of its range" << endl;
+			return false;
+		}
+		cout << "Curve resampled on " << n << " points, max. error = "
+		     << err << endl;
+	}
+	return true;
+}
+#endif
+
+/** @brief Runs all the test
+ * @return 0 if the tests have ran just fine. The index of the failing test
+ * otherwise
+ */
+int
+main(int, char**)
+{
+	// Lines with and without bending and nonlinear stiffness, without waves
+	const double x_lines[12] = {
+		5.2, 0.0, -70.0, -2.6, 4.5, -70.0, -2.6, -4.5, -70.0, -5.2, 0.0, -70.0
+	};
+	if (!kernels("Mooring/line_kernels.txt", 12, x_lines))
+		return 1;
+	// Waves and currents from a grid, with seabed contact
+	const double x_waves[3] = { 0.0, 0.0, 0.0 };
+	if (!kernels("Mooring/wavekin_2/wavekin_2.txt", 3, x_waves))
+		return 2;
+	// The resampled nonlinear curves
+	if (!uniform_curve())
+		return 3;
+	return 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2022 Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file mass_solvers.cpp
+ * Tests on the mass matrices solver, moordyn::MassSolver. The former general
+ * purpose solver is benchmarked as well
+ */
+
+#include "Misc.hpp"
+#include <iostream>
+#include <chrono>
+
+using namespace moordyn;
+
+/// Number of solves of each benchmark
+#define N_SOLVES 200000
+
+/** @brief Relative error of a solution
+ * @param a The solution
+ * @param ref The reference solution
+ * @return The relative error
+ */
+template<typename T>
+moordyn::real
+rel_error(const T& a, const T& ref)
+{
+	return (a - ref).norm() / ref.norm();
+}
+
+/** @brief Report the time elapsed by a benchmark
+ * @param name The benchmark name
+ * @param t0 The benchmark starting time
+ */
+void
+report(const char* name, std::chrono::steady_clock::time_point t0)
+{
+	const auto t1 = std::chrono::steady_clock::now();
+	const double dt =
+	    std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+	std::cout << "  " << name << ": " << dt / N_SOLVES << " ns/solve"
+	          << std::endl;
+}
+
+/** @brief A random body-like mass matrix
+ *
+ * Large translational masses, and much larger rotational inertias
+ * @return The mass matrix
+ */
+mat6
+body_mass()
+{
+	const mat6 B = mat6::Random();
+	vec6 s;
+	s << 1e3, 1e3, 1e3, 1e5, 1e5, 1e5;
+	const mat6 A = s.asDiagonal() * B;
+	const mat6 D = s.cwiseProduct(s).asDiagonal();
+	return A * A.transpose() + D;
+}
+
+/** @brief Test the LDLT solver against the former QR one, and the reuse
+ * of the factorization
+ * @return true if the test worked, false otherwise
+ */
+bool
+mass6()
+{
+	std::srand(13);
+	MassSolver<6> solver;
+	const mat6 M = body_mass();
+	const vec6 f = vec6::Random() * 1e6;
+	const vec6 ref = Eigen::ColPivHouseholderQR<mat6>(M).solve(f);
+
+	vec6 a = solver.solve(M, f, 0.0);
+	if (rel_error(a, ref) > 1e-10) {
+		std::cerr << "LDLT error " << rel_error(a, ref) << std::endl;
+		return false;
+	}
+
+	// A small change of the matrix reuses the factorization, with a
+	// second order error
+	const moordyn::real tol = 1e-4;
+	mat6 dM = 0.5 * tol * (mat6::Random() + mat6::Random().transpose());
+	dM = dM.cwiseProduct(M.diagonal().cwiseSqrt() *
+	                     M.diagonal().cwiseSqrt().transpose());
+	const mat6 M2 = M + dM;
+	const vec6 ref2 = Eigen::ColPivHouseholderQR<mat6>(M2).solve(f);
+	a = solver.solve(M2, f, tol);
+	if (solver.factorizations() != 1) {
+		std::cerr << "The factorization has not been reused" << std::endl;
+		return false;
+	}
+	if (rel_error(a, ref2) > 1e-6) {
+		std::cerr << "Refined LDLT error " << rel_error(a, ref2) << std::endl;
+		return false;
+	}
+
+	// A large change is factorized again
+	a = solver.solve(2.0 * M, f, tol);
+	if (solver.factorizations() != 2) {
+		std::cerr << "The factorization has not been updated" << std::endl;
+		return false;
+	}
+	const vec6 ref3 = 0.5 * ref;
+	if (rel_error(a, ref3) > 1e-10) {
+		std::cerr << "Updated LDLT error " << rel_error(a, ref3) << std::endl;
+		return false;
+	}
+
+	std::cout << "6x6 mass matrices:" << std::endl;
+	std::vector<mat6> Ms(16);
+	for (unsigned int i = 0; i < Ms.size(); i++)
+		Ms[i] = M + 1e-6 * i * M.diagonal().asDiagonal().toDenseMatrix();
+	vec6 acc = vec6::Zero();
+	auto t0 = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < N_SOLVES; i++)
+		acc += Eigen::ColPivHouseholderQR<mat6>(Ms[i % Ms.size()]).solve(f);
+	report("ColPivHouseholderQR", t0);
+	t0 = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < N_SOLVES; i++)
+		acc += Eigen::LDLT<mat6>(Ms[i % Ms.size()]).solve(f);
+	report("LDLT", t0);
+	MassSolver<6> cached;
+	t0 = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < N_SOLVES; i++)
+		acc += cached.solve(Ms[i % Ms.size()], f, tol);
+	report("MassSolver", t0);
+	// Keep the compiler from optimizing the benchmarks out
+	if (!acc.allFinite())
+		return false;
+	return true;
+}
+
+/** @brief Runs all the test
+ * @return 0 if the tests have ran just fine. The index of the failing test
+ * otherwise
+ */
+int
+main(int, char**)
+{
+	if (!mass6())
+		return 1;
+	return 0;
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2022 Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file quasi_static_lines.cpp
+ * Tests on the quasi-static catenary lines, which are compared with the
+ * very same line solved with the lumped masses model
+ */
+
+#ifndef WIN32
+// Until we check the C++ API in Windows
+#include "MoorDyn2.hpp"
+#endif
+#include "MoorDyn2.h"
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+
+/// Static tension at the fairlead predicted by quasi-static codes
+const double STATIC_FAIR_TENSION = 2065.4e3;
+/// Allowed relative error with respect to the quasi-static codes
+const double MAX_STATIC_ERROR = 0.1;
+/// Allowed relative difference between the lumped masses and the
+/// quasi-static lines, with respect to the static tension
+const double MAX_ERROR = 0.02;
+/// Allowed distance between the lumped masses and the quasi-static nodes
+const double MAX_DIST = 1.0;
+/// Amplitude of the fairleads motion
+const double AMPLITUDE = 5.0;
+/// Period of the fairleads motion
+const double PERIOD = 100.0;
+
+/** @brief Relative difference between the forces of both fairleads
+ *
+ * The system is symmetric with respect to the x = 0 plane, so the x
+ * component of the quasi-static fairlead force is mirrored
+ * @param f The forces on both fairleads
+ * @return The relative difference, with respect to STATIC_FAIR_TENSION
+ */
+double
+fair_error(const double* f)
+{
+	const double dx = f[0] + f[3];
+	const double dy = f[1] - f[4];
+	const double dz = f[2] - f[5];
+	return sqrt(dx * dx + dy * dy + dz * dz) / STATIC_FAIR_TENSION;
+}
+
+/** @brief Check the static solution against the lumped masses line
+ * @param system The mooring system
+ * @return true if the test worked, false otherwise
+ */
+bool
+statics(MoorDyn system)
+{
+	MoorDynLine lm = MoorDyn_GetLine(system, 1);
+	MoorDynLine qs = MoorDyn_GetLine(system, 2);
+	unsigned int n;
+	if (!lm || !qs || (MoorDyn_GetLineN(qs, &n) != MOORDYN_SUCCESS)) {
+		cerr << "Failure getting the lines" << endl;
+		return false;
+	}
+
+	// The quasi-static line goes from the fairlead to the anchor
+	double f[6];
+	for (unsigned int i = 0; i < 2; i++) {
+		MoorDynConnection conn = MoorDyn_GetConnection(system, 3 + i);
+		if (!conn || (MoorDyn_GetConnectForce(conn, f + 3 * i) !=
+		              MOORDYN_SUCCESS)) {
+			cerr << "Failure getting the fairlead forces" << endl;
+			return false;
+		}
+	}
+	const double ften = sqrt(f[3] * f[3] + f[4] * f[4] + f[5] * f[5]);
+	cout << "Static tension on the quasi-static fairlead = " << ften << endl;
+	if (fabs(ften - STATIC_FAIR_TENSION) >
+	    MAX_STATIC_ERROR * STATIC_FAIR_TENSION) {
+		cerr << "Too large error with respect to " << STATIC_FAIR_TENSION
+		     << endl;
+		return false;
+	}
+	double err = fair_error(f);
+	cout << "Static fairlead force difference = " << err << endl;
+	if (err > MAX_ERROR) {
+		cerr << "Too large difference with the lumped masses line" << endl;
+		return false;
+	}
+
+	double dist = 0.0;
+	for (unsigned int i = 0; i <= n; i++) {
+		double r_lm[3], r_qs[3];
+		if ((MoorDyn_GetLineNodePos(lm, i, r_lm) != MOORDYN_SUCCESS) ||
+		    (MoorDyn_GetLineNodePos(qs, n - i, r_qs) != MOORDYN_SUCCESS)) {
+			cerr << "Failure getting the node positions" << endl;
+			return false;
+		}
+		const double dx = r_lm[0] + r_qs[0];
+		const double dy = r_lm[1] - r_qs[1];
+		const double dz = r_lm[2] - r_qs[2];
+		dist = std::max(dist, sqrt(dx * dx + dy * dy + dz * dz));
+	}
+	cout << "Static nodes maximum distance = " << dist << endl;
+	if (dist > MAX_DIST) {
+		cerr << "Too large distance with the lumped masses line" << endl;
+		return false;
+	}
+
+#ifndef WIN32
+	// The quasi-static line is not limiting the time step
+	moordyn::MoorDyn* md = (moordyn::MoorDyn*)system;
+	moordyn::TimeScheme* t_scheme = md->GetTimeScheme();
+	auto lines = md->GetLines();
+	if (lines[0]->isQuasiStatic() || !lines[1]->isQuasiStatic()) {
+		cerr << "Wrong quasi-static flags" << endl;
+		return false;
+	}
+	if (!std::isinf(t_scheme->GetStableTimeStep(lines[1]))) {
+		cerr << "The quasi-static line has a finite stable time step" << endl;
+		return false;
+	}
+#endif
+	return true;
+}
+
+/** @brief Move the fairleads slowly, and check the quasi-static line
+ * against the lumped masses one
+ *
+ * The motion starts at rest, so the lumped masses line is not excited
+ * @param system The mooring system
+ * @return true if the test worked, false otherwise
+ */
+bool
+dynamics(MoorDyn system)
+{
+	const double w = 2.0 * M_PI / PERIOD;
+	double x[6], dx[6], f[6];
+	std::fill(x, x + 6, 0.0);
+	std::fill(dx, dx + 6, 0.0);
+	double t = 0.0, dt = 0.5, err = 0.0;
+	while (t < 0.5 * PERIOD) {
+		x[0] = AMPLITUDE * (1.0 - cos(w * (t + dt)));
+		dx[0] = AMPLITUDE * w * sin(w * (t + dt));
+		x[3] = -x[0];
+		dx[3] = -dx[0];
+		const int status = MoorDyn_Step(system, x, dx, f, &t, &dt);
+		if (status != MOORDYN_SUCCESS) {
+			cerr << "Failure during the mooring step: " << status << endl;
+			return false;
+		}
+		err = std::max(err, fair_error(f));
+	}
+	cout << "Dynamic fairlead force difference = " << err << endl;
+	if (err > MAX_ERROR) {
+		cerr << "Too large difference with the lumped masses line" << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Runs all the test
+ * @return 0 if the tests have ran just fine. The index of the failing test
+ * otherwise
+ */
+int
+main(int, char**)
+{
+	MoorDyn system = MoorDyn_Create("Mooring/quasi_static_lines.txt");
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return 1;
+	}
+	double x[6], dx[6];
+	std::fill(x, x + 6, 0.0);
+	std::fill(dx, dx + 6, 0.0);
+	int err = MoorDyn_Init(system, x, dx);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		MoorDyn_Close(system);
+		return 1;
+	}
+	if (!statics(system)) {
+		MoorDyn_Close(system);
+		return 2;
+	}
+	if (!dynamics(system)) {
+		MoorDyn_Close(system);
+		return 3;
+	}
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return 4;
+	}
+	return 0;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022 Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file statics.cpp
+ * Check that the static solver and the kinetic damping find the same initial
+ * condition than the dynamic relaxation
+ */
+
+#include "MoorDyn2.h"
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <filesystem>
+#include <chrono>
+#include <cmath>
+
+namespace fs = std::filesystem;
+
+using namespace std;
+
+/// List of available depths
+vector<string> DEPTHS({ "0050", "0200", "0600" });
+/// Allowed relative difference in the static tensions
+const double MAX_ERROR = 0.005;
+
+/** @brief Compute the initial condition and get the line end tensions
+ * @param filepath The input file
+ * @param tens The output fairlead and anchor tensions
+ * @return true if the initialization worked, false otherwise
+ */
+bool
+initialize(const char* filepath, double* tens)
+{
+	MoorDyn system = MoorDyn_Create(filepath);
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	double x[3], dx[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	auto t0 = std::chrono::steady_clock::now();
+	int err = MoorDyn_Init(system, x, dx);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+	std::chrono::duration<double> elapsed =
+	    std::chrono::steady_clock::now() - t0;
+	cout << "    Initialization time = " << elapsed.count() << " s" << endl;
+
+	int num_lines = 1;
+	float fh, fv, ah, av;
+	err = MoorDyn_GetFASTtens(system, &num_lines, &fh, &fv, &ah, &av);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure getting the initial tension: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+	tens[0] = sqrt(fh * fh + fv * fv);
+	tens[1] = sqrt(ah * ah + av * av);
+	cout << "    Fairlead tension = " << tens[0] << endl;
+	cout << "    Anchor tension = " << tens[1] << endl;
+
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Generate a copy of a chain input file with another ICs method
+ * @param depth The water depth of the chain case
+ * @param method The method to compute the initial conditions
+ * @return The path of the generated file, empty if the input file cannot
+ * be parsed
+ */
+string
+set_method(const string& depth, const string& method)
+{
+	stringstream lines_file;
+	lines_file << "Mooring/WD" << depth << "_Chain.txt";
+	std::ifstream ifile(lines_file.str());
+	std::ostringstream sstr;
+	sstr << ifile.rdbuf();
+	ifile.close();
+	string text = sstr.str();
+	const string footer = "------------------------- need this line";
+	const size_t pos = text.rfind(footer);
+	if (pos == string::npos) {
+		cerr << "Cannot find the options footer in " << lines_file.str()
+		     << endl;
+		return "";
+	}
+	text.insert(pos, method + "    ICmethod\n");
+	stringstream filepath;
+	filepath << fs::temp_directory_path().string() << "/WD" << depth
+	         << "_Chain_" << method << ".txt";
+	std::ofstream ofile(filepath.str());
+	ofile << text;
+	ofile.close();
+	return filepath.str();
+}
+
+/** @brief Compare the static solver and the kinetic damping against the
+ * dynamic relaxation
+ * @param depth The water depth of the chain case
+ * @return true if the test worked, false otherwise
+ */
+bool
+compare(const string& depth)
+{
+	double relax[2];
+	cout << "WD" << depth << " dynamic relaxation:" << endl;
+	const string relax_file = set_method(depth, "relaxation");
+	if (relax_file.empty() || !initialize(relax_file.c_str(), relax))
+		return false;
+
+	for (auto method : { "newton", "kinetic" }) {
+		double tens[2];
+		cout << "WD" << depth << " " << method << ":" << endl;
+		const string filepath = set_method(depth, method);
+		if (filepath.empty() || !initialize(filepath.c_str(), tens))
+			return false;
+		for (unsigned int i = 0; i < 2; i++) {
+			const double e = fabs(tens[i] - relax[i]) / relax[i];
+			if (e > MAX_ERROR) {
+				cerr << "Too large difference between " << method
+				     << " and the dynamic relaxation: " << tens[i]
+				     << " vs. " << relax[i] << endl;
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/** @brief Runs all the test
+ * @return 0 if the tests have ran just fine. The index of the failing test
+ * otherwise
+ */
+int
+main(int, char**)
+{
+	for (unsigned int i = 0; i < DEPTHS.size(); i++) {
+		if (!compare(DEPTHS[i]))
+			return i + 1;
+	}
+	return 0;
+}
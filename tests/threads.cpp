@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022 Jose Luis Cercos-Pita <jlc@core-marine.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @file threads.cpp
+ * Check that the results do not depend on the number of threads
+ */
+
+// Visual studio still uses this
+#define _USE_MATH_DEFINES
+
+#include "MoorDyn2.h"
+#include <string>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/** @brief Run a simulation and collect the lines nodes positions
+ * @param filepath The input file
+ * @param n_threads The number of threads
+ * @param coupled true if the system has 3 coupled fairleads, with ids 4, 5
+ * and 6, false if there are not coupled DOFs
+ * @param pos The output nodes positions
+ * @return true if the simulation worked, false otherwise
+ */
+bool
+simulate(const char* filepath,
+         unsigned int n_threads,
+         bool coupled,
+         std::vector<double>& pos)
+{
+	MoorDyn system = MoorDyn_Create(filepath);
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	int err = MoorDyn_SetThreads(system, n_threads);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure setting the number of threads: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	double x[9], dx[9], f[9];
+	double *px = NULL, *pdx = NULL, *pf = NULL;
+	if (coupled) {
+		for (unsigned int i = 0; i < 3; i++) {
+			// 4 = first fairlead id
+			auto conn = MoorDyn_GetConnection(system, i + 4);
+			err = MoorDyn_GetConnectPos(conn, x + 3 * i);
+			if (err != MOORDYN_SUCCESS) {
+				cerr << "Failure retrieving the fairlead " << i + 4
+				     << " position: " << err << endl;
+				MoorDyn_Close(system);
+				return false;
+			}
+		}
+		std::fill(dx, dx + 9, 0.0);
+		px = x;
+		pdx = dx;
+		pf = f;
+	}
+	err = MoorDyn_Init(system, px, pdx);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+
+	double t = 0.0, dt = 0.05;
+	for (unsigned int i = 0; i < 10; i++) {
+		if (coupled)
+			x[0] += 0.1 * dt;
+		err = MoorDyn_Step(system, px, pdx, pf, &t, &dt);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure during the mooring step: " << err << endl;
+			MoorDyn_Close(system);
+			return false;
+		}
+	}
+
+	pos.clear();
+	unsigned int n_lines;
+	err = MoorDyn_GetNumberLines(system, &n_lines);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure getting the number of lines: " << err << endl;
+		MoorDyn_Close(system);
+		return false;
+	}
+	for (unsigned int i = 1; i <= n_lines; i++) {
+		auto line = MoorDyn_GetLine(system, i);
+		unsigned int n_nodes;
+		err = MoorDyn_GetLineNumberNodes(line, &n_nodes);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure getting the number of nodes: " << err << endl;
+			MoorDyn_Close(system);
+			return false;
+		}
+		for (unsigned int j = 0; j < n_nodes; j++) {
+			double r[3];
+			err = MoorDyn_GetLineNodePos(line, j, r);
+			if (err != MOORDYN_SUCCESS) {
+				cerr << "Failure getting the node position: " << err << endl;
+				MoorDyn_Close(system);
+				return false;
+			}
+			pos.insert(pos.end(), r, r + 3);
+		}
+	}
+
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return false;
+	}
+	return true;
+}
+
+/** @brief Check that several threads are rendering the very same results
+ * than a single one
+ * @param filepath The input file
+ * @param coupled true if the system has 3 coupled fairleads, with ids 4, 5
+ * and 6, false if there are not coupled DOFs
+ * @return true if the test worked, false otherwise
+ */
+bool
+compare(const char* filepath, bool coupled)
+{
+	cout << endl << " => " << filepath << "..." << endl;
+
+	std::vector<double> ref, pos;
+	if (!simulate(filepath, 1, coupled, ref))
+		return false;
+	for (unsigned int n_threads : { 3, 0 }) {
+		if (!simulate(filepath, n_threads, coupled, pos))
+			return false;
+		if (pos != ref) {
+			cerr << "The results with " << n_threads
+			     << " threads are not the same than with a single thread"
+			     << endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+/** @brief Runs all the test
+ * @return 0 if the tests have ran just fine. The index of the failing test
+ * otherwise
+ */
+int
+main(int, char**)
+{
+	if (!compare("Mooring/lines.txt", true))
+		return 1;
+	if (!compare("Mooring/BodiesAndRods.dat", false))
+		return 2;
+	return 0;
+}
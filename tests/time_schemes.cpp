@@ -47,6 +47,7 @@
 #include <vector>
 #include <filesystem>
 #include <chrono>
+#include <cmath>
 
 namespace fs = std::filesystem;
 
@@ -54,6 +55,9 @@ static std::vector<std::string> schemes({ "Euler",
                                           "Heun",
                                           "RK2",
                                           "RK4",
+                                          "RK45",
+                                          "MultiRate",
+                                          "IMEX",
                                           "AB2",
                                           "AB3",
                                           "AB4",
@@ -69,6 +73,9 @@ static std::vector<std::string> dts({ "1.5E-4",
                                       "1.8E-4",
                                       "2.6E-4",
                                       "4.9E-4",
+                                      "1.0E-3",
+                                      "1.0E-3",
+                                      "3.0E-3",
                                       "1.7E-4",
                                       "1.7E-4",
                                       "1.7E-4",
@@ -167,6 +174,184 @@ pendulum(std::string tscheme, std::string dt)
 	return true;
 }
 
+/** @brief Check the stable time step estimation, and its automatic usage
+ * @return true if the test worked, false otherwise
+ */
+bool
+stable_dt()
+{
+	std::cout << "RK2, dt = auto" << std::endl;
+	std::cout << "================" << std::endl << std::endl;
+	std::ifstream ifile("Mooring/time_schemes.txt");
+	std::string text = slurp(ifile);
+	ifile.close();
+	text = ReplaceString(text, "@TSCHEME@", "RK2");
+	text = ReplaceString(text, "@DT@", "auto");
+	std::stringstream filepath;
+	filepath << fs::temp_directory_path().string() << "/auto.txt";
+	std::ofstream ofile(filepath.str());
+	ofile << text;
+	ofile.close();
+
+	MoorDyn system = MoorDyn_Create(filepath.str().c_str());
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	// The highest axial mode of the 5.025 m segments, with a wave celerity
+	// of sqrt(E / rho) = 11284 m/s, has a critical time step of 4.45e-4 s,
+	// which is halved for RK2
+	double dt;
+	int err = MoorDyn_GetStableTimeStep(system, &dt);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure estimating the stable time step: " << err << endl;
+		return false;
+	}
+	if (fabs(dt - 2.227e-4) > 1.0e-6) {
+		cerr << "A stable time step of 2.227e-4 s was expected, but " << dt
+		     << " s was estimated" << endl;
+		return false;
+	}
+
+	err = MoorDyn_Init(system, NULL, NULL);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		return false;
+	}
+
+	double t = 0.0, dt_val = 0.01;
+	while (t < 10.0) {
+		err = MoorDyn_Step(system, NULL, NULL, NULL, &t, &dt_val);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+	}
+
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Run the chain under regular waves
+ *
+ * Since the wave elevation is read from the same folder than the input file,
+ * the latter is written on the one of the template
+ * @param tscheme The time scheme
+ * @param dt The time step
+ * @param r0 The line nodes positions at the beginning of the simulation
+ * @param r The line nodes positions at the end of the simulation
+ * @return true if the simulation worked, false otherwise
+ */
+bool
+waves_run(std::string tscheme,
+          std::string dt,
+          std::vector<double>& r0,
+          std::vector<double>& r)
+{
+	std::cout << tscheme << ", dt = " << dt << " s, waves" << std::endl;
+	std::cout << "================" << std::endl << std::endl;
+	std::ifstream ifile("Mooring/wavekin_4/time_schemes.txt");
+	std::string text = slurp(ifile);
+	ifile.close();
+	text = ReplaceString(text, "@TSCHEME@", tscheme);
+	text = ReplaceString(text, "@DT@", dt);
+	std::stringstream filepath;
+	filepath << "Mooring/wavekin_4/" << tscheme << ".txt";
+	std::ofstream ofile(filepath.str());
+	ofile << text;
+	ofile.close();
+
+	MoorDyn system = MoorDyn_Create(filepath.str().c_str());
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	double x[3], dx[3], f[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	int err = MoorDyn_Init(system, x, dx);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		return false;
+	}
+
+	MoorDynLine line = MoorDyn_GetLine(system, 1);
+	unsigned int n;
+	err = MoorDyn_GetLineNumberNodes(line, &n);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure getting the number of nodes: " << err << endl;
+		return false;
+	}
+	r0.resize(3 * n);
+	r.resize(3 * n);
+	for (unsigned int i = 0; i < n; i++)
+		MoorDyn_GetLineNodePos(line, i, r0.data() + 3 * i);
+
+	double t = 0.0, dt_val = std::stod(dt);
+	while (t < 10.0) {
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt_val);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+	}
+	for (unsigned int i = 0; i < n; i++)
+		MoorDyn_GetLineNodePos(line, i, r.data() + 3 * i);
+
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Check the subcycling schemes under waves against RK2
+ *
+ * The lines are subcycled within time steps way larger than the RK2 one, so
+ * the waves shall be evaluated at each substep time. The lines are
+ * initialized before the waves are enabled, so oscillating currents are
+ * considered as well to make them query the waves kinematics. The chain
+ * starts from the static equilibrium, so no initial transient is compared
+ * @return true if the test worked, false otherwise
+ */
+bool
+waves()
+{
+	std::vector<double> r0, r_ref, r;
+	if (!waves_run("RK2", "1.0E-3", r0, r_ref))
+		return false;
+	double motion = 0.0;
+	for (unsigned int i = 0; i < r0.size(); i++)
+		motion = std::max(motion, fabs(r_ref[i] - r0[i]));
+
+	const std::vector<std::string> subcycled({ "MultiRate", "IMEX" });
+	for (auto tscheme : subcycled) {
+		if (!waves_run(tscheme, "0.5", r0, r))
+			return false;
+		double err = 0.0;
+		for (unsigned int i = 0; i < r0.size(); i++)
+			err = std::max(err, fabs(r[i] - r_ref[i]));
+		cout << tscheme << " error = " << err << " m (the waves move the "
+		     << "nodes up to " << motion << " m)" << endl;
+		if (err > 0.1 * motion) {
+			cerr << tscheme << " error under waves is " << err
+			     << " m, for a motion of " << motion << " m" << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /** @brief Runs all the test
  * @return 0 if the tests have ran just fine. The index of the failing test
  * otherwise
@@ -184,5 +369,9 @@ main(int, char**)
 		     << "*** " << schemes[i] << " = " << duration.count() << "s" << endl
 		     << endl;
 	}
+	if (!stable_dt())
+		return 2;
+	if (!waves())
+		return 3;
 	return 0;
 }
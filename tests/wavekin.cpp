@@ -36,6 +36,9 @@
 #include <string.h>
 #include <math.h>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
 #include <algorithm>
 
 using namespace std;
@@ -237,6 +240,473 @@ tabulated(const char* input_file)
 	return true;
 }
 
+/** @brief Checks the gridless spectral waves against the linear wave theory
+ *
+ * The wave elevation time series is a periodic regular wave,
+ * zeta = A cos(w t), so the kinematics are known analytically
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+spectral()
+{
+	const double pi = 3.14159265358979, A = 1.0, T = 10.0, h = 50.0;
+	const double g = 9.81, rho = 1025.0, w = 2.0 * pi / T;
+	const double k = WaveNumber(w, g, h);
+	const double tol = 1.e-6;
+
+	MoorDyn system = MoorDyn_Create("Mooring/wavekin_4/wavekin_4.txt");
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	double x[3], dx[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	int err = MoorDyn_Init(system, x, dx);
+	if (err != MOORDYN_SUCCESS) {
+		MoorDyn_Close(system);
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		return false;
+	}
+	MoorDynWaves waves = MoorDyn_GetWaves(system);
+
+	const double points[3][3] = { { 0.0, 0.0, -1.0 },
+		                          { -100.0, 1.0, -20.0 },
+		                          { 200.0, -5.0, -45.0 } };
+	const double t_max = 2.0;
+	double t = 0.0, dt = 0.25;
+	double f[3];
+	while (t < t_max) {
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+		if (err != MOORDYN_SUCCESS) {
+			MoorDyn_Close(system);
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+
+		for (unsigned int i = 0; i < 3; i++) {
+			const double* r = points[i];
+			double U[3], Ud[3], zeta, PDyn;
+			err = MoorDyn_GetWavesKin(waves, r[0], r[1], r[2], U, Ud, &zeta,
+			                          &PDyn);
+			if (err != MOORDYN_SUCCESS) {
+				MoorDyn_Close(system);
+				cerr << "Failure getting the wave kinematics: " << err
+				     << endl;
+				return false;
+			}
+
+			const double c = cos(w * t - k * r[0]), s = sin(w * t - k * r[0]);
+			const double ss = sinh(k * (r[2] + h)) / sinh(k * h);
+			const double cs = cosh(k * (r[2] + h)) / sinh(k * h);
+			const double cc = cosh(k * (r[2] + h)) / cosh(k * h);
+			const double ref[8] = { A * c,
+				                    rho * g * A * cc * c,
+				                    A * w * cs * c,
+				                    0.0,
+				                    -A * w * ss * s,
+				                    -A * w * w * cs * s,
+				                    0.0,
+				                    -A * w * w * ss * c };
+			const double val[8] = { zeta,  PDyn,  U[0],  U[1],
+				                    U[2],  Ud[0], Ud[1], Ud[2] };
+			const double aw = A * w, aww = A * w * w;
+			const double scale[8] = { A,  rho * g * A, aw,  aw,
+				                      aw, aww,         aww, aww };
+			for (unsigned int j = 0; j < 8; j++) {
+				if (fabs(val[j] - ref[j]) > tol * scale[j]) {
+					cerr << "Wave kinematics field " << j << " at t = " << t
+					     << " s, point " << i << ", is " << val[j]
+					     << " instead of " << ref[j] << endl;
+					MoorDyn_Close(system);
+					return false;
+				}
+			}
+		}
+	}
+
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Checks the reduced precision waves grids against the full one
+ *
+ * The same waves grid is stored with each precision, and then the kinematics
+ * are compared on several points not matching the grid ones
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+precision()
+{
+	const double pi = 3.14159265358979, A = 1.0, T = 10.0;
+	const double g = 9.81, rho = 1025.0, w = 2.0 * pi / T;
+	// Single precision rounding, and 16 bits quantization relative to the
+	// largest value of each field at each grid point
+	const double tol[3] = { 0.0, 1.e-6, 5.e-5 };
+
+	MoorDyn systems[3];
+	MoorDynWaves waves[3];
+	double x[3], dx[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	for (unsigned int i = 0; i < 3; i++) {
+		const string input_file =
+		    "Mooring/wavekin_5/wavekin_5_" + to_string(i) + ".txt";
+		systems[i] = MoorDyn_Create(input_file.c_str());
+		if (!systems[i]) {
+			cerr << "Failure Creating the Mooring system" << endl;
+			return false;
+		}
+		int err = MoorDyn_Init(systems[i], x, dx);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure during the mooring initialization: " << err
+			     << endl;
+			return false;
+		}
+		waves[i] = MoorDyn_GetWaves(systems[i]);
+	}
+
+	const double points[3][3] = { { 0.0, 0.0, -1.0 },
+		                          { -52.5, 1.0, -20.5 },
+		                          { 73.1, -2.7, -43.3 } };
+	const double aw = A * w, aww = A * w * w;
+	const double scale[8] = { A, rho * g * A, aw, aw, aw, aww, aww, aww };
+	const double t_max = 2.0;
+	double t = 0.0, dt = 0.25;
+	double f[3];
+	while (t < t_max) {
+		for (unsigned int i = 0; i < 3; i++) {
+			double ti = t, dti = dt;
+			int err = MoorDyn_Step(systems[i], x, dx, f, &ti, &dti);
+			if (err != MOORDYN_SUCCESS) {
+				cerr << "Failure during the mooring step: " << err << endl;
+				return false;
+			}
+		}
+		t += dt;
+
+		for (unsigned int j = 0; j < 3; j++) {
+			const double* r = points[j];
+			double val[3][8];
+			for (unsigned int i = 0; i < 3; i++) {
+				int err = MoorDyn_GetWavesKin(waves[i],
+				                              r[0],
+				                              r[1],
+				                              r[2],
+				                              val[i] + 2,
+				                              val[i] + 5,
+				                              val[i],
+				                              val[i] + 1);
+				if (err != MOORDYN_SUCCESS) {
+					cerr << "Failure getting the wave kinematics: " << err
+					     << endl;
+					return false;
+				}
+			}
+			for (unsigned int i = 1; i < 3; i++) {
+				for (unsigned int k = 0; k < 8; k++) {
+					if (fabs(val[i][k] - val[0][k]) > tol[i] * scale[k]) {
+						cerr << "Wave kinematics field " << k << " at t = "
+						     << t << " s, point " << j << ", is " << val[i][k]
+						     << " with the precision " << i << ", instead of "
+						     << val[0][k] << endl;
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	for (unsigned int i = 0; i < 3; i++) {
+		int err = MoorDyn_Close(systems[i]);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure closing Moordyn: " << err << endl;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/** @brief Checks that the waves grid cached on disk is the computed one
+ *
+ * The same waves grid is computed without cache, and then twice with cache,
+ * so the last one is mapped from the cache file written by the former one
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+cache()
+{
+	const char* input_files[3] = { "Mooring/wavekin_5/wavekin_5_2.txt",
+		                           "Mooring/wavekin_5/wavekin_5_cache.txt",
+		                           "Mooring/wavekin_5/wavekin_5_cache.txt" };
+	const double points[3][3] = { { 0.0, 0.0, -1.0 },
+		                          { -52.5, 1.0, -20.5 },
+		                          { 73.1, -2.7, -43.3 } };
+	double val[3][3][8];
+	for (unsigned int i = 0; i < 3; i++) {
+		MoorDyn system = MoorDyn_Create(input_files[i]);
+		if (!system) {
+			cerr << "Failure Creating the Mooring system" << endl;
+			return false;
+		}
+		double x[3], dx[3], f[3];
+		std::fill(x, x + 3, 0.0);
+		std::fill(dx, dx + 3, 0.0);
+		int err = MoorDyn_Init(system, x, dx);
+		if (err != MOORDYN_SUCCESS) {
+			MoorDyn_Close(system);
+			cerr << "Failure during the mooring initialization: " << err
+			     << endl;
+			return false;
+		}
+		double t = 0.0, dt = 0.75;
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+		if (err != MOORDYN_SUCCESS) {
+			MoorDyn_Close(system);
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+		MoorDynWaves waves = MoorDyn_GetWaves(system);
+		for (unsigned int j = 0; j < 3; j++) {
+			const double* r = points[j];
+			err = MoorDyn_GetWavesKin(waves,
+			                          r[0],
+			                          r[1],
+			                          r[2],
+			                          val[i][j] + 2,
+			                          val[i][j] + 5,
+			                          val[i][j],
+			                          val[i][j] + 1);
+			if (err != MOORDYN_SUCCESS) {
+				MoorDyn_Close(system);
+				cerr << "Failure getting the wave kinematics: " << err
+				     << endl;
+				return false;
+			}
+		}
+		err = MoorDyn_Close(system);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure closing Moordyn: " << err << endl;
+			return false;
+		}
+	}
+
+	// The last run shall have mapped the cache
+	ifstream log("Mooring/wavekin_5/wavekin_5_cache.log");
+	stringstream log_data;
+	log_data << log.rdbuf();
+	if (log_data.str().find("mapped from the cache") == string::npos) {
+		cerr << "The waves grid was not mapped from the cache" << endl;
+		return false;
+	}
+
+	for (unsigned int i = 1; i < 3; i++) {
+		for (unsigned int j = 0; j < 3; j++) {
+			for (unsigned int k = 0; k < 8; k++) {
+				if (val[i][j][k] != val[0][j][k]) {
+					cerr << "Wave kinematics field " << k << " at point " << j
+					     << " is " << val[i][j][k] << " on the run " << i
+					     << ", instead of " << val[0][j][k] << endl;
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+/** @brief Checks the streamed waves grid against the linear wave theory
+ *
+ * The 40 s long wave elevation time series of a regular wave is streamed
+ * along a longer simulation, so the windows wrap around several times. The
+ * grid is interpolated, so the error is bounded by the grid resolution
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+stream()
+{
+	const double pi = 3.14159265358979, A = 1.0, T = 10.0, h = 50.0;
+	const double g = 9.81, rho = 1025.0, w = 2.0 * pi / T;
+	const double k = WaveNumber(w, g, h);
+	const double tol = 2.e-2;
+
+	MoorDyn system = MoorDyn_Create("Mooring/wavekin_5/wavekin_5_stream.txt");
+	if (!system) {
+		cerr << "Failure Creating the Mooring system" << endl;
+		return false;
+	}
+
+	double x[3], dx[3];
+	std::fill(x, x + 3, 0.0);
+	std::fill(dx, dx + 3, 0.0);
+	int err = MoorDyn_Init(system, x, dx);
+	if (err != MOORDYN_SUCCESS) {
+		MoorDyn_Close(system);
+		cerr << "Failure during the mooring initialization: " << err << endl;
+		return false;
+	}
+	MoorDynWaves waves = MoorDyn_GetWaves(system);
+
+	const double points[3][3] = { { 0.0, 0.0, -1.0 },
+		                          { -52.5, 1.0, -20.5 },
+		                          { 73.1, -2.7, -43.3 } };
+	const double t_max = 60.0;
+	double t = 0.0, dt = 0.25;
+	double f[3];
+	while (t < t_max) {
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+		if (err != MOORDYN_SUCCESS) {
+			MoorDyn_Close(system);
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+
+		for (unsigned int i = 0; i < 3; i++) {
+			const double* r = points[i];
+			double U[3], Ud[3], zeta, PDyn;
+			err = MoorDyn_GetWavesKin(waves, r[0], r[1], r[2], U, Ud, &zeta,
+			                          &PDyn);
+			if (err != MOORDYN_SUCCESS) {
+				MoorDyn_Close(system);
+				cerr << "Failure getting the wave kinematics: " << err
+				     << endl;
+				return false;
+			}
+
+			const double c = cos(w * t - k * r[0]), s = sin(w * t - k * r[0]);
+			const double ss = sinh(k * (r[2] + h)) / sinh(k * h);
+			const double cs = cosh(k * (r[2] + h)) / sinh(k * h);
+			const double cc = cosh(k * (r[2] + h)) / cosh(k * h);
+			const double ref[8] = { A * c,
+				                    rho * g * A * cc * c,
+				                    A * w * cs * c,
+				                    0.0,
+				                    -A * w * ss * s,
+				                    -A * w * w * cs * s,
+				                    0.0,
+				                    -A * w * w * ss * c };
+			const double val[8] = { zeta,  PDyn,  U[0],  U[1],
+				                    U[2],  Ud[0], Ud[1], Ud[2] };
+			const double aw = A * w, aww = A * w * w;
+			const double scale[8] = { A,  rho * g * A, aw,  aw,
+				                      aw, aww,         aww, aww };
+			for (unsigned int j = 0; j < 8; j++) {
+				if (fabs(val[j] - ref[j]) > tol * scale[j]) {
+					cerr << "Wave kinematics field " << j << " at t = " << t
+					     << " s, point " << i << ", is " << val[j]
+					     << " instead of " << ref[j] << endl;
+					MoorDyn_Close(system);
+					return false;
+				}
+			}
+		}
+	}
+
+	err = MoorDyn_Close(system);
+	if (err != MOORDYN_SUCCESS) {
+		cerr << "Failure closing Moordyn: " << err << endl;
+		return false;
+	}
+
+	return true;
+}
+
+/** @brief Checks the waves grid fitted to the mooring
+ *
+ * The fitted grid shares some points with the one read from the file, where
+ * the kinematics shall be the same
+ * @return true if the test is passed, false if problems are detected
+ */
+bool
+fit()
+{
+	const char* input_files[2] = { "Mooring/wavekin_5/wavekin_5_0.txt",
+		                           "Mooring/wavekin_5/wavekin_5_fit.txt" };
+	const double points[4][3] = { { 0.0, 0.0, 0.0 },
+		                          { 50.0, 0.0, -50.0 },
+		                          { 100.0, 0.0, 0.0 },
+		                          { 95.0, 5.0, -50.0 } };
+	double val[2][4][8];
+	for (unsigned int i = 0; i < 2; i++) {
+		MoorDyn system = MoorDyn_Create(input_files[i]);
+		if (!system) {
+			cerr << "Failure Creating the Mooring system" << endl;
+			return false;
+		}
+		double x[3], dx[3], f[3];
+		std::fill(x, x + 3, 0.0);
+		std::fill(dx, dx + 3, 0.0);
+		int err = MoorDyn_Init(system, x, dx);
+		if (err != MOORDYN_SUCCESS) {
+			MoorDyn_Close(system);
+			cerr << "Failure during the mooring initialization: " << err
+			     << endl;
+			return false;
+		}
+		double t = 0.0, dt = 0.75;
+		err = MoorDyn_Step(system, x, dx, f, &t, &dt);
+		if (err != MOORDYN_SUCCESS) {
+			MoorDyn_Close(system);
+			cerr << "Failure during the mooring step: " << err << endl;
+			return false;
+		}
+		MoorDynWaves waves = MoorDyn_GetWaves(system);
+		for (unsigned int j = 0; j < 4; j++) {
+			const double* r = points[j];
+			err = MoorDyn_GetWavesKin(waves,
+			                          r[0],
+			                          r[1],
+			                          r[2],
+			                          val[i][j] + 2,
+			                          val[i][j] + 5,
+			                          val[i][j],
+			                          val[i][j] + 1);
+			if (err != MOORDYN_SUCCESS) {
+				MoorDyn_Close(system);
+				cerr << "Failure getting the wave kinematics: " << err
+				     << endl;
+				return false;
+			}
+		}
+		err = MoorDyn_Close(system);
+		if (err != MOORDYN_SUCCESS) {
+			cerr << "Failure closing Moordyn: " << err << endl;
+			return false;
+		}
+	}
+
+	ifstream log("Mooring/wavekin_5/wavekin_5_fit.log");
+	stringstream log_data;
+	log_data << log.rdbuf();
+	if (log_data.str().find("x = [-5, 405] m (83 points), y = [-5, 5] m "
+	                        "(3 points), z = [-50, 0] m (16 points)") ==
+	    string::npos) {
+		cerr << "The waves grid was not fitted to the mooring" << endl;
+		return false;
+	}
+
+	for (unsigned int j = 0; j < 4; j++) {
+		for (unsigned int k = 0; k < 8; k++) {
+			if (val[1][j][k] != val[0][j][k]) {
+				cerr << "Wave kinematics field " << k << " at point " << j
+				     << " is " << val[1][j][k] << " on the fitted grid, "
+				     << "instead of " << val[0][j][k] << endl;
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
 /** @brief Runs all the test
  * @return 0 if the tests have ran just fine, 1 otherwise
  */
@@ -251,6 +721,16 @@ main(int, char**)
 		return 2;
 	if (!tabulated("Mooring/wavekin_3/test_dynamic_currents.txt"))
 		return 2;
+	if (!spectral())
+		return 3;
+	if (!precision())
+		return 4;
+	if (!cache())
+		return 5;
+	if (!stream())
+		return 6;
+	if (!fit())
+		return 7;
 
 	return 0;
 }
@@ -145,6 +145,54 @@ set_verbosity(PyObject*, PyObject* args)
 	return PyLong_FromLong(MoorDyn_SetVerbosity(system, verbosity));
 }
 
+/** @brief Wrapper to MoorDyn_SetThreads() function
+ * @param args Python passed arguments
+ * @return 0 in case of success, an error code otherwise
+ */
+static PyObject*
+set_threads(PyObject*, PyObject* args)
+{
+	PyObject* capsule;
+	unsigned int n;
+
+	if (!PyArg_ParseTuple(args, "OI", &capsule, &n))
+		return NULL;
+
+	MoorDyn system =
+	    (MoorDyn)PyCapsule_GetPointer(capsule, moordyn_capsule_name);
+	if (!system)
+		return NULL;
+
+	return PyLong_FromLong(MoorDyn_SetThreads(system, n));
+}
+
+/** @brief Wrapper to MoorDyn_GetStableTimeStep() function
+ * @param args Python passed arguments
+ * @return The estimated stable time step
+ */
+static PyObject*
+get_stable_time_step(PyObject*, PyObject* args)
+{
+	PyObject* capsule;
+
+	if (!PyArg_ParseTuple(args, "O", &capsule))
+		return NULL;
+
+	MoorDyn system =
+	    (MoorDyn)PyCapsule_GetPointer(capsule, moordyn_capsule_name);
+	if (!system)
+		return NULL;
+
+	double dt;
+	const int err = MoorDyn_GetStableTimeStep(system, &dt);
+	if (err != 0) {
+		PyErr_SetString(PyExc_RuntimeError, "MoorDyn reported an error");
+		return NULL;
+	}
+
+	return PyFloat_FromDouble(dt);
+}
+
 /** @brief Wrapper to MoorDyn_SetLogFile() function
  * @param args Python passed arguments
  * @return 0 in case of success, an error code otherwise
@@ -1844,6 +1892,14 @@ static PyMethodDef moordyn_methods[] = {
 	  set_verbosity,
 	  METH_VARARGS,
 	  "Set the instance verbosity level" },
+	{ "set_threads",
+	  set_threads,
+	  METH_VARARGS,
+	  "Set the number of threads used to compute the lines" },
+	{ "get_stable_time_step",
+	  get_stable_time_step,
+	  METH_VARARGS,
+	  "Estimate the largest stable time step" },
 	{ "set_logfile",
 	  set_logfile,
 	  METH_VARARGS,
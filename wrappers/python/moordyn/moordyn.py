@@ -108,6 +108,36 @@ def SetVerbosity(instance, verbosity):
     return cmoordyn.set_verbosity(instance, verbosity)
 
 
+def SetThreads(instance, n):
+    """Set the number of threads used to compute the lines. The results do not
+    depend on the number of threads
+
+    Parameters:
+    instance (cmoordyn.MoorDyn): The MoorDyn instance
+    n (int): The number of threads. 1 to work in serial, 0 to use all the
+             available hardware threads
+
+    Returns:
+    int: 0 uppon success, an error code otherwise
+    """
+    import cmoordyn
+    return cmoordyn.set_threads(instance, n)
+
+
+def GetStableTimeStep(instance):
+    """Estimate the largest stable time step, considering the stability limit
+    of the chosen time scheme on each line and rod
+
+    Parameters:
+    instance (cmoordyn.MoorDyn): The MoorDyn instance
+
+    Returns:
+    float: The stable time step, infinity if no object is limiting it
+    """
+    import cmoordyn
+    return cmoordyn.get_stable_time_step(instance)
+
+
 def SetLogFile(instance, filepath):
     """Set the verbosity level of the MoorDyn instance
 